@@ -0,0 +1,792 @@
+#include "Pch.h"
+#include "HelloTriangleApplication.h"
+
+// Runs the renderer for a fixed number of warm-up and measured frames per
+// scenario and reports frame time percentiles and CPU time per frame phase.
+// Every combination of the listed scenario parameters is run in turn, each
+// on a freshly initialised application.
+//
+// With --golden and --baseline the benchmark doubles as a regression check:
+// the last frame of every scenario is compared with a stored golden image,
+// and counts that do not depend on the host's speed (device memory
+// allocations and blocks, render graph passes and barriers) with a stored
+// baseline. Frame times are only compared with --check-frame-times, they
+// are meaningless across machines. Any check beyond its threshold makes the
+// run exit with a failure; otherwise a missing reference makes it exit with
+// SKIPPED_EXIT_CODE.
+
+// What CTest counts as a skipped test, see SKIP_RETURN_CODE in CMakeLists.txt.
+constexpr int SKIPPED_EXIT_CODE { 77 };
+
+struct Scenario
+{
+	uint32_t triangleCount { 1 };
+	uint32_t instanceCount { 1 };
+	uint32_t framesInFlight { 2 };
+	std::optional<VkPresentModeKHR> presentMode;
+	bool gpuDrivenDraws { true };
+};
+
+struct BenchmarkSettings
+{
+	bool headless { false };
+	uint32_t warmupFrames { 100 };
+	uint32_t measuredFrames { 500 };
+	uint32_t recordingThreadCount { 0 };
+	Astr deviceSelector;
+
+	Avec<uint32_t> triangleCounts { 1 };
+	Avec<uint32_t> instanceCounts { 1 };
+	Avec<uint32_t> framesInFlight { 2 };
+	Avec<std::optional<VkPresentModeKHR>> presentModes { std::nullopt };
+	Avec<bool> gpuDrivenDraws { true };
+
+	Astr csvPath;
+
+	// Golden images, one PNG per scenario, and how far a frame may be off.
+	Astr goldenDirectory;
+	bool updateGolden { false };
+	uint32_t pixelTolerance { 2 };
+	double maxMismatchFraction { 0.001 };
+
+	// Baselines, whose counts may not grow at all. Frame times are recorded
+	// as well, and with checkFrameTimes the mean and p95 may exceed them by
+	// maxFrameTimeRegression; only meaningful on the machine that recorded
+	// them.
+	Astr baselinePath;
+	bool updateBaseline { false };
+	bool checkFrameTimes { false };
+	double maxFrameTimeRegression { 0.25 };
+};
+
+struct Baseline
+{
+	double meanMs { 0.0 };
+	double p95Ms { 0.0 };
+	uint32_t allocationCount { 0 };
+	uint32_t memoryBlockCount { 0 };
+	uint32_t passCount { 0 };
+	uint32_t barrierCount { 0 };
+};
+
+enum class CheckResult
+{
+	Passed,
+	Failed,
+	// The reference to check against has not been recorded.
+	Skipped
+};
+
+struct ScenarioResult
+{
+	Scenario scenario;
+
+	double meanMs { 0.0 };
+	double p50Ms { 0.0 };
+	double p95Ms { 0.0 };
+	double p99Ms { 0.0 };
+
+	Avec<std::pair<Astr, double>> cpuPhaseMeanMs;
+	Avec<std::pair<Astr, double>> gpuScopeMeanMs;
+
+	AllocatorStats allocatorStats;
+	RenderGraph::Stats renderGraphStats;
+
+	// Last frame as RGBA8, only read back when comparing with golden images.
+	Avec<uint8_t> finalFrame;
+	uint32_t frameWidth { 0 };
+	uint32_t frameHeight { 0 };
+};
+
+Avec<uint32_t> parseList(const Astr& value)
+{
+	Avec<uint32_t> values;
+	std::stringstream stream(value);
+	Astr item;
+
+	while (std::getline(stream, item, ','))
+	{
+		values.push_back(static_cast<uint32_t>(std::stoul(item)));
+	}
+
+	if (values.empty())
+	{
+		throw std::runtime_error("Empty list: " + value);
+	}
+
+	return values;
+}
+
+VkPresentModeKHR parsePresentMode(const Astr& name)
+{
+	if (name == "fifo")			return VK_PRESENT_MODE_FIFO_KHR;
+	if (name == "mailbox")		return VK_PRESENT_MODE_MAILBOX_KHR;
+	if (name == "immediate")	return VK_PRESENT_MODE_IMMEDIATE_KHR;
+	if (name == "relaxed")		return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+
+	throw std::runtime_error("Unknown present mode: " + name);
+}
+
+Astr presentModeName(const std::optional<VkPresentModeKHR>& presentMode)
+{
+	if (!presentMode.has_value())
+	{
+		return "default";
+	}
+
+	switch (*presentMode)
+	{
+	case VK_PRESENT_MODE_FIFO_KHR:			return "fifo";
+	case VK_PRESENT_MODE_MAILBOX_KHR:		return "mailbox";
+	case VK_PRESENT_MODE_IMMEDIATE_KHR:		return "immediate";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR:	return "relaxed";
+	default:								return "other";
+	}
+}
+
+// "gpu" culls in a compute pass and draws indirectly, "cpu" records every draw.
+bool parseDrawMode(const Astr& name)
+{
+	if (name == "gpu")	return true;
+	if (name == "cpu")	return false;
+
+	throw std::runtime_error("Unknown draw mode: " + name);
+}
+
+Astr drawModeName(bool gpuDrivenDraws)
+{
+	return gpuDrivenDraws ? "gpu" : "cpu";
+}
+
+// Golden image file name and baseline key.
+Astr scenarioName(const Scenario& scenario)
+{
+	std::ostringstream name;
+	name << "triangles" << scenario.triangleCount
+		<< "_instances" << scenario.instanceCount
+		<< "_fif" << scenario.framesInFlight
+		<< '_' << presentModeName(scenario.presentMode)
+		<< '_' << drawModeName(scenario.gpuDrivenDraws);
+	return name.str();
+}
+
+BenchmarkSettings parseSettings(int argc, char** argv)
+{
+	BenchmarkSettings settings;
+
+	for (int i = 1; i < argc; i++)
+	{
+		Astr arg = argv[i];
+
+		if (arg == "--headless")
+		{
+			settings.headless = true;
+		}
+		else if (arg == "--warmup" && i + 1 < argc)
+		{
+			settings.warmupFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+		}
+		else if (arg == "--frames" && i + 1 < argc)
+		{
+			settings.measuredFrames = std::max(static_cast<uint32_t>(std::stoul(argv[++i])), 1u);
+		}
+		else if (arg == "--threads" && i + 1 < argc)
+		{
+			settings.recordingThreadCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+		}
+		else if (arg == "--device" && i + 1 < argc)
+		{
+			settings.deviceSelector = argv[++i];
+		}
+		else if (arg == "--triangles" && i + 1 < argc)
+		{
+			settings.triangleCounts = parseList(argv[++i]);
+		}
+		else if (arg == "--instances" && i + 1 < argc)
+		{
+			settings.instanceCounts = parseList(argv[++i]);
+		}
+		else if (arg == "--frames-in-flight" && i + 1 < argc)
+		{
+			settings.framesInFlight = parseList(argv[++i]);
+		}
+		else if (arg == "--present-modes" && i + 1 < argc)
+		{
+			settings.presentModes.clear();
+
+			std::stringstream stream(argv[++i]);
+			Astr item;
+
+			while (std::getline(stream, item, ','))
+			{
+				settings.presentModes.push_back(parsePresentMode(item));
+			}
+		}
+		else if (arg == "--draw-modes" && i + 1 < argc)
+		{
+			settings.gpuDrivenDraws.clear();
+
+			std::stringstream stream(argv[++i]);
+			Astr item;
+
+			while (std::getline(stream, item, ','))
+			{
+				settings.gpuDrivenDraws.push_back(parseDrawMode(item));
+			}
+		}
+		else if (arg == "--csv" && i + 1 < argc)
+		{
+			settings.csvPath = argv[++i];
+		}
+		else if (arg == "--golden" && i + 1 < argc)
+		{
+			settings.goldenDirectory = argv[++i];
+		}
+		else if (arg == "--update-golden")
+		{
+			settings.updateGolden = true;
+		}
+		else if (arg == "--pixel-tolerance" && i + 1 < argc)
+		{
+			settings.pixelTolerance = static_cast<uint32_t>(std::stoul(argv[++i]));
+		}
+		else if (arg == "--max-mismatch" && i + 1 < argc)
+		{
+			settings.maxMismatchFraction = std::stod(argv[++i]);
+		}
+		else if (arg == "--baseline" && i + 1 < argc)
+		{
+			settings.baselinePath = argv[++i];
+		}
+		else if (arg == "--update-baseline")
+		{
+			settings.updateBaseline = true;
+		}
+		else if (arg == "--check-frame-times")
+		{
+			settings.checkFrameTimes = true;
+		}
+		else if (arg == "--max-regression" && i + 1 < argc)
+		{
+			settings.maxFrameTimeRegression = std::stod(argv[++i]);
+		}
+		else
+		{
+			throw std::runtime_error("Unknown argument: " + arg);
+		}
+	}
+
+	if (settings.headless)
+	{
+		// There is no presentation in headless mode.
+		settings.presentModes = { std::nullopt };
+	}
+
+	if (settings.updateGolden && settings.goldenDirectory.empty())
+	{
+		throw std::runtime_error("--update-golden needs --golden DIR.");
+	}
+
+	if (settings.updateBaseline && settings.baselinePath.empty())
+	{
+		throw std::runtime_error("--update-baseline needs --baseline FILE.");
+	}
+
+	return settings;
+}
+
+double percentile(const Avec<double>& sorted, double fraction)
+{
+	// Nearest rank.
+	size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+	return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+ScenarioResult runScenario(const BenchmarkSettings& benchmark, const Scenario& scenario)
+{
+	ApplicationSettings settings;
+	settings.headless = benchmark.headless;
+	settings.frameCount = benchmark.warmupFrames + benchmark.measuredFrames;
+	settings.framesInFlight = scenario.framesInFlight;
+	settings.triangleCount = scenario.triangleCount;
+	settings.instanceCount = scenario.instanceCount;
+	settings.presentMode = scenario.presentMode;
+	settings.gpuDrivenDraws = scenario.gpuDrivenDraws;
+	settings.recordingThreadCount = benchmark.recordingThreadCount;
+	settings.deviceSelector = benchmark.deviceSelector;
+	settings.enableProfiler = true;
+	settings.profileHistorySize = benchmark.measuredFrames;
+
+	ScenarioResult result;
+	result.scenario = scenario;
+
+	HelloTriangleApplication app(settings);
+
+	if (!benchmark.goldenDirectory.empty())
+	{
+		// Readback delivers frames in slot order, keep the newest one. Only
+		// the last frames are converted to leave the frame times alone.
+		uint64_t lastFrameNumber = settings.frameCount;
+		uint64_t keptFrameNumber = 0;
+
+		app.addFrameConsumer([&result, lastFrameNumber, keptFrameNumber](const FrameView& view) mutable
+		{
+			if (view.frameNumber + 1 < lastFrameNumber || view.frameNumber < keptFrameNumber)
+			{
+				return;
+			}
+
+			result.finalFrame = ImageEncoder::toRgba8(view.pixels, view.width, view.height, view.rowPitch, view.format);
+			result.frameWidth = view.width;
+			result.frameHeight = view.height;
+			keptFrameNumber = view.frameNumber;
+		});
+	}
+
+	app.run();
+
+	result.allocatorStats = app.getAllocatorStats();
+	result.renderGraphStats = app.getRenderGraphStats();
+
+	const Profiler& profiler = app.getProfiler();
+	auto history = profiler.getHistory();
+
+	if (history.empty())
+	{
+		throw std::runtime_error("Scenario did not render any frames.");
+	}
+
+	Avec<double> frameTimes;
+	frameTimes.reserve(history.size());
+
+	auto phaseNames = profiler.getPhaseNames();
+	auto gpuScopeNames = profiler.getGpuScopeNames();
+	Avec<double> phaseTotals(phaseNames.size(), 0.0);
+	Avec<double> gpuTotals(gpuScopeNames.size(), 0.0);
+	Avec<uint32_t> gpuSamples(gpuScopeNames.size(), 0);
+
+	for (const auto& record : history)
+	{
+		frameTimes.push_back(record.cpuFrameMs);
+
+		for (size_t i = 0; i < record.cpuPhaseMs.size() && i < phaseTotals.size(); i++)
+		{
+			phaseTotals[i] += record.cpuPhaseMs[i];
+		}
+
+		for (size_t i = 0; i < record.gpuScopeMs.size() && i < gpuTotals.size(); i++)
+		{
+			gpuTotals[i] += record.gpuScopeMs[i];
+			gpuSamples[i]++;
+		}
+	}
+
+	double count = static_cast<double>(frameTimes.size());
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+
+	for (double frameTime : frameTimes)
+	{
+		result.meanMs += frameTime / count;
+	}
+
+	result.p50Ms = percentile(frameTimes, 0.50);
+	result.p95Ms = percentile(frameTimes, 0.95);
+	result.p99Ms = percentile(frameTimes, 0.99);
+
+	for (size_t i = 0; i < phaseNames.size(); i++)
+	{
+		result.cpuPhaseMeanMs.emplace_back(phaseNames[i], phaseTotals[i] / count);
+	}
+
+	for (size_t i = 0; i < gpuScopeNames.size(); i++)
+	{
+		result.gpuScopeMeanMs.emplace_back(gpuScopeNames[i], gpuSamples[i] ? gpuTotals[i] / gpuSamples[i] : 0.0);
+	}
+
+	return result;
+}
+
+void printResult(const ScenarioResult& result)
+{
+	const Scenario& scenario = result.scenario;
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "triangles=" << scenario.triangleCount
+		<< " instances=" << scenario.instanceCount
+		<< " framesInFlight=" << scenario.framesInFlight
+		<< " presentMode=" << presentModeName(scenario.presentMode)
+		<< " draws=" << drawModeName(scenario.gpuDrivenDraws) << '\n';
+
+	std::cout << "  frame ms: mean " << result.meanMs
+		<< "  p50 " << result.p50Ms
+		<< "  p95 " << result.p95Ms
+		<< "  p99 " << result.p99Ms << '\n';
+
+	const AllocatorStats& stats = result.allocatorStats;
+	std::cout << "  memory: allocations " << stats.allocationCount
+		<< "  blocks " << stats.blockCount + stats.dedicatedAllocationCount
+		<< "  used " << stats.usedBytes / (1024.0 * 1024.0) << " / " << stats.reservedBytes / (1024.0 * 1024.0) << " MiB"
+		<< "  fragmentation " << stats.fragmentation << '\n';
+
+	std::cout << "  render graph: passes " << result.renderGraphStats.passCount
+		<< "  barriers " << result.renderGraphStats.barrierCount << '\n';
+
+	for (const auto& [name, ms] : result.cpuPhaseMeanMs)
+	{
+		std::cout << "  cpu " << std::left << std::setw(20) << name << std::right << ms << " ms\n";
+	}
+
+	for (const auto& [name, ms] : result.gpuScopeMeanMs)
+	{
+		std::cout << "  gpu " << std::left << std::setw(20) << name << std::right << ms << " ms\n";
+	}
+}
+
+void writeCsv(const Astr& path, const Avec<ScenarioResult>& results)
+{
+	std::ofstream file(path, std::ios::trunc);
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open CSV file for writing.");
+	}
+
+	file << "triangles,instances,frames_in_flight,present_mode,draw_mode,mean_ms,p50_ms,p95_ms,p99_ms,metric,metric_ms\n";
+	file << std::fixed << std::setprecision(4);
+
+	for (const auto& result : results)
+	{
+		const Scenario& scenario = result.scenario;
+
+		std::ostringstream prefix;
+		prefix << std::fixed << std::setprecision(4)
+			<< scenario.triangleCount << ',' << scenario.instanceCount << ',' << scenario.framesInFlight << ','
+			<< presentModeName(scenario.presentMode) << ',' << drawModeName(scenario.gpuDrivenDraws) << ','
+			<< result.meanMs << ',' << result.p50Ms << ',' << result.p95Ms << ',' << result.p99Ms;
+
+		// One row per metric keeps the columns fixed whatever phases exist.
+		for (const auto& [name, ms] : result.cpuPhaseMeanMs)
+		{
+			file << prefix.str() << ",cpu_" << name << ',' << ms << '\n';
+		}
+
+		for (const auto& [name, ms] : result.gpuScopeMeanMs)
+		{
+			file << prefix.str() << ",gpu_" << name << ',' << ms << '\n';
+		}
+	}
+}
+
+Amap<Astr, Baseline> readBaselines(const Astr& path)
+{
+	std::ifstream file(path);
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open baseline file: " + path);
+	}
+
+	Amap<Astr, Baseline> baselines;
+	Astr line;
+
+	// Header line.
+	std::getline(file, line);
+
+	while (std::getline(file, line))
+	{
+		if (line.empty())
+		{
+			continue;
+		}
+
+		std::stringstream stream(line);
+		Astr name, meanMs, p95Ms, allocations, blocks, passes, barriers;
+
+		if (!std::getline(stream, name, ',') || !std::getline(stream, meanMs, ',') || !std::getline(stream, p95Ms, ',') ||
+			!std::getline(stream, allocations, ',') || !std::getline(stream, blocks, ',') ||
+			!std::getline(stream, passes, ',') || !std::getline(stream, barriers, ','))
+		{
+			throw std::runtime_error("Malformed baseline line: " + line);
+		}
+
+		Baseline& baseline = baselines[name];
+		baseline.meanMs = std::stod(meanMs);
+		baseline.p95Ms = std::stod(p95Ms);
+		baseline.allocationCount = static_cast<uint32_t>(std::stoul(allocations));
+		baseline.memoryBlockCount = static_cast<uint32_t>(std::stoul(blocks));
+		baseline.passCount = static_cast<uint32_t>(std::stoul(passes));
+		baseline.barrierCount = static_cast<uint32_t>(std::stoul(barriers));
+	}
+
+	return baselines;
+}
+
+// Replaces the baselines of the given scenarios and keeps the others, so
+// scenarios can be recorded one at a time.
+void writeBaselines(const Astr& path, const Avec<ScenarioResult>& results)
+{
+	Amap<Astr, Baseline> baselines;
+
+	if (std::filesystem::exists(path))
+	{
+		baselines = readBaselines(path);
+	}
+
+	for (const auto& result : results)
+	{
+		const AllocatorStats& stats = result.allocatorStats;
+
+		Baseline& baseline = baselines[scenarioName(result.scenario)];
+		baseline.meanMs = result.meanMs;
+		baseline.p95Ms = result.p95Ms;
+		baseline.allocationCount = stats.allocationCount;
+		baseline.memoryBlockCount = stats.blockCount + stats.dedicatedAllocationCount;
+		baseline.passCount = result.renderGraphStats.passCount;
+		baseline.barrierCount = result.renderGraphStats.barrierCount;
+	}
+
+	std::ofstream file(path, std::ios::trunc);
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open baseline file for writing: " + path);
+	}
+
+	file << "scenario,mean_ms,p95_ms,allocations,memory_blocks,passes,barriers\n";
+	file << std::fixed << std::setprecision(4);
+
+	for (const auto& [name, baseline] : baselines)
+	{
+		file << name << ',' << baseline.meanMs << ',' << baseline.p95Ms << ','
+			<< baseline.allocationCount << ',' << baseline.memoryBlockCount << ','
+			<< baseline.passCount << ',' << baseline.barrierCount << '\n';
+	}
+}
+
+// Prints the outcome of one check and returns it.
+CheckResult report(const ScenarioResult& result, const Astr& check, CheckResult outcome, const Astr& detail)
+{
+	const char* label = outcome == CheckResult::Passed ? "PASS " : outcome == CheckResult::Failed ? "FAIL " : "SKIP ";
+	std::cout << label << scenarioName(result.scenario) << ' ' << check << ": " << detail << '\n';
+	return outcome;
+}
+
+CheckResult report(const ScenarioResult& result, const Astr& check, bool passed, const Astr& detail)
+{
+	return report(result, check, passed ? CheckResult::Passed : CheckResult::Failed, detail);
+}
+
+// Failed over skipped over passed.
+CheckResult combine(CheckResult a, CheckResult b)
+{
+	if (a == CheckResult::Failed || b == CheckResult::Failed)
+	{
+		return CheckResult::Failed;
+	}
+
+	return a == CheckResult::Skipped || b == CheckResult::Skipped ? CheckResult::Skipped : CheckResult::Passed;
+}
+
+CheckResult checkGolden(const BenchmarkSettings& settings, const ScenarioResult& result)
+{
+	if (result.finalFrame.empty())
+	{
+		return report(result, "golden", false, "no frame was read back");
+	}
+
+	std::filesystem::path path = std::filesystem::path(settings.goldenDirectory) / (scenarioName(result.scenario) + ".png");
+
+	if (settings.updateGolden)
+	{
+		std::filesystem::create_directories(settings.goldenDirectory);
+		ImageEncoder::write(path.string(), ImageFileFormat::Png, result.finalFrame.data(), result.frameWidth, result.frameHeight);
+		return report(result, "golden", true, "updated " + path.string());
+	}
+
+	if (!std::filesystem::exists(path))
+	{
+		return report(result, "golden", CheckResult::Skipped, "missing " + path.string() + ", record it with --update-golden");
+	}
+
+	uint32_t width, height;
+	Avec<uint8_t> golden = ImageEncoder::readPng(path.string(), width, height);
+
+	std::ostringstream detail;
+	bool passed;
+
+	if (width != result.frameWidth || height != result.frameHeight)
+	{
+		detail << "size " << result.frameWidth << 'x' << result.frameHeight << ", golden " << width << 'x' << height;
+		passed = false;
+	}
+	else
+	{
+		// A pixel mismatches when any channel is off by more than the
+		// tolerance, which absorbs rounding differences between drivers.
+		size_t pixelCount = static_cast<size_t>(width) * height;
+		size_t mismatched = 0;
+		uint32_t maxDifference = 0;
+
+		for (size_t i = 0; i < pixelCount; i++)
+		{
+			uint32_t difference = 0;
+
+			for (size_t channel = 0; channel < 4; channel++)
+			{
+				int value = result.finalFrame[i * 4 + channel];
+				int expected = golden[i * 4 + channel];
+				difference = std::max(difference, static_cast<uint32_t>(std::abs(value - expected)));
+			}
+
+			if (difference > settings.pixelTolerance)
+			{
+				mismatched++;
+			}
+
+			maxDifference = std::max(maxDifference, difference);
+		}
+
+		double fraction = static_cast<double>(mismatched) / static_cast<double>(pixelCount);
+		passed = fraction <= settings.maxMismatchFraction;
+
+		detail << mismatched << " of " << pixelCount << " pixels off by more than " << settings.pixelTolerance
+			<< ", largest difference " << maxDifference;
+	}
+
+	if (!passed)
+	{
+		// Next to the golden image, to diff the two.
+		std::filesystem::path actualPath = path;
+		actualPath.replace_extension(".actual.png");
+		ImageEncoder::write(actualPath.string(), ImageFileFormat::Png, result.finalFrame.data(), result.frameWidth, result.frameHeight);
+		detail << ", frame written to " << actualPath.string();
+	}
+
+	return report(result, "golden", passed, detail.str());
+}
+
+CheckResult checkBaseline(const BenchmarkSettings& settings, const Amap<Astr, Baseline>& baselines, const ScenarioResult& result)
+{
+	auto found = baselines.find(scenarioName(result.scenario));
+
+	if (found == baselines.end())
+	{
+		return report(result, "baseline", CheckResult::Skipped, "no baseline, record it with --update-baseline");
+	}
+
+	const Baseline& baseline = found->second;
+	const AllocatorStats& stats = result.allocatorStats;
+	double limit = 1.0 + settings.maxFrameTimeRegression;
+	CheckResult outcome = CheckResult::Passed;
+
+	auto frameTime = [&](const char* name, double ms, double baselineMs)
+	{
+		std::ostringstream detail;
+		detail << std::fixed << std::setprecision(3) << ms << " ms, baseline " << baselineMs << " ms, limit " << baselineMs * limit << " ms";
+		return report(result, name, ms <= baselineMs * limit, detail.str());
+	};
+
+	auto count = [&](const char* name, uint32_t value, uint32_t baselineValue)
+	{
+		return report(result, name, value <= baselineValue, std::to_string(value) + ", baseline " + std::to_string(baselineValue));
+	};
+
+	outcome = combine(outcome, count("allocations", stats.allocationCount, baseline.allocationCount));
+	outcome = combine(outcome, count("memory blocks", stats.blockCount + stats.dedicatedAllocationCount, baseline.memoryBlockCount));
+	outcome = combine(outcome, count("render graph passes", result.renderGraphStats.passCount, baseline.passCount));
+	outcome = combine(outcome, count("render graph barriers", result.renderGraphStats.barrierCount, baseline.barrierCount));
+
+	if (settings.checkFrameTimes)
+	{
+		outcome = combine(outcome, frameTime("mean frame time", result.meanMs, baseline.meanMs));
+		outcome = combine(outcome, frameTime("p95 frame time", result.p95Ms, baseline.p95Ms));
+	}
+
+	return outcome;
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkSettings settings;
+
+	try {
+		settings = parseSettings(argc, argv);
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	Avec<ScenarioResult> results;
+
+	try {
+		for (uint32_t triangleCount : settings.triangleCounts)
+		for (uint32_t instanceCount : settings.instanceCounts)
+		for (uint32_t framesInFlight : settings.framesInFlight)
+		for (const auto& presentMode : settings.presentModes)
+		for (bool gpuDrivenDraws : settings.gpuDrivenDraws)
+		{
+			Scenario scenario;
+			scenario.triangleCount = triangleCount;
+			scenario.instanceCount = instanceCount;
+			scenario.framesInFlight = std::max(framesInFlight, 1u);
+			scenario.presentMode = presentMode;
+			scenario.gpuDrivenDraws = gpuDrivenDraws;
+
+			results.push_back(runScenario(settings, scenario));
+			printResult(results.back());
+		}
+
+		if (!settings.csvPath.empty())
+		{
+			writeCsv(settings.csvPath, results);
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	CheckResult outcome = CheckResult::Passed;
+
+	try {
+		Amap<Astr, Baseline> baselines;
+
+		// Without the file every scenario has no baseline.
+		if (!settings.baselinePath.empty() && !settings.updateBaseline && std::filesystem::exists(settings.baselinePath))
+		{
+			baselines = readBaselines(settings.baselinePath);
+		}
+
+		for (const auto& result : results)
+		{
+			if (!settings.goldenDirectory.empty())
+			{
+				outcome = combine(outcome, checkGolden(settings, result));
+			}
+
+			if (!settings.baselinePath.empty() && !settings.updateBaseline)
+			{
+				outcome = combine(outcome, checkBaseline(settings, baselines, result));
+			}
+		}
+
+		if (settings.updateBaseline)
+		{
+			writeBaselines(settings.baselinePath, results);
+			std::cout << "Baseline written to " << settings.baselinePath << '\n';
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	switch (outcome)
+	{
+	case CheckResult::Failed:	return EXIT_FAILURE;
+	case CheckResult::Skipped:	return SKIPPED_EXIT_CODE;
+	default:					return EXIT_SUCCESS;
+	}
+}
@@ -0,0 +1,35 @@
+# Turns a SPIR-V binary into a header holding it as a constexpr uint32_t array.
+#
+#   cmake -DINPUT=<file.spv> -DOUTPUT=<file.h> -DNAME=<symbol> -P EmbedSpirv.cmake
+
+file(READ ${INPUT} hex HEX)
+
+string(LENGTH "${hex}" length)
+math(EXPR remainder "${length} % 8")
+
+if(length EQUAL 0 OR NOT remainder EQUAL 0)
+	message(FATAL_ERROR "${INPUT} is not a SPIR-V binary.")
+endif()
+
+# SPIR-V is a stream of little-endian 32-bit words.
+set(byte "[0-9a-f][0-9a-f]")
+string(REGEX REPLACE "(${byte})(${byte})(${byte})(${byte})" "0x\\4\\3\\2\\1u, " words "${hex}")
+
+set(word "0x[0-9a-f]+u, ")
+string(REGEX REPLACE "(${word}${word}${word}${word}${word}${word}${word}${word})" "\\1\n\t" words "${words}")
+string(REPLACE ", \n" ",\n" words "${words}")
+string(STRIP "${words}" words)
+
+file(WRITE ${OUTPUT}
+"// Generated from ${NAME} by EmbedSpirv.cmake, do not edit.\n"
+"#pragma once\n"
+"\n"
+"#include <cstdint>\n"
+"\n"
+"namespace EmbeddedShaders\n"
+"{\n"
+"\talignas(16) inline constexpr uint32_t ${SYMBOL}[] = {\n"
+"\t${words}\n"
+"\t};\n"
+"}\n"
+)
@@ -1,3 +0,0 @@
-C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/DefaultShader.vert -o Shaders/DefaultShader.vert.spv
-C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/DefaultShader.frag -o Shaders/DefaultShader.frag.spv
-pause
\ No newline at end of file
@@ -1,21 +1,53 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : enable
 
-layout(location = 0) out vec3 fragColor;
+// Descriptor heap, set 0. Every storage buffer the application registered.
+layout(set = 0, binding = 0) readonly buffer InstanceBuffer {
+    vec4 offsetScale[];
+} buffers[];
+
+// Uniform ring, set 1.
+layout(set = 1, binding = 0) uniform FrameUniforms {
+    mat4 viewProjection;
+    vec4 viewport;
+    vec4 frustumPlanes[6];
+} frame;
+
+layout(push_constant) uniform DrawPushConstants {
+    vec4 positionScale;
+    vec4 positionOffset;
+    uint instanceBuffer;
+    uint objectBuffer;
+    uint drawBuffer;
+    uint countBuffer;
+    uint objectCount;
+} draw;
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+// Quantized, see Vertex.h.
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec2 inNormal;
+layout(location = 2) in vec2 inUv;
 
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
+layout(location = 0) out vec3 fragColor;
+
+// Inverse of MeshProcessor::encodeOctahedral().
+vec3 decodeOctahedral(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0);
+    normal.x += normal.x >= 0.0 ? -fold : fold;
+    normal.y += normal.y >= 0.0 ? -fold : fold;
+    return normalize(normal);
+}
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
+    vec4 instance = buffers[draw.instanceBuffer].offsetScale[gl_InstanceIndex];
+    vec3 position = inPosition.xyz * draw.positionScale.xyz + draw.positionOffset.xyz;
+    gl_Position = frame.viewProjection * vec4(position.xy * instance.z + instance.xy, position.z, 1.0);
+
+    // No materials yet: the texture coordinates give the color, darkened
+    // where the surface turns away from the viewer.
+    vec3 normal = decodeOctahedral(inNormal);
+    vec3 color = clamp(vec3(inUv, 1.0 - inUv.x - inUv.y), 0.0, 1.0);
+    fragColor = color * (0.3 + 0.7 * abs(normal.z));
 }
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include "Pch.h"
+#include "AllocationStrategy.h"
+
+namespace
+{
+	bool isPowerOfTwo(uint64_t value)
+	{
+		return value != 0 && (value & (value - 1)) == 0;
+	}
+
+	uint64_t nextPowerOfTwo(uint64_t value)
+	{
+		uint64_t result = 1;
+
+		while (result < value)
+		{
+			result <<= 1;
+		}
+
+		return result;
+	}
+}
+
+double AllocationStrategy::fragmentation() const
+{
+	uint64_t freeBytes = totalCapacity - usedBytes();
+
+	if (freeBytes == 0)
+	{
+		return 0.0;
+	}
+
+	return 1.0 - static_cast<double>(largestFreeRange()) / static_cast<double>(freeBytes);
+}
+
+// ---------- Linear ----------
+
+LinearStrategy::LinearStrategy(uint64_t capacity)
+	: AllocationStrategy { capacity }
+{
+}
+
+std::optional<uint64_t> LinearStrategy::allocate(uint64_t size, uint64_t alignment)
+{
+	uint64_t offset = alignUp(head, alignment);
+
+	if (size == 0 || offset > totalCapacity || size > totalCapacity - offset)
+	{
+		return std::nullopt;
+	}
+
+	head = offset + size;
+	liveBytes += size;
+	liveAllocations[offset] = size;
+
+	return offset;
+}
+
+void LinearStrategy::free(uint64_t offset)
+{
+	auto it = liveAllocations.find(offset);
+
+	if (it == liveAllocations.end())
+	{
+		throw std::runtime_error("Freeing an offset that was not allocated from this arena.");
+	}
+
+	liveBytes -= it->second;
+	liveAllocations.erase(it);
+
+	if (liveAllocations.empty())
+	{
+		head = 0;
+	}
+}
+
+void LinearStrategy::reset()
+{
+	head = 0;
+	liveBytes = 0;
+	liveAllocations.clear();
+}
+
+uint64_t LinearStrategy::usedBytes() const
+{
+	return liveBytes;
+}
+
+uint64_t LinearStrategy::largestFreeRange() const
+{
+	return totalCapacity - head;
+}
+
+uint32_t LinearStrategy::allocationCount() const
+{
+	return static_cast<uint32_t>(liveAllocations.size());
+}
+
+// ---------- Buddy ----------
+
+BuddyStrategy::BuddyStrategy(uint64_t capacity, uint64_t minBlockSize)
+	: AllocationStrategy { capacity }, minBlockSize { minBlockSize }
+{
+	if (!isPowerOfTwo(capacity) || !isPowerOfTwo(minBlockSize) || minBlockSize > capacity)
+	{
+		throw std::runtime_error("Buddy capacity and minimum block size must be powers of two.");
+	}
+
+	levelCount = 1;
+	while ((capacity >> levelCount) >= minBlockSize)
+	{
+		levelCount++;
+	}
+
+	freeBlocks.resize(levelCount);
+	reset();
+}
+
+std::optional<uint64_t> BuddyStrategy::allocate(uint64_t size, uint64_t alignment)
+{
+	if (size == 0)
+	{
+		return std::nullopt;
+	}
+
+	// Blocks are aligned to their own size, so alignment only raises the size.
+	uint64_t required = std::max({ nextPowerOfTwo(size), alignment, minBlockSize });
+
+	if (required > totalCapacity)
+	{
+		return std::nullopt;
+	}
+
+	uint32_t level = 0;
+	while (blockSize(level + 1) >= required && level + 1 < levelCount)
+	{
+		level++;
+	}
+
+	// Find the smallest free block that fits, then split it down.
+	uint32_t found = level + 1;
+	for (uint32_t i = level + 1; i-- > 0;)
+	{
+		if (!freeBlocks[i].empty())
+		{
+			found = i;
+			break;
+		}
+	}
+
+	if (found > level)
+	{
+		return std::nullopt;
+	}
+
+	uint64_t offset = *freeBlocks[found].begin();
+	freeBlocks[found].erase(freeBlocks[found].begin());
+
+	for (uint32_t i = found; i < level; i++)
+	{
+		freeBlocks[i + 1].insert(offset + blockSize(i + 1));
+	}
+
+	allocatedLevels[offset] = level;
+	allocatedBytes += blockSize(level);
+
+	return offset;
+}
+
+void BuddyStrategy::free(uint64_t offset)
+{
+	auto it = allocatedLevels.find(offset);
+
+	if (it == allocatedLevels.end())
+	{
+		throw std::runtime_error("Freeing an offset that was not allocated from this buddy allocator.");
+	}
+
+	uint32_t level = it->second;
+	allocatedLevels.erase(it);
+	allocatedBytes -= blockSize(level);
+
+	// Merge with free buddies as far up as possible.
+	while (level > 0)
+	{
+		uint64_t buddy = offset ^ blockSize(level);
+		auto buddyIt = freeBlocks[level].find(buddy);
+
+		if (buddyIt == freeBlocks[level].end())
+		{
+			break;
+		}
+
+		freeBlocks[level].erase(buddyIt);
+		offset = std::min(offset, buddy);
+		level--;
+	}
+
+	freeBlocks[level].insert(offset);
+}
+
+void BuddyStrategy::reset()
+{
+	for (auto& blocks : freeBlocks)
+	{
+		blocks.clear();
+	}
+
+	freeBlocks[0].insert(0);
+	allocatedLevels.clear();
+	allocatedBytes = 0;
+}
+
+uint64_t BuddyStrategy::usedBytes() const
+{
+	return allocatedBytes;
+}
+
+uint64_t BuddyStrategy::largestFreeRange() const
+{
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		if (!freeBlocks[level].empty())
+		{
+			return blockSize(level);
+		}
+	}
+
+	return 0;
+}
+
+uint32_t BuddyStrategy::allocationCount() const
+{
+	return static_cast<uint32_t>(allocatedLevels.size());
+}
+
+// ---------- Pool ----------
+
+PoolStrategy::PoolStrategy(uint64_t capacity, uint64_t slotSize)
+	: AllocationStrategy { capacity }, slotSize { slotSize }
+{
+	if (slotSize == 0 || slotSize > capacity)
+	{
+		throw std::runtime_error("Pool slot size must be between 1 and the pool capacity.");
+	}
+
+	slotUsed.resize(static_cast<size_t>(capacity / slotSize), false);
+	reset();
+}
+
+std::optional<uint64_t> PoolStrategy::allocate(uint64_t size, uint64_t alignment)
+{
+	if (size == 0 || size > slotSize || slotSize % alignment != 0 || freeSlots.empty())
+	{
+		return std::nullopt;
+	}
+
+	uint32_t slot = freeSlots.back();
+	freeSlots.pop_back();
+
+	slotUsed[slot] = true;
+	usedSlots++;
+
+	return slot * slotSize;
+}
+
+void PoolStrategy::free(uint64_t offset)
+{
+	uint64_t slot = offset / slotSize;
+
+	if (offset % slotSize != 0 || slot >= slotUsed.size() || !slotUsed[slot])
+	{
+		throw std::runtime_error("Freeing an offset that was not allocated from this pool.");
+	}
+
+	slotUsed[slot] = false;
+	usedSlots--;
+	freeSlots.push_back(static_cast<uint32_t>(slot));
+}
+
+void PoolStrategy::reset()
+{
+	uint32_t slotCount = static_cast<uint32_t>(slotUsed.size());
+
+	freeSlots.resize(slotCount);
+	for (uint32_t i = 0; i < slotCount; i++)
+	{
+		// Handed out lowest offset first.
+		freeSlots[i] = slotCount - 1 - i;
+	}
+
+	std::fill(slotUsed.begin(), slotUsed.end(), false);
+	usedSlots = 0;
+}
+
+uint64_t PoolStrategy::usedBytes() const
+{
+	return usedSlots * slotSize;
+}
+
+uint64_t PoolStrategy::largestFreeRange() const
+{
+	// Every slot can hold any request the pool accepts, so slots never
+	// fragment in a way that matters: all free slots count as one range.
+	return freeSlots.size() * slotSize;
+}
+
+uint32_t PoolStrategy::allocationCount() const
+{
+	return usedSlots;
+}
@@ -0,0 +1,131 @@
+#ifndef __AllocationStrategy_h__
+#define __AllocationStrategy_h__
+
+#pragma once
+
+#include "Pch.h"
+
+// Sub-allocation strategies over a range of [0, capacity) bytes. They only
+// deal in offsets and know nothing about Vulkan, so they can be exercised on
+// the CPU without a device. DeviceAllocator places one of them over every
+// VkDeviceMemory block it owns.
+class AllocationStrategy
+{
+public:
+	virtual ~AllocationStrategy() = default;
+
+	// Returns the offset of a range of at least size bytes aligned to
+	// alignment (a power of two), or nothing when the range does not fit.
+	virtual std::optional<uint64_t> allocate(uint64_t size, uint64_t alignment) = 0;
+
+	virtual void free(uint64_t offset) = 0;
+
+	// Releases every allocation at once.
+	virtual void reset() = 0;
+
+	virtual uint64_t usedBytes() const = 0;
+	virtual uint64_t largestFreeRange() const = 0;
+	virtual uint32_t allocationCount() const = 0;
+
+	uint64_t capacity() const
+	{
+		return totalCapacity;
+	}
+
+	// 0 when all free space is one contiguous range, approaching 1 as free
+	// space is scattered into ranges too small to be useful.
+	double fragmentation() const;
+
+protected:
+	explicit AllocationStrategy(uint64_t capacity)
+		: totalCapacity { capacity }
+	{
+	}
+
+	uint64_t totalCapacity;
+};
+
+// Bump allocator. Individual frees only release space once every allocation
+// of the arena has been freed, which suits per-frame and load-time data.
+class LinearStrategy : public AllocationStrategy
+{
+public:
+	explicit LinearStrategy(uint64_t capacity);
+
+	std::optional<uint64_t> allocate(uint64_t size, uint64_t alignment) override;
+	void free(uint64_t offset) override;
+	void reset() override;
+
+	uint64_t usedBytes() const override;
+	uint64_t largestFreeRange() const override;
+	uint32_t allocationCount() const override;
+
+private:
+	uint64_t head { 0 };
+	uint64_t liveBytes { 0 };
+	Amap<uint64_t, uint64_t> liveAllocations;
+};
+
+// Binary buddy allocator. Blocks are powers of two between minBlockSize and
+// the capacity, naturally aligned to their own size.
+class BuddyStrategy : public AllocationStrategy
+{
+public:
+	BuddyStrategy(uint64_t capacity, uint64_t minBlockSize);
+
+	std::optional<uint64_t> allocate(uint64_t size, uint64_t alignment) override;
+	void free(uint64_t offset) override;
+	void reset() override;
+
+	uint64_t usedBytes() const override;
+	uint64_t largestFreeRange() const override;
+	uint32_t allocationCount() const override;
+
+private:
+	uint64_t minBlockSize;
+	uint32_t levelCount;
+	uint64_t allocatedBytes { 0 };
+
+	// freeBlocks[level] holds offsets of free blocks of size capacity >> level.
+	Avec<std::set<uint64_t>> freeBlocks;
+	Amap<uint64_t, uint32_t> allocatedLevels;
+
+	uint64_t blockSize(uint32_t level) const
+	{
+		return totalCapacity >> level;
+	}
+};
+
+// Fixed-size slots, O(1) allocate and free. Requests larger than the slot
+// size or with a stricter alignment than the slot size allows are rejected.
+class PoolStrategy : public AllocationStrategy
+{
+public:
+	PoolStrategy(uint64_t capacity, uint64_t slotSize);
+
+	std::optional<uint64_t> allocate(uint64_t size, uint64_t alignment) override;
+	void free(uint64_t offset) override;
+	void reset() override;
+
+	uint64_t usedBytes() const override;
+	uint64_t largestFreeRange() const override;
+	uint32_t allocationCount() const override;
+
+	uint64_t getSlotSize() const
+	{
+		return slotSize;
+	}
+
+private:
+	uint64_t slotSize;
+	Avec<uint32_t> freeSlots;
+	Avec<bool> slotUsed;
+	uint32_t usedSlots { 0 };
+};
+
+inline uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+#endif
@@ -0,0 +1,313 @@
+#include "Pch.h"
+#include "DebugLog.h"
+
+namespace
+{
+	constexpr auto WRITER_IDLE_SLEEP = std::chrono::milliseconds(2);
+	constexpr auto REPORT_INTERVAL = std::chrono::seconds(1);
+
+	int64_t nowMilliseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
+
+DebugLog::DebugLog()
+	: entries { std::make_unique<Entry[]>(RING_CAPACITY) },
+	idStats { std::make_unique<IdStats[]>(MAX_MESSAGE_IDS) }
+{
+	static_assert((RING_CAPACITY & (RING_CAPACITY - 1)) == 0, "RING_CAPACITY must be a power of two.");
+	static_assert((MAX_MESSAGE_IDS & (MAX_MESSAGE_IDS - 1)) == 0, "MAX_MESSAGE_IDS must be a power of two.");
+
+	for (uint32_t i = 0; i < RING_CAPACITY; i++)
+	{
+		entries[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+DebugLog::~DebugLog()
+{
+	stop();
+}
+
+void DebugLog::start(const DebugLogSettings& settings, std::ostream& out)
+{
+	if (running.load())
+	{
+		return;
+	}
+
+	this->out = &out;
+	setSeverities(settings.severities);
+	setTypes(settings.types);
+	setMessagesPerIdPerSecond(settings.messagesPerIdPerSecond);
+
+	running.store(true, std::memory_order_release);
+	writer = std::thread(&DebugLog::run, this);
+}
+
+void DebugLog::stop()
+{
+	if (!running.exchange(false, std::memory_order_acq_rel))
+	{
+		return;
+	}
+
+	writer.join();
+}
+
+void DebugLog::submit(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, int32_t messageId, const char* message)
+{
+	if ((severity & severities.load(std::memory_order_relaxed)) == 0 ||
+		(type & types.load(std::memory_order_relaxed)) == 0)
+	{
+		return;
+	}
+
+	IdStats* stats = findIdStats(messageId);
+
+	if (stats != nullptr)
+	{
+		stats->count.fetch_add(1, std::memory_order_relaxed);
+
+		uint32_t limit = messagesPerIdPerSecond.load(std::memory_order_relaxed);
+
+		if (limit != 0)
+		{
+			// Fixed one second windows. Threads racing at a window edge may
+			// both reset it, which lets a few extra messages through.
+			int64_t now = nowMilliseconds();
+			int64_t windowStart = stats->windowStart.load(std::memory_order_relaxed);
+
+			if (now - windowStart >= 1000 && stats->windowStart.compare_exchange_strong(windowStart, now, std::memory_order_relaxed))
+			{
+				stats->windowCount.store(0, std::memory_order_relaxed);
+			}
+
+			if (stats->windowCount.fetch_add(1, std::memory_order_relaxed) >= limit)
+			{
+				stats->suppressed.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+		}
+	}
+
+	if (!running.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	if (!push(severity, type, messageId, message))
+	{
+		dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+bool DebugLog::push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, int32_t messageId, const char* message)
+{
+	// Bounded multi-producer queue: a producer claims a position by moving
+	// head past it, then publishes the entry through its sequence number.
+	uint64_t position = head.load(std::memory_order_relaxed);
+	Entry* entry;
+
+	for (;;)
+	{
+		entry = &entries[position & (RING_CAPACITY - 1)];
+		uint64_t sequence = entry->sequence.load(std::memory_order_acquire);
+		int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+
+		if (difference == 0)
+		{
+			if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			// The writer has not read the entry a lap ago yet, full.
+			return false;
+		}
+		else
+		{
+			position = head.load(std::memory_order_relaxed);
+		}
+	}
+
+	entry->severity = severity;
+	entry->type = type;
+	entry->messageId = messageId;
+
+	size_t length = message != nullptr ? std::min<size_t>(std::strlen(message), MAX_MESSAGE_LENGTH - 1) : 0;
+	std::memcpy(entry->text, message, length);
+	entry->text[length] = '\0';
+
+	entry->sequence.store(position + 1, std::memory_order_release);
+
+	return true;
+}
+
+DebugLog::IdStats* DebugLog::findIdStats(int32_t messageId)
+{
+	// Open addressing with linear probing, entries are never removed.
+	uint32_t hash = static_cast<uint32_t>(messageId) * 2654435761u;
+
+	for (uint32_t probe = 0; probe < MAX_MESSAGE_IDS; probe++)
+	{
+		IdStats& stats = idStats[(hash + probe) & (MAX_MESSAGE_IDS - 1)];
+		int64_t key = stats.key.load(std::memory_order_acquire);
+
+		if (key == IdStats::EMPTY)
+		{
+			if (stats.key.compare_exchange_strong(key, messageId, std::memory_order_acq_rel))
+			{
+				return &stats;
+			}
+		}
+
+		if (key == messageId)
+		{
+			return &stats;
+		}
+	}
+
+	// Table full, the ID goes without statistics and rate limit.
+	return nullptr;
+}
+
+void DebugLog::run()
+{
+	auto lastReport = std::chrono::steady_clock::now();
+
+	for (;;)
+	{
+		// Read before draining, so the last drain sees every message
+		// submitted before stop().
+		bool stopping = !running.load(std::memory_order_acquire);
+		size_t written = drain();
+
+		auto now = std::chrono::steady_clock::now();
+
+		if (now - lastReport >= REPORT_INTERVAL || stopping)
+		{
+			flushRepeats();
+			reportSuppressed();
+			lastReport = now;
+		}
+
+		if (stopping)
+		{
+			break;
+		}
+
+		if (written == 0)
+		{
+			out->flush();
+			std::this_thread::sleep_for(WRITER_IDLE_SLEEP);
+		}
+	}
+
+	reportSummary();
+	out->flush();
+}
+
+size_t DebugLog::drain()
+{
+	size_t count = 0;
+
+	for (;;)
+	{
+		Entry& entry = entries[tail & (RING_CAPACITY - 1)];
+
+		if (entry.sequence.load(std::memory_order_acquire) != tail + 1)
+		{
+			break;
+		}
+
+		write(entry);
+
+		entry.sequence.store(tail + RING_CAPACITY, std::memory_order_release);
+		tail++;
+		count++;
+	}
+
+	return count;
+}
+
+void DebugLog::write(const Entry& entry)
+{
+	if (collapsing && entry.messageId == lastMessageId && lastMessage == entry.text)
+	{
+		lastRepeats++;
+		return;
+	}
+
+	flushRepeats();
+
+	*out << "validation layer (" << severityName(entry.severity) << "): " << entry.text << '\n';
+
+	lastMessageId = entry.messageId;
+	lastMessage = entry.text;
+	collapsing = true;
+}
+
+void DebugLog::flushRepeats()
+{
+	if (lastRepeats > 0)
+	{
+		*out << "validation layer: last message repeated " << lastRepeats << " times\n";
+	}
+
+	// Nothing to collapse into until the next message is written.
+	lastRepeats = 0;
+	collapsing = false;
+}
+
+void DebugLog::reportSuppressed()
+{
+	for (uint32_t i = 0; i < MAX_MESSAGE_IDS; i++)
+	{
+		IdStats& stats = idStats[i];
+		uint32_t suppressed = stats.suppressed.exchange(0, std::memory_order_relaxed);
+
+		if (suppressed > 0)
+		{
+			*out << "validation layer: " << suppressed << " messages with ID 0x" << std::hex << static_cast<uint32_t>(stats.key.load(std::memory_order_relaxed)) << std::dec
+				<< " suppressed by the rate limit\n";
+		}
+	}
+
+	uint32_t droppedCount = dropped.exchange(0, std::memory_order_relaxed);
+
+	if (droppedCount > 0)
+	{
+		*out << "validation layer: " << droppedCount << " messages dropped, the log ring was full\n";
+	}
+}
+
+void DebugLog::reportSummary()
+{
+	for (uint32_t i = 0; i < MAX_MESSAGE_IDS; i++)
+	{
+		const IdStats& stats = idStats[i];
+		uint32_t count = stats.count.load(std::memory_order_relaxed);
+
+		if (count > 1)
+		{
+			*out << "validation layer: message ID 0x" << std::hex << static_cast<uint32_t>(stats.key.load(std::memory_order_relaxed)) << std::dec
+				<< " reported " << count << " times\n";
+		}
+	}
+}
+
+const char* DebugLog::severityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity)
+{
+	switch (severity)
+	{
+	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:	return "verbose";
+	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:		return "info";
+	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:	return "warning";
+	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:		return "error";
+	default:												return "unknown";
+	}
+}
@@ -0,0 +1,121 @@
+#ifndef __DebugLog_h__
+#define __DebugLog_h__
+
+#pragma once
+
+#include "Pch.h"
+
+struct DebugLogSettings
+{
+	// Messages outside these are dropped in submit(), before any copy.
+	VkDebugUtilsMessageSeverityFlagsEXT severities { VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT };
+	VkDebugUtilsMessageTypeFlagsEXT types { VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT };
+
+	// Messages with the same ID past this many in a second are only counted,
+	// 0 disables the limit.
+	uint32_t messagesPerIdPerSecond { 10 };
+};
+
+// Sink for validation layer messages that never blocks the thread reporting
+// them. submit() filters, rate limits and copies the message into a bounded
+// lock-free ring; a writer thread formats and writes the messages, collapses
+// identical consecutive ones into a repeat count and reports what the rate
+// limit suppressed once a second. When the ring is full messages are dropped
+// and counted instead of waiting.
+class DebugLog
+{
+public:
+	static constexpr uint32_t RING_CAPACITY { 1024 };
+	static constexpr uint32_t MAX_MESSAGE_LENGTH { 1024 };
+	static constexpr uint32_t MAX_MESSAGE_IDS { 1024 };
+
+	DebugLog();
+	~DebugLog();
+
+	void start(const DebugLogSettings& settings = {}, std::ostream& out = std::cerr);
+
+	// Writes everything submitted so far and joins the writer thread.
+	void stop();
+
+	// Safe to call from any thread. Before start() and after stop() messages
+	// are only counted.
+	void submit(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, int32_t messageId, const char* message);
+
+	void setSeverities(VkDebugUtilsMessageSeverityFlagsEXT severities)
+	{
+		this->severities.store(severities, std::memory_order_relaxed);
+	}
+
+	VkDebugUtilsMessageSeverityFlagsEXT getSeverities() const
+	{
+		return severities.load(std::memory_order_relaxed);
+	}
+
+	void setTypes(VkDebugUtilsMessageTypeFlagsEXT types)
+	{
+		this->types.store(types, std::memory_order_relaxed);
+	}
+
+	void setMessagesPerIdPerSecond(uint32_t limit)
+	{
+		messagesPerIdPerSecond.store(limit, std::memory_order_relaxed);
+	}
+
+private:
+	struct Entry
+	{
+		// Position + 1 once written, position + RING_CAPACITY once read.
+		std::atomic<uint64_t> sequence { 0 };
+
+		VkDebugUtilsMessageSeverityFlagBitsEXT severity;
+		VkDebugUtilsMessageTypeFlagsEXT type;
+		int32_t messageId;
+		char text[MAX_MESSAGE_LENGTH];
+	};
+
+	struct IdStats
+	{
+		static constexpr int64_t EMPTY { std::numeric_limits<int64_t>::min() };
+
+		std::atomic<int64_t> key { EMPTY };
+		std::atomic<uint32_t> count { 0 };
+		std::atomic<uint32_t> suppressed { 0 };
+		std::atomic<int64_t> windowStart { 0 };
+		std::atomic<uint32_t> windowCount { 0 };
+	};
+
+	std::unique_ptr<Entry[]> entries;
+	std::unique_ptr<IdStats[]> idStats;
+
+	std::atomic<uint64_t> head { 0 };
+	uint64_t tail { 0 };
+
+	std::atomic<VkDebugUtilsMessageSeverityFlagsEXT> severities { 0 };
+	std::atomic<VkDebugUtilsMessageTypeFlagsEXT> types { 0 };
+	std::atomic<uint32_t> messagesPerIdPerSecond { 0 };
+	std::atomic<uint32_t> dropped { 0 };
+
+	std::atomic<bool> running { false };
+	std::thread writer;
+	std::ostream* out = nullptr;
+
+	// Writer thread only.
+	int32_t lastMessageId { 0 };
+	Astr lastMessage;
+	uint32_t lastRepeats { 0 };
+	bool collapsing { false };
+
+	bool push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, int32_t messageId, const char* message);
+	IdStats* findIdStats(int32_t messageId);
+
+	void run();
+	size_t drain();
+	void write(const Entry& entry);
+	void flushRepeats();
+	void reportSuppressed();
+	void reportSummary();
+
+	static const char* severityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity);
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "Pch.h"
+#include "DeletionQueue.h"
+
+void DeletionQueue::create(const FrameScheduler& scheduler)
+{
+	this->scheduler = &scheduler;
+}
+
+void DeletionQueue::flush()
+{
+	while (!entries.empty())
+	{
+		Destructor destructor = std::move(entries.front().destructor);
+		entries.pop_front();
+		destructor();
+	}
+}
+
+void DeletionQueue::retire(Destructor destructor)
+{
+	Entry entry;
+	entry.values.resize(scheduler->getQueueCount());
+
+	for (uint32_t i = 0; i < entry.values.size(); i++)
+	{
+		entry.values[i] = scheduler->getSubmittedValue(i);
+	}
+
+	entry.destructor = std::move(destructor);
+	entries.push_back(std::move(entry));
+}
+
+void DeletionQueue::collect()
+{
+	if (entries.empty())
+	{
+		return;
+	}
+
+	// Submitted values only grow, so entries complete in order and one query
+	// per timeline is enough.
+	Avec<uint64_t> completed(scheduler->getQueueCount());
+
+	for (uint32_t i = 0; i < completed.size(); i++)
+	{
+		completed[i] = scheduler->getCompletedValue(i);
+	}
+
+	while (!entries.empty())
+	{
+		const Entry& entry = entries.front();
+
+		for (uint32_t i = 0; i < entry.values.size(); i++)
+		{
+			if (completed[i] < entry.values[i])
+			{
+				return;
+			}
+		}
+
+		Destructor destructor = std::move(entries.front().destructor);
+		entries.pop_front();
+		destructor();
+	}
+}
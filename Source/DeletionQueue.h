@@ -0,0 +1,48 @@
+#ifndef __DeletionQueue_h__
+#define __DeletionQueue_h__
+
+#pragma once
+
+#include "Pch.h"
+#include "FrameScheduler.h"
+
+// Destroys objects once the GPU is done with them instead of waiting for the
+// device to go idle. retire() tags a destructor with the last value submitted
+// on every timeline of the frame scheduler, which covers every command that
+// may still use the object, and collect() runs it once all of them have been
+// reached. Destructors run in the order they were retired.
+//
+// Like the rest of the per-frame state, only used from the render thread.
+class DeletionQueue
+{
+public:
+	using Destructor = std::function<void()>;
+
+	void create(const FrameScheduler& scheduler);
+
+	// Runs every destructor left, the device has to be idle.
+	void flush();
+
+	// Everything the object is used by has to be submitted already.
+	void retire(Destructor destructor);
+
+	// Runs the destructors whose work has finished, does not block.
+	void collect();
+
+	size_t getPendingCount() const
+	{
+		return entries.size();
+	}
+
+private:
+	struct Entry
+	{
+		Avec<uint64_t> values;
+		Destructor destructor;
+	};
+
+	const FrameScheduler* scheduler = nullptr;
+	std::deque<Entry> entries;
+};
+
+#endif
@@ -0,0 +1,246 @@
+#include "Pch.h"
+#include "DescriptorHeap.h"
+
+void DescriptorHeap::create(VkDevice device, VkPhysicalDevice physicalDevice, const DescriptorHeapCapacities& capacities)
+{
+	this->device = device;
+
+	VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+	vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 properties{};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = &vulkan12Properties;
+
+	vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+	// The per-stage limits apply as well, since every binding is visible to
+	// all stages.
+	arrays[static_cast<uint32_t>(Kind::StorageBuffer)].capacity = std::min({
+		capacities.storageBuffers,
+		vulkan12Properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+		vulkan12Properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers
+	});
+	arrays[static_cast<uint32_t>(Kind::SampledImage)].capacity = std::min({
+		capacities.sampledImages,
+		vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages,
+		vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages
+	});
+	arrays[static_cast<uint32_t>(Kind::Sampler)].capacity = std::min({
+		capacities.samplers,
+		vulkan12Properties.maxDescriptorSetUpdateAfterBindSamplers,
+		vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers
+	});
+
+	// So does the limit on all of them together.
+	auto totalCapacity = [this]()
+	{
+		return static_cast<uint64_t>(arrays[0].capacity) + arrays[1].capacity + arrays[2].capacity;
+	};
+
+	while (totalCapacity() > vulkan12Properties.maxPerStageUpdateAfterBindResources)
+	{
+		Array& largest = *std::max_element(arrays.begin(), arrays.end(), [](const Array& a, const Array& b) { return a.capacity < b.capacity; });
+		largest.capacity /= 2;
+	}
+
+	const uint32_t requested[KIND_COUNT] = { capacities.storageBuffers, capacities.sampledImages, capacities.samplers };
+
+	for (uint32_t i = 0; i < KIND_COUNT; i++)
+	{
+		if (requested[i] != 0 && arrays[i].capacity == 0)
+		{
+			throw std::runtime_error("Descriptor heap arrays do not fit into maxPerStageUpdateAfterBindResources.");
+		}
+	}
+
+	std::array<VkDescriptorSetLayoutBinding, KIND_COUNT> bindings{};
+	std::array<VkDescriptorBindingFlags, KIND_COUNT> bindingFlags{};
+	std::array<VkDescriptorPoolSize, KIND_COUNT> poolSizes{};
+
+	for (uint32_t i = 0; i < KIND_COUNT; i++)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = getDescriptorType(static_cast<Kind>(i));
+		bindings[i].descriptorCount = arrays[i].capacity;
+		bindings[i].stageFlags = VK_SHADER_STAGE_ALL;
+
+		// Unused entries are never written, and entries can change while the
+		// set is bound as long as no pending command buffer uses them.
+		bindingFlags[i] =
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+		poolSizes[i].type = bindings[i].descriptorType;
+		poolSizes[i].descriptorCount = arrays[i].capacity;
+	}
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsInfo.bindingCount = KIND_COUNT;
+	bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = &bindingFlagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	layoutInfo.bindingCount = KIND_COUNT;
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor heap set layout.");
+	}
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = KIND_COUNT;
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor heap pool.");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &setLayout;
+
+	if (vkAllocateDescriptorSets(device, &allocInfo, &set) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate descriptor heap set.");
+	}
+}
+
+void DescriptorHeap::destroy()
+{
+	vkDestroyDescriptorPool(device, pool, nullptr);
+	vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+
+	pool = VK_NULL_HANDLE;
+	setLayout = VK_NULL_HANDLE;
+	set = VK_NULL_HANDLE;
+
+	for (auto& array : arrays)
+	{
+		array.highWater = 0;
+		array.freeIndices.clear();
+	}
+}
+
+uint32_t DescriptorHeap::addStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	VkDescriptorBufferInfo bufferInfo{};
+	bufferInfo.buffer = buffer;
+	bufferInfo.offset = offset;
+	bufferInfo.range = range;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	uint32_t index = allocateIndex(Kind::StorageBuffer);
+	write(Kind::StorageBuffer, index, &bufferInfo, nullptr);
+
+	return index;
+}
+
+uint32_t DescriptorHeap::addSampledImage(VkImageView view, VkImageLayout layout)
+{
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageView = view;
+	imageInfo.imageLayout = layout;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	uint32_t index = allocateIndex(Kind::SampledImage);
+	write(Kind::SampledImage, index, nullptr, &imageInfo);
+
+	return index;
+}
+
+uint32_t DescriptorHeap::addSampler(VkSampler sampler)
+{
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.sampler = sampler;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	uint32_t index = allocateIndex(Kind::Sampler);
+	write(Kind::Sampler, index, nullptr, &imageInfo);
+
+	return index;
+}
+
+void DescriptorHeap::remove(Kind kind, uint32_t index)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Array& array = arrays[static_cast<uint32_t>(kind)];
+
+	if (index >= array.highWater)
+	{
+		throw std::runtime_error("Removing a descriptor that was never added.");
+	}
+
+	// The stale descriptor stays in the set. Partially bound arrays allow
+	// that as long as shaders do not access it.
+	array.freeIndices.push_back(index);
+}
+
+void DescriptorHeap::bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t setIndex) const
+{
+	vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, setIndex, 1, &set, 0, nullptr);
+}
+
+uint32_t DescriptorHeap::allocateIndex(Kind kind)
+{
+	Array& array = arrays[static_cast<uint32_t>(kind)];
+
+	if (!array.freeIndices.empty())
+	{
+		uint32_t index = array.freeIndices.back();
+		array.freeIndices.pop_back();
+		return index;
+	}
+
+	if (array.highWater == array.capacity)
+	{
+		throw std::runtime_error("Descriptor heap is full.");
+	}
+
+	return array.highWater++;
+}
+
+void DescriptorHeap::write(Kind kind, uint32_t index, const VkDescriptorBufferInfo* bufferInfo, const VkDescriptorImageInfo* imageInfo)
+{
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = set;
+	descriptorWrite.dstBinding = static_cast<uint32_t>(kind);
+	descriptorWrite.dstArrayElement = index;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.descriptorType = getDescriptorType(kind);
+	descriptorWrite.pBufferInfo = bufferInfo;
+	descriptorWrite.pImageInfo = imageInfo;
+
+	vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+}
+
+VkDescriptorType DescriptorHeap::getDescriptorType(Kind kind)
+{
+	switch (kind)
+	{
+	case Kind::StorageBuffer:
+		return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	case Kind::SampledImage:
+		return VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	case Kind::Sampler:
+		return VK_DESCRIPTOR_TYPE_SAMPLER;
+	}
+
+	throw std::runtime_error("Unknown descriptor kind.");
+}
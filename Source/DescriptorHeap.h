@@ -0,0 +1,95 @@
+#ifndef __DescriptorHeap_h__
+#define __DescriptorHeap_h__
+
+#pragma once
+
+#include "Pch.h"
+
+struct DescriptorHeapCapacities
+{
+	uint32_t storageBuffers { 65536 };
+	uint32_t sampledImages { 65536 };
+	uint32_t samplers { 256 };
+};
+
+// One descriptor set holding every storage buffer, sampled image and sampler
+// in large partially bound arrays. Shaders index the arrays with indices
+// passed in push constants or read from buffers, so the set is bound once
+// per command buffer instead of allocating and binding sets per draw.
+//
+// The bindings are update-after-bind: descriptors can be added and removed
+// while the set is bound in command buffers that are still pending, as long
+// as those command buffers do not use them.
+//
+//  set 0, binding 0: buffer buffers[]
+//  set 0, binding 1: texture2D textures[]
+//  set 0, binding 2: sampler samplers[]
+class DescriptorHeap
+{
+public:
+	enum class Kind : uint32_t
+	{
+		StorageBuffer,
+		SampledImage,
+		Sampler
+	};
+
+	// Capacities are clamped to the update-after-bind limits of the device.
+	void create(VkDevice device, VkPhysicalDevice physicalDevice, const DescriptorHeapCapacities& capacities = {});
+	void destroy();
+
+	// Return the index shaders access the descriptor with.
+	uint32_t addStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+	uint32_t addSampledImage(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	uint32_t addSampler(VkSampler sampler);
+
+	// Frees an index for reuse. No pending command buffer may still use it.
+	void remove(Kind kind, uint32_t index);
+
+	void bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t setIndex = 0) const;
+
+	VkDescriptorSetLayout getSetLayout() const
+	{
+		return setLayout;
+	}
+
+	uint32_t getCapacity(Kind kind) const
+	{
+		return arrays[static_cast<uint32_t>(kind)].capacity;
+	}
+
+	uint32_t getUsedCount(Kind kind) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		const Array& array = arrays[static_cast<uint32_t>(kind)];
+		return array.highWater - static_cast<uint32_t>(array.freeIndices.size());
+	}
+
+private:
+	static constexpr uint32_t KIND_COUNT { 3 };
+
+	struct Array
+	{
+		uint32_t capacity { 0 };
+		// Indices below highWater have been handed out at least once.
+		uint32_t highWater { 0 };
+		Avec<uint32_t> freeIndices;
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	VkDescriptorSet set = VK_NULL_HANDLE;
+
+	std::array<Array, KIND_COUNT> arrays;
+
+	mutable std::mutex mutex;
+
+	uint32_t allocateIndex(Kind kind);
+	void write(Kind kind, uint32_t index, const VkDescriptorBufferInfo* bufferInfo, const VkDescriptorImageInfo* imageInfo);
+
+	static VkDescriptorType getDescriptorType(Kind kind);
+};
+
+#endif
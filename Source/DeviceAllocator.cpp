@@ -0,0 +1,397 @@
+#include "Pch.h"
+#include "DeviceAllocator.h"
+
+void DeviceAllocator::create(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize blockSize)
+{
+	this->device = device;
+	this->blockSize = blockSize;
+
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	bufferImageGranularity = properties.limits.bufferImageGranularity;
+	nonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+	maxAllocationCount = properties.limits.maxMemoryAllocationCount;
+}
+
+void DeviceAllocator::destroy()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (auto& [key, pool] : pools)
+	{
+		for (auto& block : pool.blocks)
+		{
+			if (block->strategy->allocationCount() != 0)
+			{
+				AMlog("DeviceAllocator: " << block->strategy->allocationCount() << " allocations leaked in memory type " << pool.memoryTypeIndex);
+			}
+
+			freeDeviceMemory(block->memory);
+		}
+	}
+
+	for (auto& [memory, dedicated] : dedicatedAllocations)
+	{
+		AMlog("DeviceAllocator: dedicated allocation leaked in memory type " << dedicated.memoryTypeIndex);
+		freeDeviceMemory(memory);
+	}
+
+	pools.clear();
+	dedicatedAllocations.clear();
+}
+
+Allocation DeviceAllocator::allocate(const VkMemoryRequirements& requirements, const AllocationCreateInfo& createInfo)
+{
+	uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, createInfo.requiredFlags, createInfo.preferredFlags);
+
+	VkDeviceSize size = requirements.size;
+	VkDeviceSize alignment = requirements.alignment;
+
+	// Flushed and invalidated ranges of non-coherent memory are whole atoms,
+	// so allocations in it start and end on atom boundaries and any range
+	// rounded out to atoms stays inside its allocation.
+	VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+
+	if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+	{
+		alignment = std::max(alignment, nonCoherentAtomSize);
+		size = alignUp(size, nonCoherentAtomSize);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Allocation allocation;
+	allocation.memoryTypeIndex = memoryTypeIndex;
+	allocation.size = size;
+
+	// Anything larger than half a block would waste most of it, and Pool
+	// slots are sized by the caller so never go dedicated.
+	if (createInfo.dedicated || (createInfo.strategy != AllocationStrategyType::Pool && size > blockSize / 2))
+	{
+		allocation.memory = allocateDeviceMemory(size, memoryTypeIndex, &allocation.mapped);
+		dedicatedAllocations[allocation.memory] = { memoryTypeIndex, size };
+		return allocation;
+	}
+
+	ResourceKind kind = getBlockKind(createInfo.kind, bufferImageGranularity);
+	VkDeviceSize slotSize = 0;
+
+	if (createInfo.strategy == AllocationStrategyType::Pool)
+	{
+		if (createInfo.poolSlotSize == 0)
+		{
+			throw std::runtime_error("Pool allocations need a slot size.");
+		}
+
+		slotSize = alignUp(createInfo.poolSlotSize, alignment);
+	}
+
+	PoolKey key { memoryTypeIndex, createInfo.strategy, kind, slotSize };
+	BlockPool& pool = pools[key];
+	pool.memoryTypeIndex = memoryTypeIndex;
+	pool.strategy = createInfo.strategy;
+	pool.slotSize = slotSize;
+
+	std::optional<uint64_t> offset;
+	Block* target = nullptr;
+
+	for (auto& block : pool.blocks)
+	{
+		offset = block->strategy->allocate(size, alignment);
+
+		if (offset)
+		{
+			target = block.get();
+			break;
+		}
+	}
+
+	if (!target)
+	{
+		target = &createBlock(pool, blockSize);
+		offset = target->strategy->allocate(size, alignment);
+
+		if (!offset)
+		{
+			throw std::runtime_error("Allocation does not fit into a new memory block.");
+		}
+	}
+
+	allocation.memory = target->memory;
+	allocation.offset = *offset;
+	allocation.block = target;
+
+	if (target->mapped)
+	{
+		allocation.mapped = static_cast<char*>(target->mapped) + allocation.offset;
+	}
+
+	return allocation;
+}
+
+void DeviceAllocator::free(const Allocation& allocation)
+{
+	if (allocation.memory == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (!allocation.block)
+	{
+		dedicatedAllocations.erase(allocation.memory);
+		freeDeviceMemory(allocation.memory);
+		return;
+	}
+
+	Block* block = static_cast<Block*>(allocation.block);
+	block->strategy->free(allocation.offset);
+
+	// Keep one empty block per pool around to avoid churn at the boundary,
+	// release any further empty ones.
+	BlockPool& pool = *block->pool;
+
+	if (block->strategy->allocationCount() != 0)
+	{
+		return;
+	}
+
+	bool otherBlockEmpty = std::any_of(pool.blocks.begin(), pool.blocks.end(), [block](const std::unique_ptr<Block>& candidate)
+	{
+		return candidate.get() != block && candidate->strategy->allocationCount() == 0;
+	});
+
+	if (otherBlockEmpty)
+	{
+		auto it = std::find_if(pool.blocks.begin(), pool.blocks.end(), [block](const std::unique_ptr<Block>& candidate) { return candidate.get() == block; });
+
+		freeDeviceMemory(block->memory);
+		pool.blocks.erase(it);
+	}
+}
+
+Allocation DeviceAllocator::allocateForBuffer(VkBuffer buffer, const AllocationCreateInfo& createInfo)
+{
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(device, buffer, &requirements);
+
+	AllocationCreateInfo info = createInfo;
+	info.kind = ResourceKind::Linear;
+
+	Allocation allocation = allocate(requirements, info);
+
+	if (vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset) != VK_SUCCESS)
+	{
+		free(allocation);
+		throw std::runtime_error("Failed to bind buffer memory.");
+	}
+
+	return allocation;
+}
+
+Allocation DeviceAllocator::allocateForImage(VkImage image, const AllocationCreateInfo& createInfo)
+{
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(device, image, &requirements);
+
+	Allocation allocation = allocate(requirements, createInfo);
+
+	if (vkBindImageMemory(device, image, allocation.memory, allocation.offset) != VK_SUCCESS)
+	{
+		free(allocation);
+		throw std::runtime_error("Failed to bind image memory.");
+	}
+
+	return allocation;
+}
+
+void DeviceAllocator::resetLinear(uint32_t memoryTypeIndex)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (auto& [key, pool] : pools)
+	{
+		if (pool.memoryTypeIndex == memoryTypeIndex && pool.strategy == AllocationStrategyType::Linear)
+		{
+			for (auto& block : pool.blocks)
+			{
+				block->strategy->reset();
+			}
+		}
+	}
+}
+
+uint32_t DeviceAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags requiredFlags, VkMemoryPropertyFlags preferredFlags) const
+{
+	std::optional<uint32_t> fallback;
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
+
+		if (!(typeFilter & (1 << i)) || (flags & requiredFlags) != requiredFlags)
+		{
+			continue;
+		}
+
+		if ((flags & preferredFlags) == preferredFlags)
+		{
+			return i;
+		}
+
+		if (!fallback)
+		{
+			fallback = i;
+		}
+	}
+
+	if (!fallback)
+	{
+		throw std::runtime_error("Failed to find suitable memory type.");
+	}
+
+	return *fallback;
+}
+
+AllocatorStats DeviceAllocator::stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	AllocatorStats result;
+
+	for (const auto& [key, pool] : pools)
+	{
+		accumulate(result, pool);
+	}
+
+	for (const auto& [memory, dedicated] : dedicatedAllocations)
+	{
+		accumulate(result, dedicated);
+	}
+
+	finish(result);
+	return result;
+}
+
+AllocatorStats DeviceAllocator::stats(uint32_t memoryTypeIndex) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	AllocatorStats result;
+
+	for (const auto& [key, pool] : pools)
+	{
+		if (pool.memoryTypeIndex == memoryTypeIndex)
+		{
+			accumulate(result, pool);
+		}
+	}
+
+	for (const auto& [memory, dedicated] : dedicatedAllocations)
+	{
+		if (dedicated.memoryTypeIndex == memoryTypeIndex)
+		{
+			accumulate(result, dedicated);
+		}
+	}
+
+	finish(result);
+	return result;
+}
+
+VkDeviceMemory DeviceAllocator::allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** mapped)
+{
+	if (maxAllocationCount != 0 && deviceAllocationCount >= maxAllocationCount)
+	{
+		throw std::runtime_error("Exceeded maxMemoryAllocationCount.");
+	}
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VkDeviceMemory memory;
+	if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate device memory.");
+	}
+
+	deviceAllocationCount++;
+
+	*mapped = nullptr;
+
+	// Host visible memory stays mapped for its whole lifetime.
+	if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS)
+		{
+			vkFreeMemory(device, memory, nullptr);
+			deviceAllocationCount--;
+			throw std::runtime_error("Failed to map device memory.");
+		}
+	}
+
+	return memory;
+}
+
+void DeviceAllocator::freeDeviceMemory(VkDeviceMemory memory)
+{
+	// Freeing implicitly unmaps.
+	vkFreeMemory(device, memory, nullptr);
+	deviceAllocationCount--;
+}
+
+DeviceAllocator::Block& DeviceAllocator::createBlock(BlockPool& pool, VkDeviceSize size)
+{
+	auto block = std::make_unique<Block>();
+	block->pool = &pool;
+	block->memory = allocateDeviceMemory(size, pool.memoryTypeIndex, &block->mapped);
+
+	switch (pool.strategy)
+	{
+	case AllocationStrategyType::Linear:
+		block->strategy = std::make_unique<LinearStrategy>(size);
+		break;
+	case AllocationStrategyType::Buddy:
+		block->strategy = std::make_unique<BuddyStrategy>(size, MIN_BUDDY_BLOCK_SIZE);
+		break;
+	case AllocationStrategyType::Pool:
+		block->strategy = std::make_unique<PoolStrategy>(size, pool.slotSize);
+		break;
+	}
+
+	pool.blocks.push_back(std::move(block));
+	return *pool.blocks.back();
+}
+
+void DeviceAllocator::accumulate(AllocatorStats& stats, const BlockPool& pool) const
+{
+	for (const auto& block : pool.blocks)
+	{
+		stats.blockCount++;
+		stats.allocationCount += block->strategy->allocationCount();
+		stats.reservedBytes += block->strategy->capacity();
+		stats.usedBytes += block->strategy->usedBytes();
+
+		// Summed weighted by capacity, normalised in finish().
+		stats.fragmentation += block->strategy->fragmentation() * static_cast<double>(block->strategy->capacity());
+	}
+}
+
+void DeviceAllocator::accumulate(AllocatorStats& stats, const DedicatedAllocation& dedicated) const
+{
+	stats.dedicatedAllocationCount++;
+	stats.allocationCount++;
+	stats.reservedBytes += dedicated.size;
+	stats.usedBytes += dedicated.size;
+}
+
+void DeviceAllocator::finish(AllocatorStats& stats)
+{
+	stats.fragmentation = stats.reservedBytes ? stats.fragmentation / static_cast<double>(stats.reservedBytes) : 0.0;
+}
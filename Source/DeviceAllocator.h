@@ -0,0 +1,155 @@
+#ifndef __DeviceAllocator_h__
+#define __DeviceAllocator_h__
+
+#pragma once
+
+#include "Pch.h"
+#include "AllocationStrategy.h"
+
+enum class AllocationStrategyType
+{
+	Linear,
+	Buddy,
+	Pool
+};
+
+// Resources that must not share a bufferImageGranularity page with each
+// other: buffers and linear images on one side, optimal images on the other.
+enum class ResourceKind
+{
+	Linear,
+	Optimal
+};
+
+// Kind the block pools are keyed by. With a bufferImageGranularity of 1
+// linear and optimal resources may share blocks.
+inline ResourceKind getBlockKind(ResourceKind kind, VkDeviceSize bufferImageGranularity)
+{
+	return bufferImageGranularity > 1 ? kind : ResourceKind::Linear;
+}
+
+struct AllocationCreateInfo
+{
+	VkMemoryPropertyFlags requiredFlags { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+	VkMemoryPropertyFlags preferredFlags { 0 };
+
+	AllocationStrategyType strategy { AllocationStrategyType::Buddy };
+	ResourceKind kind { ResourceKind::Linear };
+
+	// Slot size of Pool allocations, all allocations of a pool share it.
+	VkDeviceSize poolSlotSize { 0 };
+
+	// Gets a VkDeviceMemory of its own whatever the size.
+	bool dedicated { false };
+};
+
+// In host visible non-coherent memory offset and size are multiples of
+// nonCoherentAtomSize.
+struct Allocation
+{
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize offset { 0 };
+	VkDeviceSize size { 0 };
+	uint32_t memoryTypeIndex { 0 };
+
+	// Host pointer to offset, for allocations in host visible memory.
+	void* mapped = nullptr;
+
+	// Owning block, nullptr for dedicated allocations.
+	void* block = nullptr;
+};
+
+struct AllocatorStats
+{
+	uint32_t blockCount { 0 };
+	uint32_t dedicatedAllocationCount { 0 };
+	uint32_t allocationCount { 0 };
+	VkDeviceSize reservedBytes { 0 };
+	VkDeviceSize usedBytes { 0 };
+
+	// Size weighted fragmentation of all blocks, see AllocationStrategy.
+	double fragmentation { 0.0 };
+};
+
+// Sub-allocates buffers and images from large VkDeviceMemory blocks, so the
+// number of vkAllocateMemory calls stays far below maxMemoryAllocationCount.
+// Blocks are grouped by memory type, strategy and, when the device has a
+// bufferImageGranularity above 1, by resource kind.
+class DeviceAllocator
+{
+public:
+	static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE { 64ull * 1024 * 1024 };
+	static constexpr VkDeviceSize MIN_BUDDY_BLOCK_SIZE { 256 };
+
+	void create(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+	void destroy();
+
+	Allocation allocate(const VkMemoryRequirements& requirements, const AllocationCreateInfo& createInfo);
+	void free(const Allocation& allocation);
+
+	// Allocates memory for the resource and binds it.
+	Allocation allocateForBuffer(VkBuffer buffer, const AllocationCreateInfo& createInfo);
+	Allocation allocateForImage(VkImage image, const AllocationCreateInfo& createInfo);
+
+	// Releases every allocation of the Linear blocks of a memory type at once.
+	void resetLinear(uint32_t memoryTypeIndex);
+
+	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags requiredFlags, VkMemoryPropertyFlags preferredFlags = 0) const;
+
+	AllocatorStats stats() const;
+	AllocatorStats stats(uint32_t memoryTypeIndex) const;
+
+	const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const
+	{
+		return memoryProperties;
+	}
+
+private:
+	struct BlockPool;
+
+	struct Block
+	{
+		VkDeviceMemory memory;
+		void* mapped;
+		std::unique_ptr<AllocationStrategy> strategy;
+		BlockPool* pool;
+	};
+
+	struct BlockPool
+	{
+		uint32_t memoryTypeIndex;
+		AllocationStrategyType strategy;
+		VkDeviceSize slotSize;
+		Avec<std::unique_ptr<Block>> blocks;
+	};
+
+	using PoolKey = std::tuple<uint32_t, AllocationStrategyType, ResourceKind, VkDeviceSize>;
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDeviceMemoryProperties memoryProperties{};
+	VkDeviceSize bufferImageGranularity { 1 };
+	VkDeviceSize nonCoherentAtomSize { 1 };
+	uint32_t maxAllocationCount { 0 };
+	VkDeviceSize blockSize { DEFAULT_BLOCK_SIZE };
+
+	mutable std::mutex mutex;
+	std::map<PoolKey, BlockPool> pools;
+	struct DedicatedAllocation
+	{
+		uint32_t memoryTypeIndex;
+		VkDeviceSize size;
+	};
+
+	Amap<VkDeviceMemory, DedicatedAllocation> dedicatedAllocations;
+	uint32_t deviceAllocationCount { 0 };
+
+	VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** mapped);
+	void freeDeviceMemory(VkDeviceMemory memory);
+
+	Block& createBlock(BlockPool& pool, VkDeviceSize size);
+	void accumulate(AllocatorStats& stats, const BlockPool& pool) const;
+	void accumulate(AllocatorStats& stats, const DedicatedAllocation& dedicated) const;
+	static void finish(AllocatorStats& stats);
+};
+
+#endif
@@ -0,0 +1,179 @@
+#include "Pch.h"
+#include "DeviceSelector.h"
+
+DeviceSelector::Candidate DeviceSelector::describe(VkPhysicalDevice device)
+{
+	Candidate candidate;
+	candidate.device = device;
+
+	VkPhysicalDeviceIDProperties idProperties{};
+	idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 properties{};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = &idProperties;
+
+	vkGetPhysicalDeviceProperties2(device, &properties);
+
+	candidate.properties = properties.properties;
+	candidate.uuid = formatUuid(idProperties.deviceUUID);
+
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+	{
+		const VkMemoryHeap& heap = memoryProperties.memoryHeaps[i];
+
+		if (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		{
+			candidate.deviceLocalBytes = std::max(candidate.deviceLocalBytes, heap.size);
+		}
+	}
+
+	return candidate;
+}
+
+const DeviceSelector::Candidate& DeviceSelector::select(Avec<Candidate>& candidates, const Astr& selector, bool allowSoftware)
+{
+	const Candidate* best = nullptr;
+
+	for (auto& candidate : candidates)
+	{
+		candidate.score = score(candidate);
+
+		bool software = candidate.properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+		bool selected = !selector.empty() && matches(candidate, selector);
+
+		std::ostringstream line;
+		line << "  " << candidate.properties.deviceName
+			<< " (" << typeName(candidate.properties.deviceType)
+			<< ", " << (candidate.deviceLocalBytes >> 20) << " MiB"
+			<< ", " << candidate.uuid << ")";
+
+		if (!candidate.suitable)
+		{
+			line << " not suitable";
+		}
+		else if (software && !allowSoftware && !selected)
+		{
+			line << " software rasterizer, not allowed";
+		}
+		else if (!selector.empty() && !selected)
+		{
+			line << " score " << candidate.score << ", does not match \"" << selector << "\"";
+		}
+		else
+		{
+			line << " score " << candidate.score;
+
+			if (best == nullptr || candidate.score > best->score)
+			{
+				best = &candidate;
+			}
+		}
+
+		AMlog(line.str());
+	}
+
+	if (best == nullptr)
+	{
+		if (!selector.empty())
+		{
+			throw std::runtime_error("No suitable GPU matches \"" + selector + "\".");
+		}
+
+		throw std::runtime_error("Failed to find a suitable GPU.");
+	}
+
+	AMlog("Using " << best->properties.deviceName << (selector.empty() ? "" : ", selected by \"" + selector + "\""));
+
+	return *best;
+}
+
+bool DeviceSelector::matches(const Candidate& candidate, const Astr& selector)
+{
+	auto lower = [](Astr text)
+	{
+		std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return text;
+	};
+
+	Astr pattern = lower(selector);
+
+	if (lower(candidate.uuid) == pattern)
+	{
+		return true;
+	}
+
+	return lower(candidate.properties.deviceName).find(pattern) != Astr::npos;
+}
+
+Astr DeviceSelector::formatUuid(const uint8_t uuid[VK_UUID_SIZE])
+{
+	std::ostringstream text;
+	text << std::hex << std::setfill('0');
+
+	for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+	{
+		if (i == 4 || i == 6 || i == 8 || i == 10)
+		{
+			text << '-';
+		}
+
+		text << std::setw(2) << static_cast<uint32_t>(uuid[i]);
+	}
+
+	return text.str();
+}
+
+int64_t DeviceSelector::score(const Candidate& candidate)
+{
+	// The device type outweighs everything else, an integrated GPU with
+	// more shared memory is still slower than a discrete one.
+	int64_t typeRank = 0;
+
+	switch (candidate.properties.deviceType)
+	{
+	case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:		typeRank = 4; break;
+	case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:	typeRank = 3; break;
+	case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:		typeRank = 2; break;
+	case VK_PHYSICAL_DEVICE_TYPE_OTHER:				typeRank = 1; break;
+	default:										typeRank = 0; break;
+	}
+
+	int64_t result = typeRank * 1000000;
+
+	// 100 per 256 MiB of the largest device local heap.
+	result += static_cast<int64_t>(candidate.deviceLocalBytes >> 28) * 100;
+
+	if (candidate.dedicatedTransferQueue)
+	{
+		result += 50;
+	}
+
+	if (candidate.dedicatedComputeQueue)
+	{
+		result += 50;
+	}
+
+	// The profiler needs timestamps on the graphics queue.
+	if (candidate.properties.limits.timestampComputeAndGraphics)
+	{
+		result += 10;
+	}
+
+	return result;
+}
+
+const char* DeviceSelector::typeName(VkPhysicalDeviceType type)
+{
+	switch (type)
+	{
+	case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:		return "discrete";
+	case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:	return "integrated";
+	case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:		return "virtual";
+	case VK_PHYSICAL_DEVICE_TYPE_CPU:				return "cpu";
+	default:										return "other";
+	}
+}
@@ -0,0 +1,51 @@
+#ifndef __DeviceSelector_h__
+#define __DeviceSelector_h__
+
+#pragma once
+
+#include "Pch.h"
+
+// Ranks the physical devices that can run the application instead of taking
+// the first one. The score favours discrete over integrated GPUs, then the
+// size of the largest device local heap, dedicated transfer and compute
+// queues and optional features.
+//
+// A selector, a device name (or part of it, case insensitive) or a UUID as
+// printed in the log, overrides the ranking. Software rasterizers are only
+// considered when allowed explicitly, and are ranked below everything else.
+class DeviceSelector
+{
+public:
+	struct Candidate
+	{
+		VkPhysicalDevice device = VK_NULL_HANDLE;
+		VkPhysicalDeviceProperties properties{};
+		Astr uuid;
+		VkDeviceSize deviceLocalBytes { 0 };
+
+		// Filled in by the caller, which knows what the application needs.
+		bool suitable { false };
+		bool dedicatedTransferQueue { false };
+		bool dedicatedComputeQueue { false };
+
+		int64_t score { 0 };
+	};
+
+	// Reads the properties the score depends on.
+	static Candidate describe(VkPhysicalDevice device);
+
+	// Picks the best suitable candidate, or the best one matching selector
+	// when it is not empty, logging every candidate and the choice. Throws
+	// when there is none.
+	static const Candidate& select(Avec<Candidate>& candidates, const Astr& selector, bool allowSoftware);
+
+	static bool matches(const Candidate& candidate, const Astr& selector);
+
+	static Astr formatUuid(const uint8_t uuid[VK_UUID_SIZE]);
+
+private:
+	static int64_t score(const Candidate& candidate);
+	static const char* typeName(VkPhysicalDeviceType type);
+};
+
+#endif
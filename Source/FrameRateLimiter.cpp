@@ -0,0 +1,41 @@
+#include "Pch.h"
+#include "FrameRateLimiter.h"
+
+void FrameRateLimiter::setMaxFrameRate(double framesPerSecond)
+{
+	maxFrameRate = std::max(framesPerSecond, 0.0);
+	interval = maxFrameRate > 0.0
+		? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / maxFrameRate))
+		: Clock::duration::zero();
+	nextFrame = Clock::now();
+}
+
+void FrameRateLimiter::wait()
+{
+	if (interval == Clock::duration::zero())
+	{
+		return;
+	}
+
+	Clock::time_point due = nextFrame;
+	Clock::time_point now = Clock::now();
+
+	if (now < due)
+	{
+		if (due - now > SPIN_THRESHOLD)
+		{
+			std::this_thread::sleep_for(due - now - SPIN_THRESHOLD);
+		}
+
+		while (Clock::now() < due)
+		{
+			std::this_thread::yield();
+		}
+
+		now = Clock::now();
+	}
+
+	// More than a frame behind, after idling in on-demand mode or a stall:
+	// start over instead of rendering the missed frames back to back.
+	nextFrame = now - due > interval ? now + interval : due + interval;
+}
@@ -0,0 +1,36 @@
+#ifndef __FrameRateLimiter_h__
+#define __FrameRateLimiter_h__
+
+#pragma once
+
+#include "Pch.h"
+
+// Caps the rate frames start at. wait() sleeps until the next frame is due:
+// most of the way with the OS sleep, which may oversleep by a scheduler
+// tick, and the last SPIN_THRESHOLD by yielding in a loop. Frames are
+// scheduled from when the previous one was due, not when it started, so the
+// average rate holds when a wake-up is late.
+class FrameRateLimiter
+{
+public:
+	static constexpr std::chrono::microseconds SPIN_THRESHOLD { 2000 };
+
+	// 0 disables the cap.
+	void setMaxFrameRate(double framesPerSecond);
+
+	double getMaxFrameRate() const
+	{
+		return maxFrameRate;
+	}
+
+	void wait();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	double maxFrameRate { 0.0 };
+	Clock::duration interval { 0 };
+	Clock::time_point nextFrame;
+};
+
+#endif
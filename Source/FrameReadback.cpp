@@ -0,0 +1,242 @@
+#include "Pch.h"
+#include "FrameReadback.h"
+
+void FrameReadback::create(VkDevice device, DeviceAllocator& allocator, VkExtent2D extent, VkFormat format, uint32_t slotCount, uint32_t encoderThreadCount)
+{
+	if (!ImageEncoder::isSupported(format))
+	{
+		throw std::runtime_error("Frame readback does not support the swap chain format.");
+	}
+
+	this->device = device;
+	this->allocator = &allocator;
+	this->extent = extent;
+	this->format = format;
+
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	// Cached memory, the CPU reads every byte and uncached reads are slow.
+	AllocationCreateInfo allocInfo{};
+	allocInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	allocInfo.preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+	for (uint32_t i = 0; i < slotCount; i++)
+	{
+		Slot& slot = slots.emplace_back();
+
+		if (vkCreateBuffer(device, &bufferInfo, nullptr, &slot.buffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create readback buffer.");
+		}
+
+		slot.allocation = allocator.allocateForBuffer(slot.buffer, allocInfo);
+	}
+
+	VkMemoryPropertyFlags flags = allocator.getMemoryProperties().memoryTypes[slots[0].allocation.memoryTypeIndex].propertyFlags;
+	coherent = (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+	stopping = false;
+
+	for (uint32_t i = 0; i < encoderThreadCount; i++)
+	{
+		encoders.emplace_back(&FrameReadback::encoderLoop, this);
+	}
+}
+
+void FrameReadback::destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+
+	wakeCondition.notify_all();
+
+	for (auto& encoder : encoders)
+	{
+		encoder.join();
+	}
+
+	encoders.clear();
+
+	for (auto& slot : slots)
+	{
+		vkDestroyBuffer(device, slot.buffer, nullptr);
+		allocator->free(slot.allocation);
+	}
+
+	slots.clear();
+}
+
+void FrameReadback::addConsumer(const Consumer& consumer)
+{
+	consumers.push_back(consumer);
+}
+
+void FrameReadback::setCapture(const Astr& directory, ImageFileFormat fileFormat, uint32_t interval)
+{
+	captureDirectory = directory;
+	captureFormat = fileFormat;
+	captureInterval = directory.empty() ? 0 : interval;
+
+	if (captureInterval != 0)
+	{
+		std::filesystem::create_directories(captureDirectory);
+	}
+}
+
+void FrameReadback::beginFrame(uint32_t slot, uint64_t frameNumber)
+{
+	Slot& current = slots[slot];
+
+	// The encoder still reads the memory the copy would overwrite.
+	if (current.encoding.load(std::memory_order_acquire))
+	{
+		current.copying = false;
+		droppedFrames++;
+		return;
+	}
+
+	current.frameNumber = frameNumber;
+	current.copying = true;
+}
+
+void FrameReadback::recordCopy(VkCommandBuffer commandBuffer, VkImage image, uint32_t slot)
+{
+	if (!slots[slot].copying)
+	{
+		return;
+	}
+
+	VkBufferImageCopy region{};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { extent.width, extent.height, 1 };
+
+	vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slots[slot].buffer, 1, &region);
+}
+
+void FrameReadback::collect(uint32_t slot)
+{
+	Slot& current = slots[slot];
+
+	if (!current.copying)
+	{
+		return;
+	}
+
+	current.copying = false;
+	invalidate(current);
+
+	FrameView view{};
+	view.pixels = static_cast<const uint8_t*>(current.allocation.mapped);
+	view.width = extent.width;
+	view.height = extent.height;
+	view.rowPitch = extent.width * 4;
+	view.format = format;
+	view.frameNumber = current.frameNumber;
+
+	for (const auto& consumer : consumers)
+	{
+		consumer(view);
+	}
+
+	if (captureInterval == 0 || current.frameNumber % captureInterval != 0 || encoders.empty())
+	{
+		return;
+	}
+
+	current.encoding.store(true, std::memory_order_release);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back({ &current, current.frameNumber });
+	}
+
+	wakeCondition.notify_one();
+}
+
+void FrameReadback::collectAll()
+{
+	for (uint32_t slot = 0; slot < slots.size(); slot++)
+	{
+		collect(slot);
+	}
+}
+
+void FrameReadback::invalidate(const Slot& slot)
+{
+	if (coherent)
+	{
+		return;
+	}
+
+	// The allocator places non-coherent allocations on whole atoms, so the
+	// allocation itself is a valid range.
+	VkMappedMemoryRange range{};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = slot.allocation.memory;
+	range.offset = slot.allocation.offset;
+	range.size = slot.allocation.size;
+
+	vkInvalidateMappedMemoryRanges(device, 1, &range);
+}
+
+void FrameReadback::encoderLoop()
+{
+	for (;;)
+	{
+		EncodeJob job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeCondition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+			// Queued frames are still written when stopping.
+			if (jobs.empty())
+			{
+				return;
+			}
+
+			job = jobs.front();
+			jobs.pop_front();
+		}
+
+		// The slot is free for the next copy as soon as its pixels are
+		// converted, writing the file works on the converted copy.
+		const uint8_t* pixels = static_cast<const uint8_t*>(job.slot->allocation.mapped);
+		Avec<uint8_t> rgba = ImageEncoder::toRgba8(pixels, extent.width, extent.height, extent.width * 4, format);
+		job.slot->encoding.store(false, std::memory_order_release);
+
+		try {
+			write(job.frameNumber, rgba);
+		}
+		catch (const std::exception& e) {
+			std::cerr << e.what() << '\n';
+		}
+	}
+}
+
+void FrameReadback::write(uint64_t frameNumber, const Avec<uint8_t>& rgba)
+{
+	std::ostringstream name;
+	name << "frame_" << std::setw(6) << std::setfill('0') << frameNumber;
+
+	if (captureFormat == ImageFileFormat::Raw)
+	{
+		name << '_' << extent.width << 'x' << extent.height;
+	}
+
+	name << '.' << ImageEncoder::getExtension(captureFormat);
+
+	ImageEncoder::write((std::filesystem::path(captureDirectory) / name.str()).string(), captureFormat, rgba.data(), extent.width, extent.height);
+}
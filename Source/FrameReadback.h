@@ -0,0 +1,117 @@
+#ifndef __FrameReadback_h__
+#define __FrameReadback_h__
+
+#pragma once
+
+#include "Pch.h"
+#include "DeviceAllocator.h"
+#include "ImageEncoder.h"
+
+// Pixels of a finished frame, pointing straight into mapped readback memory.
+// Only valid during the consumer call.
+struct FrameView
+{
+	const uint8_t* pixels;
+	uint32_t width;
+	uint32_t height;
+	uint32_t rowPitch;
+	VkFormat format;
+	uint64_t frameNumber;
+};
+
+// Copies rendered frames into host visible buffers, one per frame slot, and
+// hands them out once the frame has finished on the GPU: to consumers on the
+// render thread without copying, and to encoder threads that write image
+// files. Nothing waits on the GPU or on the encoders. A slot whose previous
+// frame is still being encoded skips its copy and the frame is counted as
+// dropped.
+//
+// Per frame slot, once the GPU is done with it: collect(slot), beginFrame(),
+// then recordCopy() within the frame.
+class FrameReadback
+{
+public:
+	using Consumer = std::function<void(const FrameView&)>;
+
+	void create(VkDevice device, DeviceAllocator& allocator, VkExtent2D extent, VkFormat format, uint32_t slotCount, uint32_t encoderThreadCount);
+
+	// Waits for the encoders to finish. Frames copied but not collected are
+	// dropped, collectAll() first after the device is idle to keep them.
+	void destroy();
+
+	void addConsumer(const Consumer& consumer);
+
+	// Writes every interval-th collected frame to directory, 0 disables it.
+	void setCapture(const Astr& directory, ImageFileFormat fileFormat, uint32_t interval);
+
+	void beginFrame(uint32_t slot, uint64_t frameNumber);
+
+	// The image has to be in TRANSFER_SRC_OPTIMAL and the buffer of the
+	// slot ready for transfer writes.
+	void recordCopy(VkCommandBuffer commandBuffer, VkImage image, uint32_t slot);
+
+	// Delivers the frame copied in slot, which must have finished on the GPU.
+	void collect(uint32_t slot);
+	void collectAll();
+
+	VkBuffer getBuffer(uint32_t slot) const
+	{
+		return slots[slot].buffer;
+	}
+
+	bool isCreated() const
+	{
+		return !slots.empty();
+	}
+
+	uint64_t getDroppedFrameCount() const
+	{
+		return droppedFrames;
+	}
+
+private:
+	struct Slot
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		Allocation allocation;
+
+		uint64_t frameNumber { 0 };
+		bool copying { false };
+
+		// Set while an encoder reads the mapped memory.
+		std::atomic<bool> encoding { false };
+	};
+
+	struct EncodeJob
+	{
+		Slot* slot;
+		uint64_t frameNumber;
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	DeviceAllocator* allocator = nullptr;
+
+	VkExtent2D extent{};
+	VkFormat format { VK_FORMAT_UNDEFINED };
+	bool coherent { true };
+
+	std::deque<Slot> slots;
+	Avec<Consumer> consumers;
+	uint64_t droppedFrames { 0 };
+
+	Astr captureDirectory;
+	ImageFileFormat captureFormat { ImageFileFormat::Png };
+	uint32_t captureInterval { 0 };
+
+	Avec<std::thread> encoders;
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::deque<EncodeJob> jobs;
+	bool stopping { false };
+
+	void invalidate(const Slot& slot);
+	void encoderLoop();
+	void write(uint64_t frameNumber, const Avec<uint8_t>& rgba);
+};
+
+#endif
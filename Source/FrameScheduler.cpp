@@ -0,0 +1,194 @@
+#include "Pch.h"
+#include "FrameScheduler.h"
+
+void FrameScheduler::create(VkDevice device, uint32_t slotCount, uint32_t framesInFlight)
+{
+	if (slotCount == 0)
+	{
+		throw std::runtime_error("Frame scheduler needs at least one frame slot.");
+	}
+
+	this->device = device;
+
+	slotValues.assign(slotCount, {});
+	frameNumber = 0;
+
+	setFramesInFlight(framesInFlight);
+}
+
+void FrameScheduler::destroy()
+{
+	for (auto& queue : queues)
+	{
+		vkDestroySemaphore(device, queue.semaphore, nullptr);
+	}
+
+	queues.clear();
+	slotValues.clear();
+}
+
+uint32_t FrameScheduler::addQueue(VkQueue queue)
+{
+	VkSemaphoreTypeCreateInfo typeInfo{};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = &typeInfo;
+
+	Queue entry{};
+	entry.queue = queue;
+
+	if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &entry.semaphore) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create timeline semaphore.");
+	}
+
+	queues.push_back(entry);
+
+	for (auto& values : slotValues)
+	{
+		values.push_back(0);
+	}
+
+	return static_cast<uint32_t>(queues.size() - 1);
+}
+
+uint32_t FrameScheduler::beginFrame()
+{
+	// The slot about to be reused belongs to a frame at least as old as the
+	// one waited on, and timelines only move forward, so it is free as well.
+	if (frameNumber >= framesInFlight)
+	{
+		wait(slotValues[(frameNumber + 1 - framesInFlight) % slotValues.size()]);
+	}
+
+	frameNumber++;
+
+	// Work submitted between frames is accounted to the frame that follows.
+	Avec<uint64_t>& values = slotValues[getCurrentSlot()];
+
+	for (size_t i = 0; i < queues.size(); i++)
+	{
+		values[i] = queues[i].submittedValue;
+	}
+
+	return getCurrentSlot();
+}
+
+uint64_t FrameScheduler::submit(uint32_t queueIndex, const VkSubmitInfo& submitInfo, const Avec<TimelineWait>& timelineWaits)
+{
+	Queue& queue = queues[queueIndex];
+
+	Avec<VkSemaphore> waitSemaphores(submitInfo.pWaitSemaphores, submitInfo.pWaitSemaphores + submitInfo.waitSemaphoreCount);
+	Avec<VkPipelineStageFlags> waitStages(submitInfo.pWaitDstStageMask, submitInfo.pWaitDstStageMask + submitInfo.waitSemaphoreCount);
+	// Values of binary semaphores are ignored.
+	Avec<uint64_t> waitValues(submitInfo.waitSemaphoreCount, 0);
+
+	for (const auto& timelineWait : timelineWaits)
+	{
+		waitSemaphores.push_back(queues[timelineWait.queueIndex].semaphore);
+		waitStages.push_back(timelineWait.stageMask);
+		waitValues.push_back(timelineWait.value);
+	}
+
+	uint64_t value = queue.submittedValue + 1;
+
+	Avec<VkSemaphore> signalSemaphores(submitInfo.pSignalSemaphores, submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+	Avec<uint64_t> signalValues(submitInfo.signalSemaphoreCount, 0);
+
+	signalSemaphores.push_back(queue.semaphore);
+	signalValues.push_back(value);
+
+	VkTimelineSemaphoreSubmitInfo timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineInfo.pNext = submitInfo.pNext;
+	timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+	timelineInfo.pWaitSemaphoreValues = waitValues.data();
+	timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+	timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+	VkSubmitInfo info = submitInfo;
+	info.pNext = &timelineInfo;
+	info.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+	info.pWaitSemaphores = waitSemaphores.data();
+	info.pWaitDstStageMask = waitStages.data();
+	info.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+	info.pSignalSemaphores = signalSemaphores.data();
+
+	if (vkQueueSubmit(queue.queue, 1, &info, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to submit command buffer.");
+	}
+
+	queue.submittedValue = value;
+
+	if (!slotValues.empty())
+	{
+		slotValues[getCurrentSlot()][queueIndex] = value;
+	}
+
+	return value;
+}
+
+uint64_t FrameScheduler::getCompletedValue(uint32_t queueIndex) const
+{
+	uint64_t value = 0;
+
+	if (vkGetSemaphoreCounterValue(device, queues[queueIndex].semaphore, &value) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to query timeline semaphore.");
+	}
+
+	return value;
+}
+
+void FrameScheduler::waitIdle()
+{
+	Avec<uint64_t> values;
+
+	for (const auto& queue : queues)
+	{
+		values.push_back(queue.submittedValue);
+	}
+
+	wait(values);
+}
+
+void FrameScheduler::setFramesInFlight(uint32_t framesInFlight)
+{
+	this->framesInFlight = std::clamp(framesInFlight, 1u, static_cast<uint32_t>(slotValues.size()));
+}
+
+void FrameScheduler::wait(const Avec<uint64_t>& values)
+{
+	Avec<VkSemaphore> semaphores;
+	Avec<uint64_t> waitValues;
+
+	for (size_t i = 0; i < queues.size(); i++)
+	{
+		if (values[i] > 0)
+		{
+			semaphores.push_back(queues[i].semaphore);
+			waitValues.push_back(values[i]);
+		}
+	}
+
+	if (semaphores.empty())
+	{
+		return;
+	}
+
+	VkSemaphoreWaitInfo waitInfo{};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = static_cast<uint32_t>(semaphores.size());
+	waitInfo.pSemaphores = semaphores.data();
+	waitInfo.pValues = waitValues.data();
+
+	if (vkWaitSemaphores(device, &waitInfo, UINT64_MAX) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to wait for timeline semaphores.");
+	}
+}
@@ -0,0 +1,114 @@
+#ifndef __FrameScheduler_h__
+#define __FrameScheduler_h__
+
+#pragma once
+
+#include "Pch.h"
+
+// Paces frames with one timeline semaphore per queue instead of a fence per
+// frame. Every submission through the scheduler signals the next value of its
+// queue's timeline, and each frame remembers the last value it signalled on
+// every queue, so starting a frame is a single host wait on all of the
+// timelines at once.
+//
+// Per-frame resources are indexed by slot. There are slotCount slots, fixed
+// at creation, while the number of frames in flight can be changed at any
+// time between 1 and slotCount.
+class FrameScheduler
+{
+public:
+	// Makes a submission wait until another queue's timeline reached value.
+	struct TimelineWait
+	{
+		uint32_t queueIndex;
+		uint64_t value;
+		VkPipelineStageFlags stageMask;
+	};
+
+	void create(VkDevice device, uint32_t slotCount, uint32_t framesInFlight);
+	void destroy();
+
+	// Creates the timeline of a queue and returns the index submissions to
+	// it are made with.
+	uint32_t addQueue(VkQueue queue);
+
+	// Waits until the frame framesInFlight frames back has finished on every
+	// queue, then starts the next frame and returns its slot.
+	uint32_t beginFrame();
+
+	// Submits to a queue, additionally signalling its timeline. Binary
+	// semaphores in submitInfo are passed through. Returns the value that
+	// is reached once the submission has finished.
+	uint64_t submit(uint32_t queueIndex, const VkSubmitInfo& submitInfo, const Avec<TimelineWait>& timelineWaits = {});
+
+	// Last value the GPU reached on a queue's timeline, does not block.
+	uint64_t getCompletedValue(uint32_t queueIndex) const;
+
+	bool isComplete(uint32_t queueIndex, uint64_t value) const
+	{
+		return getCompletedValue(queueIndex) >= value;
+	}
+
+	uint64_t getSubmittedValue(uint32_t queueIndex) const
+	{
+		return queues[queueIndex].submittedValue;
+	}
+
+	uint32_t getQueueCount() const
+	{
+		return static_cast<uint32_t>(queues.size());
+	}
+
+	// Blocks until everything submitted through the scheduler has finished.
+	void waitIdle();
+
+	void setFramesInFlight(uint32_t framesInFlight);
+
+	uint32_t getFramesInFlight() const
+	{
+		return framesInFlight;
+	}
+
+	uint32_t getSlotCount() const
+	{
+		return static_cast<uint32_t>(slotValues.size());
+	}
+
+	uint32_t getCurrentSlot() const
+	{
+		return static_cast<uint32_t>(frameNumber % slotValues.size());
+	}
+
+	uint64_t getFrameNumber() const
+	{
+		return frameNumber;
+	}
+
+	VkSemaphore getSemaphore(uint32_t queueIndex) const
+	{
+		return queues[queueIndex].semaphore;
+	}
+
+private:
+	struct Queue
+	{
+		VkQueue queue;
+		VkSemaphore semaphore;
+		uint64_t submittedValue { 0 };
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+
+	Avec<Queue> queues;
+
+	// Timeline values each slot's frame has to reach on every queue,
+	// indexed [slot][queueIndex].
+	Avec<Avec<uint64_t>> slotValues;
+
+	uint32_t framesInFlight { 1 };
+	uint64_t frameNumber { 0 };
+
+	void wait(const Avec<uint64_t>& values);
+};
+
+#endif
@@ -0,0 +1,3365 @@
+#include "Pch.h"
+#include "HelloTriangleApplication.h"
+#include "MeshImporter.h"
+#include "MeshProcessor.h"
+#include "DeviceSelector.h"
+
+// Generated at build time from Shaders/ by glslc and CMake/EmbedSpirv.cmake.
+#include "Shaders/DefaultShader.vert.h"
+#include "Shaders/DefaultShader.frag.h"
+#include "Shaders/Cull.comp.h"
+#include "Shaders/DepthPyramid.comp.h"
+
+namespace
+{
+	VkResult CreateDebugUtilsMessengerEXT(
+		VkInstance instance,
+		const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
+		const VkAllocationCallbacks* pAllocator,
+		VkDebugUtilsMessengerEXT* pDebugMessenger
+	)
+	{
+		auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
+		if (func != nullptr)
+		{
+			return func(instance, pCreateInfo, pAllocator, pDebugMessenger);
+		}
+		else
+		{
+			return VK_ERROR_EXTENSION_NOT_PRESENT;
+		}
+	}
+
+	void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* pAllocator)
+	{
+		auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
+
+		if (func != nullptr)
+		{
+			func(instance, debugMessenger, pAllocator);
+		}
+	}
+}
+
+void HelloTriangleApplication::markDirty(uint32_t reasons)
+{
+	if (dirtyFlags.fetch_or(reasons) == 0 && windowsCreated.load())
+	{
+		glfwPostEmptyEvent();
+	}
+}
+
+Avec<std::pair<Astr, ShaderCode>> HelloTriangleApplication::getEmbeddedShaders()
+{
+	return {
+		{ "DefaultShader.vert", embeddedShader(EmbeddedShaders::DefaultShader_vert) },
+		{ "DefaultShader.frag", embeddedShader(EmbeddedShaders::DefaultShader_frag) },
+		{ "Cull.comp", embeddedShader(EmbeddedShaders::Cull_comp) },
+		{ "DepthPyramid.comp", embeddedShader(EmbeddedShaders::DepthPyramid_comp) },
+	};
+}
+
+void HelloTriangleApplication::run()
+{
+	if (settings.headless)
+	{
+		views.resize(std::max(settings.viewCount, 1u));
+	}
+	else
+	{
+		initWindow();
+	}
+
+	initVulkan();
+	mainLoop();
+	cleanUp();
+}
+
+void HelloTriangleApplication::initWindow()
+{
+	glfwInit();
+
+	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	//glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+
+	if (settings.viewPerMonitor)
+	{
+		int monitorCount = 0;
+		GLFWmonitor** monitors = glfwGetMonitors(&monitorCount);
+
+		for (int i = 0; i < monitorCount; i++)
+		{
+			const GLFWvidmode* mode = glfwGetVideoMode(monitors[i]);
+			addWindow(glfwCreateWindow(mode->width, mode->height, TITLE, monitors[i], nullptr));
+		}
+
+		if (views.empty())
+		{
+			throw std::runtime_error("No monitor to create a view on.");
+		}
+	}
+	else
+	{
+		for (uint32_t i = 0; i < std::max(settings.viewCount, 1u); i++)
+		{
+			addWindow(glfwCreateWindow(WIDTH, HEIGHT, TITLE, nullptr, nullptr));
+		}
+	}
+
+	windowsCreated = true;
+}
+
+void HelloTriangleApplication::addWindow(GLFWwindow* window)
+{
+	if (window == nullptr)
+	{
+		throw std::runtime_error("Failed to create window.");
+	}
+
+	glfwSetWindowUserPointer(window, this);
+	glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+	glfwSetWindowRefreshCallback(window, windowRefreshCallback);
+	glfwSetKeyCallback(window, keyCallback);
+	glfwSetCursorPosCallback(window, cursorPosCallback);
+	glfwSetMouseButtonCallback(window, mouseButtonCallback);
+	glfwSetScrollCallback(window, scrollCallback);
+
+	View view;
+	view.window = window;
+	views.push_back(std::move(view));
+}
+
+HelloTriangleApplication::View* HelloTriangleApplication::findView(GLFWwindow* window)
+{
+	for (auto& view : views)
+	{
+		if (view.window == window)
+		{
+			return &view;
+		}
+	}
+
+	return nullptr;
+}
+
+void HelloTriangleApplication::framebufferResizeCallback(GLFWwindow* window, int width, int height)
+{
+	auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+
+	if (View* view = app->findView(window))
+	{
+		view->resized = true;
+	}
+
+	app->markDirty(DIRTY_RESIZE);
+}
+
+void HelloTriangleApplication::windowRefreshCallback(GLFWwindow* window)
+{
+	auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+	app->markDirty(DIRTY_RESIZE);
+}
+
+void HelloTriangleApplication::cursorPosCallback(GLFWwindow* window, double x, double y)
+{
+	auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+	app->markDirty(DIRTY_INPUT);
+}
+
+void HelloTriangleApplication::mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+	auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+	app->markDirty(DIRTY_INPUT);
+}
+
+void HelloTriangleApplication::scrollCallback(GLFWwindow* window, double x, double y)
+{
+	auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+	app->markDirty(DIRTY_INPUT);
+}
+
+void HelloTriangleApplication::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	if (action != GLFW_PRESS)
+	{
+		return;
+	}
+
+	auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+	app->markDirty(DIRTY_INPUT);
+
+	if (key == GLFW_KEY_V)
+	{
+		constexpr VkDebugUtilsMessageSeverityFlagsEXT chatty = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
+		app->debugLog.setSeverities(app->debugLog.getSeverities() ^ chatty);
+
+		AMlog("Verbose validation messages: " << ((app->debugLog.getSeverities() & chatty) != 0 ? "on" : "off"));
+		return;
+	}
+
+	if (key < GLFW_KEY_1 || key > GLFW_KEY_9)
+	{
+		return;
+	}
+
+	app->setFramesInFlight(static_cast<uint32_t>(key - GLFW_KEY_1 + 1));
+
+	AMlog("Frames in flight: " << app->frameScheduler.getFramesInFlight());
+}
+
+void HelloTriangleApplication::cleanUpSwapChain(View& view)
+{
+	for (size_t i = 0; i < view.swapChainImageViews.size(); i++)
+	{
+		vkDestroyImageView(device, view.swapChainImageViews[i], nullptr);
+	}
+
+	if (settings.headless)
+	{
+		for (size_t i = 0; i < view.swapChainImages.size(); i++)
+		{
+			vkDestroyImage(device, view.swapChainImages[i], nullptr);
+			allocator.free(view.offscreenImageAllocations[i]);
+		}
+	}
+	else if (view.swapChain != VK_NULL_HANDLE)
+	{
+		vkDestroySwapchainKHR(device, view.swapChain, nullptr);
+	}
+}
+
+void HelloTriangleApplication::recreateSwapChains()
+{
+	if (std::none_of(views.begin(), views.end(), [](const View& view) { return view.resized; }))
+	{
+		return;
+	}
+
+	VkFormat oldFormat = colorFormat;
+
+	// Retired first, its framebuffers are destroyed before the image
+	// views they were created from.
+	retireRenderGraph();
+
+	for (uint32_t i = 0; i < views.size(); i++)
+	{
+		View& view = views[i];
+
+		if (!view.resized)
+		{
+			continue;
+		}
+
+		view.resized = false;
+
+		int width = 0, height = 0;
+		glfwGetFramebufferSize(view.window, &width, &height);
+
+		// The old swap chain is handed to the new one so the
+		// presentation engine can reuse its resources.
+		VkSwapchainKHR oldSwapChain = view.swapChain;
+		retireSwapChain(view);
+
+		view.active = width > 0 && height > 0;
+
+		if (view.active)
+		{
+			createSwapChain(view, oldSwapChain);
+			createImageViews(view);
+		}
+
+		// Frames still in the old readback buffers go out once complete.
+		if (i == 0 && frameReadback)
+		{
+			std::shared_ptr<FrameReadback> oldReadback = std::move(frameReadback);
+
+			deletionQueue.retire([oldReadback]()
+			{
+				oldReadback->collectAll();
+				oldReadback->destroy();
+			});
+		}
+
+		if (i == 0 && view.active && isReadbackEnabled())
+		{
+			createFrameReadback();
+		}
+	}
+
+	buildRenderGraph();
+
+	// A surface format change is the only thing that breaks render pass
+	// compatibility, or the formats of a pipeline for dynamic rendering,
+	// which basically never happens on a resize.
+	if (colorFormat != oldFormat)
+	{
+		VkPipeline oldPipeline = graphicsPipeline;
+		deletionQueue.retire([this, oldPipeline]()
+		{
+			vkDestroyPipeline(device, oldPipeline, nullptr);
+		});
+
+		createGraphicsPipeline();
+	}
+}
+
+void HelloTriangleApplication::retireSwapChain(View& view)
+{
+	Avec<VkImageView> oldImageViews = std::move(view.swapChainImageViews);
+	view.swapChainImageViews.clear();
+	view.swapChainImages.clear();
+
+	VkSwapchainKHR oldSwapChain = view.swapChain;
+	view.swapChain = VK_NULL_HANDLE;
+
+	deletionQueue.retire([this, oldImageViews, oldSwapChain]()
+	{
+		for (VkImageView imageView : oldImageViews)
+		{
+			vkDestroyImageView(device, imageView, nullptr);
+		}
+
+		if (oldSwapChain != VK_NULL_HANDLE)
+		{
+			vkDestroySwapchainKHR(device, oldSwapChain, nullptr);
+		}
+	});
+}
+
+void HelloTriangleApplication::retireRenderGraph()
+{
+	// The sampled view of the depth buffer goes with the graph that owns it.
+	if (depthTextureIndex != UINT32_MAX)
+	{
+		uint32_t oldIndex = depthTextureIndex;
+		depthTextureIndex = UINT32_MAX;
+
+		deletionQueue.retire([this, oldIndex]()
+		{
+			descriptorHeap.remove(DescriptorHeap::Kind::SampledImage, oldIndex);
+		});
+	}
+
+	std::shared_ptr<RenderGraph> oldGraph = std::make_shared<RenderGraph>(std::move(renderGraph));
+	renderGraph = RenderGraph();
+
+	deletionQueue.retire([this, oldGraph]()
+	{
+		if (pipelineReload.valid())
+		{
+			oldGraph->clearFramebuffers();
+			reloadRetiredGraphs.push_back(oldGraph);
+			return;
+		}
+
+		oldGraph->reset();
+	});
+}
+
+void HelloTriangleApplication::initVulkan()
+{
+	if (!settings.shaderPackPath.empty())
+	{
+		shaderPack = std::make_unique<ShaderPack>(settings.shaderPackPath);
+	}
+
+	if (enableValidationLayers)
+	{
+		debugLog.start(settings.debugLog);
+	}
+
+	// First, a mesh that fails to load should not wait for device creation.
+	createGeometry();
+
+	createInstance();
+	setupDebugMessenger();
+
+	if (!settings.headless)
+	{
+		createSurfaces();
+	}
+
+	pickPhysicalDevice();
+	chooseAttachmentFormats();
+	createLogicalDevice();
+	allocator.create(physicalDevice, device);
+	// Big enough for the initial uploads, which all happen before the first frame.
+	stagingRing.create(device, physicalDevice, allocator, std::max(STAGING_RING_SIZE, getInitialUploadSize()), getFrameSlotCount());
+	descriptorHeap.create(device, physicalDevice);
+	uniformRing.create(device, physicalDevice, allocator, UNIFORM_RING_SLOT_SIZE, getFrameSlotCount(), MAX_UNIFORM_BLOCK_SIZE, isCullOnComputeQueue() ? Avec<uint32_t>{ graphicsFamily, computeFamily } : Avec<uint32_t>{});
+
+	if (settings.occlusionCulling)
+	{
+		createDepthSampler();
+	}
+
+	if (settings.enableProfiler || !settings.profileDirectory.empty())
+	{
+		profiler.setHistorySize(settings.profileHistorySize);
+		profiler.create(physicalDevice, device, graphicsFamily, getFrameSlotCount());
+	}
+	pipelineCache.create(device, physicalDevice, PIPELINE_CACHE_DIRECTORY);
+
+	for (auto& view : views)
+	{
+		if (settings.headless)
+		{
+			createOffscreenTargets(view);
+		}
+		else
+		{
+			createSwapChain(view);
+		}
+
+		createImageViews(view);
+		view.active = true;
+	}
+
+	if (isReadbackEnabled())
+	{
+		createFrameReadback();
+	}
+
+	buildRenderGraph();
+	createPipelineLayout();
+	createGraphicsPipeline();
+	createComputePipelines();
+	createFrameCommands();
+	createVertexBuffer();
+	createIndexBuffer();
+	releaseGeometry();
+	createInstanceBuffer();
+	createCullingBuffers();
+	createSyncObjects();
+
+	if (!settings.shaderSourceDirectory.empty())
+	{
+		shaderWatcher.start(settings.shaderSourceDirectory, settings.shaderCompiler, [this]() { markDirty(DIRTY_RESOURCES); });
+		AMlog("Shader reload: watching " << settings.shaderSourceDirectory);
+	}
+}
+
+void HelloTriangleApplication::createSyncObjects()
+{
+	uint32_t slotCount = getFrameSlotCount();
+
+	frameScheduler.create(device, slotCount, settings.framesInFlight);
+	graphicsTimeline = frameScheduler.addQueue(graphicsQueue);
+	transferTimeline = transferQueue != graphicsQueue ? frameScheduler.addQueue(transferQueue) : graphicsTimeline;
+	computeTimeline = computeQueue == graphicsQueue ? graphicsTimeline : computeQueue == transferQueue ? transferTimeline : frameScheduler.addQueue(computeQueue);
+	deletionQueue.create(frameScheduler);
+
+	renderFinishedSemaphores.resize(slotCount);
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	for (size_t i = 0; i < slotCount; i++)
+	{
+		if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS)
+		{
+
+			throw std::runtime_error("failed to create semaphores for a frame!");
+		}
+	}
+
+	for (auto& view : views)
+	{
+		view.imageAvailableSemaphores.resize(slotCount);
+
+		for (size_t i = 0; i < slotCount; i++)
+		{
+			if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &view.imageAvailableSemaphores[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create semaphores for a frame!");
+			}
+		}
+	}
+}
+
+void HelloTriangleApplication::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const AllocationCreateInfo& allocInfo, VkBuffer& buffer, Allocation& allocation)
+{
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create buffer.");
+	}
+
+	allocation = allocator.allocateForBuffer(buffer, allocInfo);
+}
+
+void HelloTriangleApplication::destroyBuffer(VkBuffer buffer, const Allocation& allocation)
+{
+	vkDestroyBuffer(device, buffer, nullptr);
+	allocator.free(allocation);
+}
+
+void HelloTriangleApplication::createDeviceLocalBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, Allocation& allocation, uint32_t dstFamily)
+{
+	AllocationCreateInfo allocInfo{};
+	allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	createBuffer(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, allocInfo, buffer, allocation);
+
+	if (!stagingRing.upload(buffer, 0, data, size, dstFamily))
+	{
+		throw std::runtime_error("Buffer does not fit into the staging ring.");
+	}
+
+	markDirty(DIRTY_RESOURCES);
+}
+
+void HelloTriangleApplication::createGeometry()
+{
+	// Instances are drawn on top of each other, like before they had data.
+	instances.assign(std::max(settings.instanceCount, 1u), glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+
+	drawCommands.clear();
+	cullObjects.clear();
+
+	if (settings.meshPath.empty())
+	{
+		createTriangleGrid();
+	}
+	else
+	{
+		loadMesh(settings.meshPath);
+	}
+}
+
+void HelloTriangleApplication::createTriangleGrid()
+{
+	uint32_t triangleCount = std::max(settings.triangleCount, 1u);
+	uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(triangleCount))));
+	float cellSize = 2.0f / columns;
+
+	// The shader colors with the texture coordinates, red, green and
+	// blue at the corners.
+	const glm::vec2 uvs[] = {
+		{ 1.0f, 0.0f },
+		{ 0.0f, 1.0f },
+		{ 0.0f, 0.0f }
+	};
+
+	const glm::vec2 corners[] = {
+		{ 0.0f, -0.5f },
+		{ 0.5f, 0.5f },
+		{ -0.5f, 0.5f }
+	};
+
+	Avec<MeshVertex> vertices;
+	vertices.reserve(triangleCount * 3);
+	mesh.indices.clear();
+	mesh.indices.reserve(triangleCount * 3);
+
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		glm::vec2 center {
+			-1.0f + cellSize * (i % columns + 0.5f),
+			-1.0f + cellSize * (i / columns + 0.5f)
+		};
+
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			MeshVertex vertex;
+			vertex.position = glm::vec3(center + corners[corner] * cellSize, 0.0f);
+			vertex.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+			vertex.uv = uvs[corner];
+
+			mesh.indices.push_back(static_cast<uint32_t>(vertices.size()));
+			vertices.push_back(vertex);
+		}
+	}
+
+	// Already in clip space, dequantizing is all there is to do.
+	mesh.vertices = MeshProcessor::quantize(vertices, mesh.positionScale, mesh.positionOffset);
+	geometry = mesh.getView();
+
+	drawPushConstants.positionScale = glm::vec4(mesh.positionScale, 0.0f);
+	drawPushConstants.positionOffset = glm::vec4(mesh.positionOffset, 0.0f);
+
+	for (uint32_t first = 0; first < triangleCount; first += TRIANGLES_PER_DRAW)
+	{
+		uint32_t count = std::min(TRIANGLES_PER_DRAW, triangleCount - first);
+
+		glm::vec3 lower = vertices[first * 3].position;
+		glm::vec3 upper = lower;
+
+		for (uint32_t vertex = first * 3; vertex < (first + count) * 3; vertex++)
+		{
+			lower = glm::min(lower, vertices[vertex].position);
+			upper = glm::max(upper, vertices[vertex].position);
+		}
+
+		addDraw(first * 3, count * 3, lower, upper);
+	}
+}
+
+void HelloTriangleApplication::loadMesh(const Astr& path)
+{
+	if (MeshFile::isMeshFile(path))
+	{
+		meshFile = std::make_unique<MeshFile>(path);
+		geometry = meshFile->getView();
+	}
+	else
+	{
+		mesh = MeshProcessor::process(MeshImporter::import(path));
+		geometry = mesh.getView();
+	}
+
+	if (geometry.indexCount == 0)
+	{
+		throw std::runtime_error(path + " has no triangles.");
+	}
+
+	// The bounds are what the positions were quantized to. Clip space
+	// has y down and depth in [0, 1], nearer is smaller.
+	glm::vec3 center = geometry.positionOffset + geometry.positionScale * 0.5f;
+	float extent = std::max(std::max(geometry.positionScale.x, geometry.positionScale.y), geometry.positionScale.z);
+	float fitScale = 1.8f / std::max(extent, std::numeric_limits<float>::min());
+	glm::vec3 toClipScale = glm::vec3(1.0f, -1.0f, -0.5f) * fitScale;
+	glm::vec3 toClipOffset(0.0f, 0.0f, 0.5f);
+
+	// Folded into the dequantization, so the shader has one multiply-add.
+	drawPushConstants.positionScale = glm::vec4(geometry.positionScale * toClipScale, 0.0f);
+	drawPushConstants.positionOffset = glm::vec4((geometry.positionOffset - center) * toClipScale + toClipOffset, 0.0f);
+
+	// Meshlets are small enough to cull one by one and are ranges of
+	// the index buffer, which is all a draw needs.
+	for (uint32_t i = 0; i < geometry.meshletCount; i++)
+	{
+		const Meshlet& meshlet = geometry.meshlets[i];
+		glm::vec3 sphereCenter = (glm::vec3(meshlet.boundingSphere) - center) * toClipScale + toClipOffset;
+		float radius = meshlet.boundingSphere.w * fitScale;
+
+		addDraw(meshlet.firstIndex, meshlet.triangleCount * 3, sphereCenter - radius, sphereCenter + radius);
+	}
+
+	// Mesh files may come without meshlets, then all of it is one draw.
+	if (geometry.meshletCount == 0)
+	{
+		glm::vec3 corner = (geometry.positionOffset - center) * toClipScale + toClipOffset;
+		glm::vec3 oppositeCorner = corner + geometry.positionScale * toClipScale;
+
+		addDraw(0, geometry.indexCount, glm::min(corner, oppositeCorner), glm::max(corner, oppositeCorner));
+	}
+}
+
+void HelloTriangleApplication::addDraw(uint32_t firstIndex, uint32_t indexCount, glm::vec3 lower, glm::vec3 upper)
+{
+	drawCommands.push_back({ indexCount, settings.instanceCount, firstIndex, 0, 0 });
+
+	// The sphere has to hold the draw's triangles in every instance.
+	glm::vec3 instancesLower(std::numeric_limits<float>::max());
+	glm::vec3 instancesUpper(std::numeric_limits<float>::lowest());
+
+	for (const glm::vec4& instance : instances)
+	{
+		glm::vec3 scale(instance.z, instance.z, 1.0f);
+		glm::vec3 offset(instance.x, instance.y, 0.0f);
+
+		instancesLower = glm::min(instancesLower, lower * scale + offset);
+		instancesUpper = glm::max(instancesUpper, upper * scale + offset);
+	}
+
+	CullObject object{};
+	object.boundingSphere = glm::vec4((instancesLower + instancesUpper) * 0.5f, glm::length(instancesUpper - instancesLower) * 0.5f);
+	object.indexCount = indexCount;
+	object.firstIndex = firstIndex;
+	object.vertexOffset = 0;
+	object.instanceCount = settings.instanceCount;
+	cullObjects.push_back(object);
+}
+
+VkDeviceSize HelloTriangleApplication::getInitialUploadSize() const
+{
+	const VkDeviceSize sizes[] = {
+		sizeof(Vertex) * static_cast<VkDeviceSize>(geometry.vertexCount),
+		sizeof(uint32_t) * static_cast<VkDeviceSize>(geometry.indexCount),
+		sizeof(instances[0]) * instances.size(),
+		sizeof(cullObjects[0]) * cullObjects.size()
+	};
+
+	VkDeviceSize total = 0;
+
+	for (VkDeviceSize size : sizes)
+	{
+		total += alignUp(size, StagingRing::COPY_ALIGNMENT);
+	}
+
+	return total;
+}
+
+void HelloTriangleApplication::createVertexBuffer()
+{
+	createDeviceLocalBuffer(geometry.vertices, sizeof(Vertex) * geometry.vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBuffer, vertexBufferAllocation);
+}
+
+void HelloTriangleApplication::createIndexBuffer()
+{
+	createDeviceLocalBuffer(geometry.indices, sizeof(uint32_t) * geometry.indexCount, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexBufferAllocation);
+}
+
+void HelloTriangleApplication::releaseGeometry()
+{
+	geometry = MeshView();
+	mesh = Mesh();
+	meshFile.reset();
+}
+
+void HelloTriangleApplication::createInstanceBuffer()
+{
+	VkDeviceSize size = sizeof(instances[0]) * instances.size();
+	createDeviceLocalBuffer(instances.data(), size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, instanceBuffer, instanceBufferAllocation);
+
+	instanceBufferIndex = descriptorHeap.addStorageBuffer(instanceBuffer, 0, size);
+}
+
+void HelloTriangleApplication::createCullingBuffers()
+{
+	VkDeviceSize objectsSize = sizeof(cullObjects[0]) * cullObjects.size();
+	VkDeviceSize drawsSize = sizeof(VkDrawIndexedIndirectCommand) * cullObjects.size();
+
+	// Only the cull pass reads the objects, so they go to its queue.
+	uint32_t objectsFamily = isCullOnComputeQueue() ? computeFamily : VK_QUEUE_FAMILY_IGNORED;
+	createDeviceLocalBuffer(cullObjects.data(), objectsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, cullObjectBuffer, cullObjectBufferAllocation, objectsFamily);
+
+	AllocationCreateInfo allocInfo{};
+	allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	cullTargets.resize(getFrameSlotCount());
+
+	for (auto& targets : cullTargets)
+	{
+		createBuffer(drawsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, allocInfo, targets.drawBuffer, targets.drawBufferAllocation);
+		createBuffer(sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, allocInfo, targets.countBuffer, targets.countBufferAllocation);
+
+		targets.drawBufferIndex = descriptorHeap.addStorageBuffer(targets.drawBuffer, 0, drawsSize);
+		targets.countBufferIndex = descriptorHeap.addStorageBuffer(targets.countBuffer, 0, sizeof(uint32_t));
+	}
+
+	drawPushConstants.instanceBuffer = instanceBufferIndex;
+	drawPushConstants.objectBuffer = descriptorHeap.addStorageBuffer(cullObjectBuffer, 0, objectsSize);
+	drawPushConstants.objectCount = static_cast<uint32_t>(cullObjects.size());
+}
+
+void HelloTriangleApplication::destroyCullingBuffers()
+{
+	descriptorHeap.remove(DescriptorHeap::Kind::StorageBuffer, drawPushConstants.objectBuffer);
+
+	for (const auto& targets : cullTargets)
+	{
+		descriptorHeap.remove(DescriptorHeap::Kind::StorageBuffer, targets.drawBufferIndex);
+		descriptorHeap.remove(DescriptorHeap::Kind::StorageBuffer, targets.countBufferIndex);
+
+		destroyBuffer(targets.countBuffer, targets.countBufferAllocation);
+		destroyBuffer(targets.drawBuffer, targets.drawBufferAllocation);
+	}
+
+	cullTargets.clear();
+	destroyBuffer(cullObjectBuffer, cullObjectBufferAllocation);
+}
+
+void HelloTriangleApplication::createDepthPyramid(VkExtent2D extent)
+{
+	if (depthPyramidBuffer != VK_NULL_HANDLE && extent.width == depthPyramidExtent.width && extent.height == depthPyramidExtent.height)
+	{
+		return;
+	}
+
+	if (depthPyramidBuffer != VK_NULL_HANDLE)
+	{
+		VkBuffer oldBuffer = depthPyramidBuffer;
+		Allocation oldAllocation = depthPyramidBufferAllocation;
+		uint32_t oldIndex = drawPushConstants.depthPyramidBuffer;
+
+		deletionQueue.retire([this, oldBuffer, oldAllocation, oldIndex]()
+		{
+			descriptorHeap.remove(DescriptorHeap::Kind::StorageBuffer, oldIndex);
+			destroyBuffer(oldBuffer, oldAllocation);
+		});
+	}
+
+	// Every level halves the one before, rounding up, down to 1x1.
+	uint32_t width = (extent.width + 1) / 2;
+	uint32_t height = (extent.height + 1) / 2;
+
+	drawPushConstants.depthPyramidWidth = width;
+	drawPushConstants.depthPyramidHeight = height;
+
+	VkDeviceSize texelCount = 0;
+	depthPyramidLevelCount = 0;
+
+	while (true)
+	{
+		texelCount += static_cast<VkDeviceSize>(width) * height;
+		depthPyramidLevelCount++;
+
+		if (width == 1 && height == 1)
+		{
+			break;
+		}
+
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+
+	VkDeviceSize size = texelCount * sizeof(float);
+
+	AllocationCreateInfo allocInfo{};
+	allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	createBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, allocInfo, depthPyramidBuffer, depthPyramidBufferAllocation);
+
+	drawPushConstants.depthPyramidBuffer = descriptorHeap.addStorageBuffer(depthPyramidBuffer, 0, size);
+	depthPyramidExtent = extent;
+	depthPyramidBuilt = false;
+}
+
+void HelloTriangleApplication::createDepthSampler()
+{
+	// Only texelFetch() reads through it.
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+	if (vkCreateSampler(device, &samplerInfo, nullptr, &depthSampler) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create depth sampler.");
+	}
+
+	drawPushConstants.depthSampler = descriptorHeap.addSampler(depthSampler);
+}
+
+void HelloTriangleApplication::destroyDepthPyramid()
+{
+	if (depthTextureIndex != UINT32_MAX)
+	{
+		descriptorHeap.remove(DescriptorHeap::Kind::SampledImage, depthTextureIndex);
+		depthTextureIndex = UINT32_MAX;
+	}
+
+	if (depthPyramidBuffer != VK_NULL_HANDLE)
+	{
+		descriptorHeap.remove(DescriptorHeap::Kind::StorageBuffer, drawPushConstants.depthPyramidBuffer);
+		destroyBuffer(depthPyramidBuffer, depthPyramidBufferAllocation);
+		depthPyramidBuffer = VK_NULL_HANDLE;
+	}
+
+	if (depthSampler != VK_NULL_HANDLE)
+	{
+		descriptorHeap.remove(DescriptorHeap::Kind::Sampler, drawPushConstants.depthSampler);
+		vkDestroySampler(device, depthSampler, nullptr);
+		depthSampler = VK_NULL_HANDLE;
+	}
+}
+
+void HelloTriangleApplication::createFrameReadback()
+{
+	frameReadback = std::make_unique<FrameReadback>();
+	frameReadback->create(device, allocator, views[0].swapChainExtent, views[0].swapChainImageFormat, getFrameSlotCount(), READBACK_ENCODER_THREADS);
+	frameReadback->setCapture(settings.captureDirectory, settings.captureFormat, settings.captureInterval);
+
+	for (const auto& consumer : frameConsumers)
+	{
+		frameReadback->addConsumer(consumer);
+	}
+}
+
+void HelloTriangleApplication::createFrameCommands()
+{
+	uint32_t threadCount = settings.recordingThreadCount;
+
+	if (threadCount == 0)
+	{
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	recordingThreads = std::make_unique<ThreadPool>(threadCount);
+
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = graphicsFamily;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+	frameCommands.resize(getFrameSlotCount());
+
+	for (auto& frame : frameCommands)
+	{
+		if (vkCreateCommandPool(device, &poolInfo, nullptr, &frame.primaryPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create command pool");
+		}
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = frame.primaryPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(device, &allocInfo, &frame.primaryCommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate command buffers.");
+		}
+
+		if (transferQueue != graphicsQueue)
+		{
+			VkCommandPoolCreateInfo transferPoolInfo = poolInfo;
+			transferPoolInfo.queueFamilyIndex = transferFamily;
+
+			if (vkCreateCommandPool(device, &transferPoolInfo, nullptr, &frame.transferPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create command pool");
+			}
+
+			allocInfo.commandPool = frame.transferPool;
+
+			if (vkAllocateCommandBuffers(device, &allocInfo, &frame.transferCommandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate command buffers.");
+			}
+		}
+
+		if (isCullOnComputeQueue())
+		{
+			VkCommandPoolCreateInfo computePoolInfo = poolInfo;
+			computePoolInfo.queueFamilyIndex = computeFamily;
+
+			if (vkCreateCommandPool(device, &computePoolInfo, nullptr, &frame.computePool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create command pool");
+			}
+
+			allocInfo.commandPool = frame.computePool;
+
+			if (vkAllocateCommandBuffers(device, &allocInfo, &frame.computeCommandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate command buffers.");
+			}
+		}
+
+		// Every view's main pass records its own jobs, views[v] uses the
+		// threadCount pools from v * threadCount on.
+		uint32_t secondaryCount = threadCount * static_cast<uint32_t>(views.size());
+		frame.secondaryPools.resize(secondaryCount);
+		frame.secondaryCommandBuffers.resize(secondaryCount);
+
+		for (uint32_t i = 0; i < secondaryCount; i++)
+		{
+			if (vkCreateCommandPool(device, &poolInfo, nullptr, &frame.secondaryPools[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create command pool");
+			}
+
+			allocInfo.commandPool = frame.secondaryPools[i];
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+
+			if (vkAllocateCommandBuffers(device, &allocInfo, &frame.secondaryCommandBuffers[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate command buffers.");
+			}
+		}
+	}
+}
+
+void HelloTriangleApplication::destroyFrameCommands()
+{
+	for (auto& frame : frameCommands)
+	{
+		for (auto pool : frame.secondaryPools)
+		{
+			vkDestroyCommandPool(device, pool, nullptr);
+		}
+
+		if (frame.transferPool != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(device, frame.transferPool, nullptr);
+		}
+
+		if (frame.computePool != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(device, frame.computePool, nullptr);
+		}
+
+		vkDestroyCommandPool(device, frame.primaryPool, nullptr);
+	}
+
+	frameCommands.clear();
+	recordingThreads.reset();
+}
+
+Avec<FrameScheduler::TimelineWait> HelloTriangleApplication::submitUploads()
+{
+	if (transferQueue == graphicsQueue || !stagingRing.hasPendingCopies())
+	{
+		return {};
+	}
+
+	FrameCommands& frame = frameCommands[frameScheduler.getCurrentSlot()];
+
+	vkResetCommandPool(device, frame.transferPool, 0);
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(frame.transferCommandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin recording command buffer.");
+	}
+
+	stagingRing.flush(frame.transferCommandBuffer, transferFamily, graphicsFamily);
+
+	if (vkEndCommandBuffer(frame.transferCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record command buffer.");
+	}
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &frame.transferCommandBuffer;
+
+	uint64_t value = frameScheduler.submit(transferTimeline, submitInfo);
+
+	return { { transferTimeline, value, StagingRing::DESTINATION_STAGES } };
+}
+
+void HelloTriangleApplication::updateFrameConstants()
+{
+	const CullTargets& targets = cullTargets[frameScheduler.getCurrentSlot()];
+	drawPushConstants.drawBuffer = targets.drawBufferIndex;
+	drawPushConstants.countBuffer = targets.countBufferIndex;
+
+	// A pyramid no frame has built yet holds no depth to test against.
+	drawPushConstants.depthPyramidLevels = depthPyramidBuilt ? depthPyramidLevelCount : 0;
+
+	bool cullUniformsPushed = false;
+
+	for (auto& view : views)
+	{
+		if (!view.active)
+		{
+			continue;
+		}
+
+		FrameUniforms frameUniforms{};
+		frameUniforms.viewProjection = glm::mat4(1.0f);
+		frameUniforms.viewport = {
+			static_cast<float>(view.swapChainExtent.width), static_cast<float>(view.swapChainExtent.height),
+			1.0f / view.swapChainExtent.width, 1.0f / view.swapChainExtent.height
+		};
+		extractFrustumPlanes(frameUniforms.viewProjection, frameUniforms.frustumPlanes);
+
+		view.frameUniformOffset = uniformRing.push(frameUniforms);
+
+		if (!cullUniformsPushed)
+		{
+			frameUniformOffset = view.frameUniformOffset;
+			cullUniformsPushed = true;
+		}
+	}
+
+	uniformRing.flush();
+}
+
+Avec<FrameScheduler::TimelineWait> HelloTriangleApplication::submitCull(const Avec<FrameScheduler::TimelineWait>& uploadWaits)
+{
+	if (!isCullOnComputeQueue())
+	{
+		return {};
+	}
+
+	uint32_t slot = frameScheduler.getCurrentSlot();
+	FrameCommands& frame = frameCommands[slot];
+	const CullTargets& targets = cullTargets[slot];
+
+	vkResetCommandPool(device, frame.computePool, 0);
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(frame.computeCommandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin recording command buffer.");
+	}
+
+	// Cull objects copied on a transfer queue of another family.
+	stagingRing.recordAcquire(frame.computeCommandBuffer, computeFamily, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+	// Released by the previous frame's DepthPyramid pass.
+	if (depthPyramidBuilt)
+	{
+		BufferOwnershipTransfer pyramidTransfer(graphicsFamily, computeFamily);
+		pyramidTransfer.add(depthPyramidBuffer, 0, VK_WHOLE_SIZE);
+		pyramidTransfer.recordAcquire(frame.computeCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	}
+
+	// The graphics queue is done with the slot's targets since beginFrame(),
+	// and they are written anew, so their ownership is taken without a
+	// transfer back, leaving the old contents undefined.
+	vkCmdFillBuffer(frame.computeCommandBuffer, targets.countBuffer, 0, sizeof(uint32_t), 0);
+
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(
+		frame.computeCommandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		1, &barrier,
+		0, nullptr,
+		0, nullptr
+	);
+
+	recordCullPass(frame.computeCommandBuffer);
+
+	cullTransfer = BufferOwnershipTransfer(computeFamily, graphicsFamily);
+	cullTransfer.add(targets.drawBuffer, 0, VK_WHOLE_SIZE);
+	cullTransfer.add(targets.countBuffer, 0, VK_WHOLE_SIZE);
+	cullTransfer.recordRelease(frame.computeCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+	if (vkEndCommandBuffer(frame.computeCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record command buffer.");
+	}
+
+	// Uploads on the same queue are ordered by the barrier flush() records.
+	Avec<FrameScheduler::TimelineWait> timelineWaits;
+
+	for (const auto& wait : uploadWaits)
+	{
+		if (wait.queueIndex != computeTimeline)
+		{
+			timelineWaits.push_back({ wait.queueIndex, wait.value, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT });
+		}
+	}
+
+	// The occlusion test needs the previous frame's graphics submission to
+	// have finished, culling no longer overlaps with drawing it.
+	if (depthPyramidBuilt)
+	{
+		timelineWaits.push_back({ graphicsTimeline, frameScheduler.getSubmittedValue(graphicsTimeline), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT });
+	}
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &frame.computeCommandBuffer;
+
+	uint64_t value = frameScheduler.submit(computeTimeline, submitInfo, timelineWaits);
+
+	// The frame's DepthPyramid pass overwrites the pyramid the cull reads.
+	VkPipelineStageFlags waitStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+
+	if (settings.occlusionCulling)
+	{
+		waitStages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	}
+
+	return { { computeTimeline, value, waitStages } };
+}
+
+VkCommandBuffer HelloTriangleApplication::recordFrame()
+{
+	uint32_t slot = frameScheduler.getCurrentSlot();
+	FrameCommands& frame = frameCommands[slot];
+
+	vkResetCommandPool(device, frame.primaryPool, 0);
+
+	VkCommandBuffer commandBuffer = frame.primaryCommandBuffer;
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin recording command buffer.");
+	}
+
+	profiler.resetGpuQueries(commandBuffer);
+
+	// Uploads queued since the last frame go out with this submission,
+	// unless submitUploads() sent them to the transfer queue; then only
+	// the ownership of their destinations is taken over here.
+	stagingRing.flush(commandBuffer, graphicsFamily, graphicsFamily);
+	stagingRing.recordAcquire(commandBuffer, graphicsFamily);
+
+	for (const auto& view : views)
+	{
+		if (view.active)
+		{
+			renderGraph.bindImage(view.backbuffer, view.swapChainImages[view.imageIndex], view.swapChainImageViews[view.imageIndex]);
+		}
+	}
+
+	if (settings.gpuDrivenDraws)
+	{
+		renderGraph.bindBuffer(indirectDraws, cullTargets[slot].drawBuffer);
+		renderGraph.bindBuffer(indirectDrawCount, cullTargets[slot].countBuffer);
+	}
+
+	if (depthPyramid.isValid())
+	{
+		renderGraph.bindBuffer(depthPyramid, depthPyramidBuffer);
+	}
+
+	if (isCullOnComputeQueue())
+	{
+		cullTransfer.recordAcquire(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	}
+
+	if (frameReadback)
+	{
+		// The GPU is done with the slot, so is the copy of the frame that
+		// last used it.
+		frameReadback->collect(slot);
+		frameReadback->beginFrame(slot, frameScheduler.getFrameNumber());
+		renderGraph.bindBuffer(readbackTarget, frameReadback->getBuffer(slot));
+	}
+
+	renderGraph.execute(commandBuffer);
+
+	// Next frame's cull tests against it.
+	if (depthPyramid.isValid())
+	{
+		depthPyramidBuilt = true;
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record command buffer");
+	}
+
+	return commandBuffer;
+}
+
+void HelloTriangleApplication::recordCullPass(VkCommandBuffer commandBuffer)
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+	descriptorHeap.bind(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0);
+	uniformRing.bind(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 1, frameUniformOffset);
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(drawPushConstants), &drawPushConstants);
+
+	uint32_t groupCount = (drawPushConstants.objectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE;
+	vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+}
+
+void HelloTriangleApplication::recordDepthPyramidPass(VkCommandBuffer commandBuffer)
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, depthPyramidPipeline);
+	descriptorHeap.bind(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0);
+
+	DrawPushConstants pushConstants = drawPushConstants;
+	uint32_t width = drawPushConstants.depthPyramidWidth;
+	uint32_t height = drawPushConstants.depthPyramidHeight;
+
+	for (uint32_t level = 0; level < depthPyramidLevelCount; level++)
+	{
+		// Every level is reduced from the one before.
+		if (level > 0)
+		{
+			VkMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				0,
+				1, &barrier,
+				0, nullptr,
+				0, nullptr
+			);
+		}
+
+		pushConstants.depthPyramidLevel = level;
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+
+		vkCmdDispatch(commandBuffer, (width + DEPTH_PYRAMID_GROUP_SIZE - 1) / DEPTH_PYRAMID_GROUP_SIZE, (height + DEPTH_PYRAMID_GROUP_SIZE - 1) / DEPTH_PYRAMID_GROUP_SIZE, 1);
+
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+
+	// The next frame's cull on the compute queue acquires it.
+	if (isCullOnComputeQueue())
+	{
+		BufferOwnershipTransfer transfer(graphicsFamily, computeFamily);
+		transfer.add(depthPyramidBuffer, 0, VK_WHOLE_SIZE);
+		transfer.recordRelease(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+	}
+}
+
+void HelloTriangleApplication::extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+	glm::mat4 rows = glm::transpose(viewProjection);
+
+	planes[0] = rows[3] + rows[0];
+	planes[1] = rows[3] - rows[0];
+	planes[2] = rows[3] + rows[1];
+	planes[3] = rows[3] - rows[1];
+	planes[4] = rows[2];
+	planes[5] = rows[3] - rows[2];
+
+	for (int i = 0; i < 6; i++)
+	{
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+}
+
+void HelloTriangleApplication::recordMainPass(uint32_t viewIndex, const RenderGraph::PassContext& context)
+{
+	FrameCommands& frame = frameCommands[frameScheduler.getCurrentSlot()];
+	const View& view = views[viewIndex];
+	uint32_t firstSecondary = viewIndex * recordingThreads->size();
+
+	// The GPU-driven path records one indirect draw, whatever the number
+	// of objects.
+	uint32_t drawCount = settings.gpuDrivenDraws ? 1 : static_cast<uint32_t>(drawCommands.size());
+	uint32_t jobCount = (drawCount + MIN_DRAWS_PER_RECORDING_JOB - 1) / MIN_DRAWS_PER_RECORDING_JOB;
+	jobCount = std::clamp(jobCount, 1u, recordingThreads->size());
+
+	auto recordJob = [&](uint32_t job)
+	{
+		recordDrawJob(frame, firstSecondary + job, job, jobCount, view, context);
+	};
+
+	// Handing a single job to a worker only adds a round trip.
+	if (jobCount == 1)
+	{
+		recordJob(0);
+	}
+	else
+	{
+		recordingThreads->dispatch(jobCount, recordJob);
+	}
+
+	vkCmdExecuteCommands(context.commandBuffer, jobCount, frame.secondaryCommandBuffers.data() + firstSecondary);
+}
+
+void HelloTriangleApplication::recordDrawJob(FrameCommands& frame, uint32_t secondary, uint32_t job, uint32_t jobCount, const View& view, const RenderGraph::PassContext& context)
+{
+	vkResetCommandPool(device, frame.secondaryPools[secondary], 0);
+
+	VkCommandBuffer commandBuffer = frame.secondaryCommandBuffers[secondary];
+
+	VkCommandBufferInheritanceInfo inheritanceInfo{};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = context.renderPass;
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = context.framebuffer;
+
+#ifdef VK_KHR_dynamic_rendering
+	// Without a render pass the attachment formats are inherited instead.
+	VkCommandBufferInheritanceRenderingInfoKHR inheritanceRendering{};
+	inheritanceRendering.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+	inheritanceRendering.colorAttachmentCount = static_cast<uint32_t>(mainPassFormats.colorFormats.size());
+	inheritanceRendering.pColorAttachmentFormats = mainPassFormats.colorFormats.data();
+	inheritanceRendering.depthAttachmentFormat = mainPassFormats.depthFormat;
+	inheritanceRendering.stencilAttachmentFormat = mainPassFormats.stencilFormat;
+	inheritanceRendering.rasterizationSamples = mainPassFormats.samples;
+
+	if (useDynamicRendering)
+	{
+		inheritanceInfo.pNext = &inheritanceRendering;
+	}
+#endif
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin recording command buffer.");
+	}
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+
+	// Secondary command buffers inherit no bindings, but these are all
+	// the descriptor sets a job ever binds.
+	descriptorHeap.bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0);
+	uniformRing.bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, view.frameUniformOffset);
+
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(drawPushConstants), &drawPushConstants);
+
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(view.swapChainExtent.width);
+	viewport.height = static_cast<float>(view.swapChainExtent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+	VkRect2D scissor{};
+	scissor.offset = { 0, 0 };
+	scissor.extent = view.swapChainExtent;
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	VkDeviceSize offset = 0;
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+	if (settings.gpuDrivenDraws)
+	{
+		uint32_t maxDrawCount = static_cast<uint32_t>(cullObjects.size());
+		const CullTargets& targets = cullTargets[frameScheduler.getCurrentSlot()];
+		vkCmdDrawIndexedIndirectCount(commandBuffer, targets.drawBuffer, 0, targets.countBuffer, 0, maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+	}
+	else
+	{
+		size_t first = drawCommands.size() * job / jobCount;
+		size_t last = drawCommands.size() * (job + 1) / jobCount;
+
+		for (size_t i = first; i < last; i++)
+		{
+			const DrawCommand& draw = drawCommands[i];
+			vkCmdDrawIndexed(commandBuffer, draw.indexCount, draw.instanceCount, draw.firstIndex, draw.vertexOffset, draw.firstInstance);
+		}
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record command buffer");
+	}
+}
+
+void HelloTriangleApplication::buildRenderGraph()
+{
+	for (uint32_t i = 0; i < views.size(); i++)
+	{
+		addViewResources(i);
+	}
+
+	auto first = std::find_if(views.begin(), views.end(), [](const View& view) { return view.active; });
+
+	if (settings.gpuDrivenDraws)
+	{
+		// Rewritten every frame, after the previous frame has drawn from them.
+		// Culled on the compute queue they arrive acquired for the indirect
+		// read before the graph runs.
+		ExternalAccess drawn{};
+		drawn.stageMask = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+
+		indirectDraws = renderGraph.importBuffer("IndirectDraws", drawn, {});
+		indirectDrawCount = renderGraph.importBuffer("IndirectDrawCount", drawn, {});
+	}
+
+	depthPyramid = {};
+
+	// Built from the depth of the first view, whose uniforms the cull pass
+	// reads, and last written by the previous frame.
+	if (settings.occlusionCulling && first != views.end())
+	{
+		createDepthPyramid(first->swapChainExtent);
+
+		ExternalAccess built{};
+		built.stageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		built.accessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+		depthPyramid = renderGraph.importBuffer("DepthPyramid", built, {});
+	}
+
+	if (settings.gpuDrivenDraws && !isCullOnComputeQueue())
+	{
+		renderGraph.addPass("ResetDrawCount",
+			[this](RenderGraph::PassBuilder& builder)
+			{
+				builder.write(indirectDrawCount, ResourceUsage::TransferDst);
+			},
+			[this](const RenderGraph::PassContext& context)
+			{
+				vkCmdFillBuffer(context.commandBuffer, renderGraph.getBuffer(indirectDrawCount), 0, sizeof(uint32_t), 0);
+			}
+		);
+
+		renderGraph.addPass("Cull",
+			[this](RenderGraph::PassBuilder& builder)
+			{
+				builder.write(indirectDraws, ResourceUsage::StorageWrite);
+				builder.modify(indirectDrawCount, ResourceUsage::StorageWrite);
+
+				if (depthPyramid.isValid())
+				{
+					builder.read(depthPyramid, ResourceUsage::StorageRead);
+				}
+			},
+			[this](const RenderGraph::PassContext& context)
+			{
+				recordCullPass(context.commandBuffer);
+			}
+		);
+	}
+
+	for (uint32_t i = 0; i < views.size(); i++)
+	{
+		addMainPass(i);
+
+		// Right behind the main pass, the depth buffer can still share
+		// memory with those of the views after it.
+		if (depthPyramid.isValid() && views.begin() + i == first)
+		{
+			addDepthPyramidPass(i);
+		}
+	}
+
+	readbackTarget = {};
+
+	if (frameReadback)
+	{
+		// Read on the host once the frame's timeline value is reached.
+		ExternalAccess hostRead{};
+		hostRead.stageMask = VK_PIPELINE_STAGE_HOST_BIT;
+		hostRead.accessMask = VK_ACCESS_HOST_READ_BIT;
+
+		readbackTarget = renderGraph.importBuffer("Readback", {}, hostRead);
+
+		renderGraph.addPass("Readback",
+			[this](RenderGraph::PassBuilder& builder)
+			{
+				builder.read(views[0].backbuffer, ResourceUsage::TransferSrc);
+				builder.write(readbackTarget, ResourceUsage::TransferDst);
+			},
+			[this](const RenderGraph::PassContext& context)
+			{
+				frameReadback->recordCopy(context.commandBuffer, renderGraph.getImage(views[0].backbuffer), frameScheduler.getCurrentSlot());
+			}
+		);
+	}
+
+	renderGraph.setPassHooks(
+		[this](VkCommandBuffer commandBuffer, const char* name) { profiler.beginGpuScope(commandBuffer, name); },
+		[this](VkCommandBuffer commandBuffer) { profiler.endGpuScope(commandBuffer); }
+	);
+
+	renderGraph.setDynamicRendering(useDynamicRendering);
+	renderGraph.compile(device, allocator);
+
+	if (depthPyramid.isValid())
+	{
+		depthTextureIndex = descriptorHeap.addSampledImage(renderGraph.getImageView(first->depthTarget));
+		drawPushConstants.depthTexture = depthTextureIndex;
+	}
+
+	// One pipeline draws every view, so they have to agree on the
+	// format. With every window minimized the last one is kept.
+	if (first == views.end())
+	{
+		return;
+	}
+
+	for (const auto& view : views)
+	{
+		if (view.active && view.swapChainImageFormat != first->swapChainImageFormat)
+		{
+			throw std::runtime_error("Views with different surface formats are not supported.");
+		}
+	}
+
+	colorFormat = first->swapChainImageFormat;
+	renderPass = renderGraph.getRenderPass(first->mainPass);
+	mainPassFormats = renderGraph.getRenderingFormats(first->mainPass);
+}
+
+void HelloTriangleApplication::addViewResources(uint32_t viewIndex)
+{
+	View& view = views[viewIndex];
+
+	view.backbuffer = {};
+	view.multisampledColor = {};
+	view.depthTarget = {};
+	view.mainPass = {};
+
+	if (!view.active)
+	{
+		return;
+	}
+
+	RenderGraphImageDesc backbufferDesc{};
+	backbufferDesc.format = view.swapChainImageFormat;
+	backbufferDesc.extent = view.swapChainExtent;
+
+	// Submissions wait for the image to be acquired at this stage.
+	ExternalAccess acquired{};
+	acquired.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	acquired.stageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+	// PRESENT_SRC_KHR is only valid with VK_KHR_swapchain enabled,
+	// offscreen targets are left ready to be copied out instead.
+	ExternalAccess presented{};
+	presented.layout = settings.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	presented.stageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+	view.backbuffer = renderGraph.importImage(getViewName("Backbuffer", viewIndex), backbufferDesc, acquired, presented);
+
+	// Only live within the main pass, so they stay transient: cleared on
+	// load, never stored, and in lazily allocated memory where possible.
+	if (msaaSamples != VK_SAMPLE_COUNT_1_BIT)
+	{
+		RenderGraphImageDesc colorDesc = backbufferDesc;
+		colorDesc.samples = msaaSamples;
+
+		view.multisampledColor = renderGraph.createImage(getViewName("MultisampledColor", viewIndex), colorDesc);
+	}
+
+	if (settings.depthBuffer)
+	{
+		RenderGraphImageDesc depthDesc{};
+		depthDesc.format = depthFormat;
+		depthDesc.extent = view.swapChainExtent;
+		depthDesc.samples = msaaSamples;
+
+		view.depthTarget = renderGraph.createImage(getViewName("Depth", viewIndex), depthDesc);
+	}
+}
+
+void HelloTriangleApplication::addMainPass(uint32_t viewIndex)
+{
+	View& view = views[viewIndex];
+
+	if (!view.active)
+	{
+		return;
+	}
+
+	view.mainPass = renderGraph.addPass(getViewName("MainPass", viewIndex),
+		[this, viewIndex](RenderGraph::PassBuilder& builder)
+		{
+			const View& view = views[viewIndex];
+
+			if (view.multisampledColor.isValid())
+			{
+				builder.colorAttachment(view.multisampledColor, AttachmentLoad::Clear, { { 0.0f, 0.0f, 0.0f, 1.0f } });
+				builder.resolveAttachment(view.backbuffer, view.multisampledColor);
+			}
+			else
+			{
+				builder.colorAttachment(view.backbuffer, AttachmentLoad::Clear, { { 0.0f, 0.0f, 0.0f, 1.0f } });
+			}
+
+			if (view.depthTarget.isValid())
+			{
+				builder.depthAttachment(view.depthTarget, AttachmentLoad::Clear);
+			}
+
+			builder.useSecondaryCommandBuffers();
+
+			if (settings.gpuDrivenDraws)
+			{
+				builder.read(indirectDraws, ResourceUsage::IndirectRead);
+				builder.read(indirectDrawCount, ResourceUsage::IndirectRead);
+			}
+		},
+		[this, viewIndex](const RenderGraph::PassContext& context)
+		{
+			recordMainPass(viewIndex, context);
+		}
+	);
+}
+
+void HelloTriangleApplication::addDepthPyramidPass(uint32_t viewIndex)
+{
+	renderGraph.addPass("DepthPyramid",
+		[this, viewIndex](RenderGraph::PassBuilder& builder)
+		{
+			builder.read(views[viewIndex].depthTarget, ResourceUsage::SampledCompute);
+			builder.write(depthPyramid, ResourceUsage::StorageWrite);
+		},
+		[this](const RenderGraph::PassContext& context)
+		{
+			recordDepthPyramidPass(context.commandBuffer);
+		}
+	);
+}
+
+ShaderCode HelloTriangleApplication::getShaderCode(const Astr& name) const
+{
+	auto reloaded = reloadedShaders.find(name);
+
+	if (reloaded != reloadedShaders.end())
+	{
+		return { reloaded->second.data(), reloaded->second.size() * sizeof(uint32_t) };
+	}
+
+	if (shaderPack)
+	{
+		auto code = shaderPack->find(name);
+
+		if (!code.has_value())
+		{
+			throw std::runtime_error("Shader pack has no shader named " + name);
+		}
+
+		return *code;
+	}
+
+	for (const auto& [embeddedName, code] : getEmbeddedShaders())
+	{
+		if (embeddedName == name)
+		{
+			return code;
+		}
+	}
+
+	throw std::runtime_error("No embedded shader named " + name);
+}
+
+VkShaderModule HelloTriangleApplication::createShaderModule(const ShaderCode& code) const
+{
+	VkShaderModuleCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = code.size;
+	createInfo.pCode = code.words;
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create shader module.");
+	}
+
+	return shaderModule;
+}
+
+void HelloTriangleApplication::createPipelineLayout()
+{
+	// Every pipeline shares this layout: the descriptor heap in set 0,
+	// the uniform ring in set 1 and a few indices in push constants.
+	VkDescriptorSetLayout setLayouts[] = {
+		descriptorHeap.getSetLayout(),
+		uniformRing.getSetLayout()
+	};
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(DrawPushConstants);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 2;
+	pipelineLayoutInfo.pSetLayouts = setLayouts;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout.");
+	}
+}
+
+void HelloTriangleApplication::createGraphicsPipeline()
+{
+	graphicsPipeline = buildGraphicsPipeline(getPipelineTargets(), getShaderCode("DefaultShader.vert"), getShaderCode("DefaultShader.frag"));
+}
+
+void HelloTriangleApplication::createComputePipelines()
+{
+	cullPipeline = buildComputePipeline(getShaderCode("Cull.comp"));
+
+	if (settings.occlusionCulling)
+	{
+		depthPyramidPipeline = buildComputePipeline(getShaderCode("DepthPyramid.comp"));
+	}
+}
+
+VkPipeline HelloTriangleApplication::buildGraphicsPipeline(const PipelineTargets& targets, const ShaderCode& vertShaderCode, const ShaderCode& fragShaderCode) const
+{
+	VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
+	VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
+
+	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	vertShaderStageInfo.module = vertShaderModule;
+	vertShaderStageInfo.pName = "main";
+
+	VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
+	fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	fragShaderStageInfo.module = fragShaderModule;
+	fragShaderStageInfo.pName = "main";
+
+	VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+
+	auto bindingDescription = Vertex::getBindingDescription();
+	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+	// Viewport and scissor are dynamic so the pipeline does not depend on
+	// the swap chain extent.
+	VkPipelineViewportStateCreateInfo viewportState{};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.pViewports = nullptr;
+	viewportState.scissorCount = 1;
+	viewportState.pScissors = nullptr;
+
+	VkPipelineRasterizationStateCreateInfo rasterizer{};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.depthClampEnable = VK_FALSE;
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+	rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+	rasterizer.depthBiasEnable = VK_FALSE;
+	rasterizer.depthBiasConstantFactor = 0.0f; // Optional
+	rasterizer.depthBiasClamp = 0.0f; // Optional
+	rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
+
+	VkPipelineMultisampleStateCreateInfo multisampling{};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.sampleShadingEnable = VK_FALSE;
+	multisampling.rasterizationSamples = msaaSamples;
+	multisampling.minSampleShading = 1.0f; // Optional
+	multisampling.pSampleMask = nullptr; // Optional
+	multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
+	multisampling.alphaToOneEnable = VK_FALSE; // Optional
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	// -------------------- BLENDING ---------------------------------
+	colorBlendAttachment.blendEnable = VK_FALSE;
+	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
+	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
+	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD; // Optional
+	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
+	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
+	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
+	//colorBlendAttachment.blendEnable = VK_TRUE;
+	//colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	//colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	//colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+	//colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	//colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	//colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+	VkPipelineColorBlendStateCreateInfo colorBlending{};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlending.logicOpEnable = VK_FALSE;
+	colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &colorBlendAttachment;
+	colorBlending.blendConstants[0] = 0.0f;  // Optional
+	colorBlending.blendConstants[1] = 0.0f;  // Optional
+	colorBlending.blendConstants[2] = 0.0f;  // Optional
+	colorBlending.blendConstants[3] = 0.0f;  // Optional
+	// ---------------------------------------------------------------
+
+
+	// LESS_OR_EQUAL keeps the draw order for geometry at equal depth.
+	VkPipelineDepthStencilStateCreateInfo depthStencil{};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	depthStencil.depthBoundsTestEnable = VK_FALSE;
+	depthStencil.stencilTestEnable = VK_FALSE;
+
+	VkDynamicState dynamicStates[] = {
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR
+	};
+
+	VkPipelineDynamicStateCreateInfo dynamicState{};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = shaderStages;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pDepthStencilState = settings.depthBuffer ? &depthStencil : nullptr;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.pDynamicState = &dynamicState;
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.renderPass = targets.renderPass;
+	pipelineInfo.subpass = 0;
+
+#ifdef VK_KHR_dynamic_rendering
+	// renderPass is VK_NULL_HANDLE then, the pipeline only depends on
+	// the attachment formats.
+	VkPipelineRenderingCreateInfoKHR renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+	renderingInfo.colorAttachmentCount = static_cast<uint32_t>(targets.formats.colorFormats.size());
+	renderingInfo.pColorAttachmentFormats = targets.formats.colorFormats.data();
+	renderingInfo.depthAttachmentFormat = targets.formats.depthFormat;
+	renderingInfo.stencilAttachmentFormat = targets.formats.stencilFormat;
+
+	if (useDynamicRendering)
+	{
+		pipelineInfo.pNext = &renderingInfo;
+	}
+#endif
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+	pipelineInfo.basePipelineIndex = -1; // Optional
+
+	VkPipeline pipeline;
+	VkResult result = vkCreateGraphicsPipelines(device, pipelineCache.get(), 1, &pipelineInfo, nullptr, &pipeline);
+
+	vkDestroyShaderModule(device, fragShaderModule, nullptr);
+	vkDestroyShaderModule(device, vertShaderModule, nullptr);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create graphics pipeline.");
+	}
+
+	return pipeline;
+}
+
+VkPipeline HelloTriangleApplication::buildComputePipeline(const ShaderCode& code) const
+{
+	VkShaderModule shaderModule = createShaderModule(code);
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = shaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = pipelineLayout;
+
+	VkPipeline pipeline;
+	VkResult result = vkCreateComputePipelines(device, pipelineCache.get(), 1, &pipelineInfo, nullptr, &pipeline);
+
+	vkDestroyShaderModule(device, shaderModule, nullptr);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create compute pipeline.");
+	}
+
+	return pipeline;
+}
+
+void HelloTriangleApplication::startPipelineReload(Amap<Astr, Avec<uint32_t>> shaders)
+{
+	PipelineTargets targets = getPipelineTargets();
+
+	pipelineReload = std::async(std::launch::async, [this, targets, shaders = std::move(shaders)]() mutable
+	{
+		auto getCode = [&](const Astr& name)
+		{
+			auto changed = shaders.find(name);
+			return changed != shaders.end() ? ShaderCode{ changed->second.data(), changed->second.size() * sizeof(uint32_t) } : getShaderCode(name);
+		};
+
+		PipelineReload reload;
+		reload.targets = targets;
+
+		try {
+			if (shaders.count("DefaultShader.vert") || shaders.count("DefaultShader.frag"))
+			{
+				reload.graphicsPipeline = buildGraphicsPipeline(targets, getCode("DefaultShader.vert"), getCode("DefaultShader.frag"));
+			}
+
+			if (shaders.count("Cull.comp"))
+			{
+				reload.cullPipeline = buildComputePipeline(getCode("Cull.comp"));
+			}
+
+			if (settings.occlusionCulling && shaders.count("DepthPyramid.comp"))
+			{
+				reload.depthPyramidPipeline = buildComputePipeline(getCode("DepthPyramid.comp"));
+			}
+		}
+		catch (const std::exception& e) {
+			reload.error = e.what();
+		}
+
+		reload.shaders = std::move(shaders);
+
+		// On-demand rendering has to come around to swap it in.
+		markDirty(DIRTY_RESOURCES);
+
+		return reload;
+	});
+}
+
+void HelloTriangleApplication::updatePipelineReload()
+{
+	if (pipelineReload.valid())
+	{
+		if (pipelineReload.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return;
+		}
+
+		applyPipelineReload(pipelineReload.get());
+		releaseReloadRetiredGraphs();
+	}
+
+	if (!shaderWatcher.isRunning() || pipelineReload.valid())
+	{
+		return;
+	}
+
+	Amap<Astr, Avec<uint32_t>> shaders = shaderWatcher.takeCompiled();
+
+	if (!shaders.empty())
+	{
+		startPipelineReload(std::move(shaders));
+	}
+}
+
+void HelloTriangleApplication::applyPipelineReload(PipelineReload reload)
+{
+	if (!reload.error.empty())
+	{
+		AMlog("Shader reload: " << reload.error << " Keeping the pipelines in use.");
+		destroyPipelineReload(reload);
+		return;
+	}
+
+	// The main pass formats changed during the build, which is as rare
+	// as on a resize. Built again with the same shaders.
+	if (reload.graphicsPipeline != VK_NULL_HANDLE && !isSameRenderingFormats(reload.targets.formats, mainPassFormats))
+	{
+		destroyPipelineReload(reload);
+		startPipelineReload(std::move(reload.shaders));
+		return;
+	}
+
+	for (auto& [name, code] : reload.shaders)
+	{
+		reloadedShaders[name] = std::move(code);
+	}
+
+	swapPipeline(graphicsPipeline, reload.graphicsPipeline);
+	swapPipeline(cullPipeline, reload.cullPipeline);
+	swapPipeline(depthPyramidPipeline, reload.depthPyramidPipeline);
+
+	AMlog("Shader reload: pipelines swapped");
+}
+
+void HelloTriangleApplication::swapPipeline(VkPipeline& pipeline, VkPipeline newPipeline)
+{
+	if (newPipeline == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	VkPipeline oldPipeline = pipeline;
+	deletionQueue.retire([this, oldPipeline]()
+	{
+		vkDestroyPipeline(device, oldPipeline, nullptr);
+	});
+
+	pipeline = newPipeline;
+}
+
+void HelloTriangleApplication::destroyPipelineReload(const PipelineReload& reload)
+{
+	if (reload.graphicsPipeline != VK_NULL_HANDLE)
+	{
+		vkDestroyPipeline(device, reload.graphicsPipeline, nullptr);
+	}
+
+	if (reload.cullPipeline != VK_NULL_HANDLE)
+	{
+		vkDestroyPipeline(device, reload.cullPipeline, nullptr);
+	}
+
+	if (reload.depthPyramidPipeline != VK_NULL_HANDLE)
+	{
+		vkDestroyPipeline(device, reload.depthPyramidPipeline, nullptr);
+	}
+}
+
+void HelloTriangleApplication::releaseReloadRetiredGraphs()
+{
+	for (const auto& graph : reloadRetiredGraphs)
+	{
+		graph->reset();
+	}
+
+	reloadRetiredGraphs.clear();
+}
+
+void HelloTriangleApplication::finishPipelineReload()
+{
+	shaderWatcher.stop();
+
+	if (pipelineReload.valid())
+	{
+		destroyPipelineReload(pipelineReload.get());
+	}
+
+	releaseReloadRetiredGraphs();
+}
+
+void HelloTriangleApplication::createImageViews(View& view)
+{
+	view.swapChainImageViews.resize(view.swapChainImages.size());
+
+	for (size_t i = 0; i < view.swapChainImages.size(); i++)
+	{
+		VkImageViewCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		createInfo.image = view.swapChainImages[i];
+		createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		createInfo.format = view.swapChainImageFormat;
+
+		createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+		createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+		createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+		createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+		createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		createInfo.subresourceRange.baseMipLevel = 0;
+		createInfo.subresourceRange.levelCount = 1;
+		createInfo.subresourceRange.baseArrayLayer = 0;
+		createInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(device, &createInfo, nullptr, &view.swapChainImageViews[i]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create image views.");
+		}
+	}
+}
+
+void HelloTriangleApplication::createSurfaces()
+{
+	for (auto& view : views)
+	{
+		if (glfwCreateWindowSurface(instance, view.window, nullptr, &view.surface) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create window surface.");
+		}
+	}
+}
+
+void HelloTriangleApplication::createOffscreenTargets(View& view)
+{
+	// One target per frame slot, so a target is only rendered to again
+	// once the frame that last used it has finished.
+	view.swapChainImages.resize(getFrameSlotCount());
+	view.offscreenImageAllocations.resize(getFrameSlotCount());
+
+	view.swapChainImageFormat = HEADLESS_FORMAT;
+	view.swapChainExtent = { WIDTH, HEIGHT };
+
+	for (size_t i = 0; i < view.swapChainImages.size(); i++)
+	{
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = view.swapChainImageFormat;
+		imageInfo.extent = { view.swapChainExtent.width, view.swapChainExtent.height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (vkCreateImage(device, &imageInfo, nullptr, &view.swapChainImages[i]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create offscreen image.");
+		}
+
+		AllocationCreateInfo allocInfo{};
+		allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		allocInfo.kind = ResourceKind::Optimal;
+
+		view.offscreenImageAllocations[i] = allocator.allocateForImage(view.swapChainImages[i], allocInfo);
+	}
+}
+
+HelloTriangleApplication::SwapChainSupportDetails HelloTriangleApplication::querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface)
+{
+	SwapChainSupportDetails details;
+
+	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
+
+	uint32_t formatCount = 0;
+	vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
+
+	if (formatCount != 0)
+	{
+		details.formats.resize(formatCount);
+		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, details.formats.data());
+	}
+
+	uint32_t presentModeCount = 0;
+	vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, nullptr);
+
+	if (presentModeCount != 0)
+	{
+		details.presentModes.resize(presentModeCount);
+		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, details.presentModes.data());
+	}
+
+	return details;
+}
+
+void HelloTriangleApplication::createLogicalDevice()
+{
+	QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+
+	//VkDeviceQueueCreateInfo queueCreateInfo {};
+	//queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	//queueCreateInfo.queueFamilyIndex = indices.graphicsFamily.value();
+	//queueCreateInfo.queueCount = 1;
+
+	//float queuePriority = 1.0f;
+	//queueCreateInfo.pQueuePriorities = &queuePriority;
+
+	graphicsFamily = indices.graphicsFamily.value();
+	computeFamily = indices.computeFamily.value_or(graphicsFamily);
+
+	// Compute families support transfers too, so uploads leave the graphics
+	// queue whenever one of the two is dedicated.
+	transferFamily = indices.transferFamily.value_or(computeFamily);
+
+	Avec<VkDeviceQueueCreateInfo> queueCreateInfos;
+	std::set<uint32_t> uniqueQueueFamilies = { graphicsFamily, transferFamily, computeFamily };
+
+	if (indices.presentFamily.has_value())
+	{
+		uniqueQueueFamilies.insert(indices.presentFamily.value());
+	}
+
+	float queuePriority = 1.0f;
+	for (uint32_t queueFamily : uniqueQueueFamilies)
+	{
+		VkDeviceQueueCreateInfo queueCreateInfo{};
+		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueCreateInfo.queueFamilyIndex = queueFamily;
+		queueCreateInfo.queueCount = 1;
+		queueCreateInfo.pQueuePriorities = &queuePriority;
+		queueCreateInfos.push_back(queueCreateInfo);
+	}
+
+	// Optional, draws are recorded one by one on the CPU without them.
+	if (settings.gpuDrivenDraws && !checkGpuDrivenDrawSupport(physicalDevice))
+	{
+		AMlog("Device lacks multiDrawIndirect or drawIndirectCount, falling back to CPU draws");
+		settings.gpuDrivenDraws = false;
+	}
+
+	// The occlusion test is part of the cull pass.
+	if (settings.occlusionCulling && !settings.gpuDrivenDraws)
+	{
+		AMlog("Occlusion culling needs GPU-driven draws, disabled");
+		settings.occlusionCulling = false;
+	}
+
+	VkBool32 gpuDrivenDraws = settings.gpuDrivenDraws ? VK_TRUE : VK_FALSE;
+
+	// Indirect draws with more than one command need multiDrawIndirect.
+	VkPhysicalDeviceFeatures deviceFeatures{};
+	deviceFeatures.multiDrawIndirect = gpuDrivenDraws;
+
+	// Timeline semaphores and descriptor indexing are core since Vulkan 1.2
+	// (VK_KHR_timeline_semaphore and VK_EXT_descriptor_indexing before), but
+	// still have to be enabled.
+	VkPhysicalDeviceVulkan12Features vulkan12Features{};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	vulkan12Features.timelineSemaphore = VK_TRUE;
+	vulkan12Features.drawIndirectCount = gpuDrivenDraws;
+	vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+	vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+	vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+	vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+	vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+
+	auto deviceExtensions = getRequiredDeviceExtensions();
+
+#ifdef VK_KHR_dynamic_rendering
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+	dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+
+	useDynamicRendering = settings.dynamicRendering && checkDynamicRenderingSupport(physicalDevice);
+
+	if (useDynamicRendering)
+	{
+		vulkan12Features.pNext = &dynamicRenderingFeatures;
+		deviceExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+	}
+#endif
+
+	AMlog("Rendering: " << (useDynamicRendering ? "dynamic rendering" : "render pass objects"));
+
+	VkDeviceCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	createInfo.pNext = &vulkan12Features;
+	createInfo.pQueueCreateInfos = queueCreateInfos.data();
+	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
+
+	createInfo.pEnabledFeatures = &deviceFeatures;
+
+	createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+	createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+
+	if (enableValidationLayers)
+	{
+		createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
+		createInfo.ppEnabledLayerNames = validationLayers.data();
+	}
+	else
+	{
+		createInfo.enabledLayerCount = 0;
+	}
+
+	if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create logical device.");
+	}
+
+	vkGetDeviceQueue(device, graphicsFamily, 0, &graphicsQueue);
+	vkGetDeviceQueue(device, transferFamily, 0, &transferQueue);
+	vkGetDeviceQueue(device, computeFamily, 0, &computeQueue);
+
+	AMlog("Queue families: graphics " << graphicsFamily << ", transfer " << transferFamily << ", compute " << computeFamily);
+
+	if (indices.presentFamily.has_value())
+	{
+		vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+	}
+}
+
+void HelloTriangleApplication::pickPhysicalDevice()
+{
+	uint32_t deviceCount = 0;
+
+	vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+
+	if (deviceCount == 0)
+	{
+		throw std::runtime_error("Failed to find GPUs with Vulkan support.");
+	}
+
+	Avec<VkPhysicalDevice> devices(deviceCount);
+	vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+
+	Avec<DeviceSelector::Candidate> candidates;
+
+	for (const auto& device : devices)
+	{
+		DeviceSelector::Candidate candidate = DeviceSelector::describe(device);
+		candidate.suitable = isDeviceSuitable(device);
+
+		if (candidate.suitable)
+		{
+			QueueFamilyIndices indices = findQueueFamilies(device);
+			candidate.dedicatedTransferQueue = indices.transferFamily.has_value();
+			candidate.dedicatedComputeQueue = indices.computeFamily.has_value();
+		}
+
+		candidates.push_back(candidate);
+	}
+
+	Astr selector = settings.deviceSelector;
+
+	if (selector.empty())
+	{
+		const char* environment = std::getenv("ASTRUM_DEVICE");
+		selector = environment != nullptr ? environment : "";
+	}
+
+	AMlog("Vulkan devices:");
+	physicalDevice = DeviceSelector::select(candidates, selector, settings.allowSoftwareDevice).device;
+}
+
+void HelloTriangleApplication::chooseAttachmentFormats()
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	VkSampleCountFlags supportedSamples = properties.limits.framebufferColorSampleCounts;
+
+	if (settings.depthBuffer)
+	{
+		depthFormat = findDepthFormat();
+		supportedSamples &= properties.limits.framebufferDepthSampleCounts;
+	}
+
+	// Highest supported count up to the requested one, 1 always is.
+	msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	for (uint32_t samples = std::min(settings.msaaSamples, 64u); samples > 1; samples /= 2)
+	{
+		if (supportedSamples & samples)
+		{
+			msaaSamples = static_cast<VkSampleCountFlagBits>(samples);
+			break;
+		}
+	}
+
+	if (static_cast<uint32_t>(msaaSamples) != settings.msaaSamples && settings.msaaSamples > 1)
+	{
+		AMlog("MSAA: " << settings.msaaSamples << " samples are not supported, using " << msaaSamples);
+	}
+
+	// The depth pyramid is reduced from one sample per pixel.
+	if (settings.occlusionCulling && (!settings.depthBuffer || msaaSamples != VK_SAMPLE_COUNT_1_BIT))
+	{
+		AMlog("Occlusion culling needs a depth buffer without MSAA, disabled");
+		settings.occlusionCulling = false;
+	}
+}
+
+VkFormat HelloTriangleApplication::findDepthFormat()
+{
+	const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D16_UNORM };
+
+	// Occlusion culling samples the depth buffer, which the render graph
+	// views with every aspect of its format. Views with stencil cannot be
+	// sampled, so only depth formats qualify.
+	if (settings.occlusionCulling)
+	{
+		const VkFormatFeatureFlags features = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+
+		for (VkFormat format : { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM })
+		{
+			VkFormatProperties properties;
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+
+			if ((properties.optimalTilingFeatures & features) == features)
+			{
+				return format;
+			}
+		}
+
+		AMlog("Occlusion culling: no sampleable depth format, disabled");
+		settings.occlusionCulling = false;
+	}
+
+	for (VkFormat format : candidates)
+	{
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+
+		if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+		{
+			return format;
+		}
+	}
+
+	throw std::runtime_error("Failed to find a supported depth format.");
+}
+
+HelloTriangleApplication::QueueFamilyIndices HelloTriangleApplication::findQueueFamilies(VkPhysicalDevice device)
+{
+	QueueFamilyIndices indices;
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+
+	Avec<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+
+	// Every family is looked at, dedicated families can come after the
+	// graphics one.
+	uint32_t i = 0;
+	for (const auto& queueFamily : queueFamilies)
+	{
+		VkQueueFlags flags = queueFamily.queueFlags;
+
+		if ((flags & VK_QUEUE_GRAPHICS_BIT) && !indices.graphicsFamily.has_value())
+		{
+			indices.graphicsFamily = i;
+		}
+
+		// Transfer-only families are the copy engines.
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && !indices.transferFamily.has_value())
+		{
+			indices.transferFamily = i;
+		}
+
+		if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT) && !indices.computeFamily.has_value())
+		{
+			indices.computeFamily = i;
+		}
+
+		if (!settings.headless)
+		{
+			// One present call covers every view, so the family has to
+			// support all of their surfaces.
+			bool presentSupport = true;
+
+			for (const auto& view : views)
+			{
+				VkBool32 surfaceSupport = VK_FALSE;
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, view.surface, &surfaceSupport);
+				presentSupport = presentSupport && surfaceSupport == VK_TRUE;
+			}
+
+			// Presenting from the graphics family avoids sharing the
+			// swap chain images between families.
+			if (presentSupport && (!indices.presentFamily.has_value() || i == indices.graphicsFamily))
+			{
+				indices.presentFamily = i;
+			}
+		}
+
+		i++;
+	}
+
+	return indices;
+}
+
+VkSurfaceFormatKHR HelloTriangleApplication::chooseSwapSurfaceFormat(const Avec<VkSurfaceFormatKHR>& availableFormats, VkFormat preferredFormat)
+{
+	for (const auto& availableFormat : availableFormats)
+	{
+		if (availableFormat.format == preferredFormat && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+		{
+			return availableFormat;
+		}
+	}
+
+	for (const auto& availableFormat : availableFormats)
+	{
+		if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+		{
+			return availableFormat;
+		}
+	}
+
+	return availableFormats[0];
+}
+
+VkPresentModeKHR HelloTriangleApplication::chooseSwapPresentMode(const Avec<VkPresentModeKHR>& availablePresentModes)
+{
+	if (settings.presentMode.has_value())
+	{
+		if (std::find(availablePresentModes.begin(), availablePresentModes.end(), *settings.presentMode) != availablePresentModes.end())
+		{
+			return *settings.presentMode;
+		}
+
+		AMlog("Requested present mode is not supported, falling back.");
+	}
+
+	for (const auto& availablePresentMode : availablePresentModes)
+	{
+		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+		{
+			return availablePresentMode;
+		}
+	}
+
+	return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+VkExtent2D HelloTriangleApplication::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window)
+{
+	if (capabilities.currentExtent.width != UINT32_MAX)
+	{
+		return capabilities.currentExtent;
+	}
+	else
+	{
+		int width, height;
+		glfwGetFramebufferSize(window, &width, &height);
+
+		VkExtent2D actualExtent = {
+			static_cast<uint32_t>(width),
+			static_cast<uint32_t>(height)
+		};
+
+		actualExtent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.maxImageExtent.width, actualExtent.width));
+		actualExtent.height = std::max(capabilities.minImageExtent.height, std::min(capabilities.maxImageExtent.height, actualExtent.height));
+
+		return actualExtent;
+	}
+}
+
+void HelloTriangleApplication::createSwapChain(View& view, VkSwapchainKHR oldSwapChain)
+{
+	SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice, view.surface);
+
+	VkFormat preferredFormat = colorFormat;
+
+	for (const auto& other : views)
+	{
+		if (preferredFormat == VK_FORMAT_UNDEFINED && &other != &view)
+		{
+			preferredFormat = other.swapChainImageFormat;
+		}
+	}
+
+	VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats, preferredFormat);
+	VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+	VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities, view.window);
+
+	uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+
+	if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount)
+	{
+		imageCount = swapChainSupport.capabilities.maxImageCount;
+	}
+
+	VkSwapchainCreateInfoKHR createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+	createInfo.surface = view.surface;
+	createInfo.minImageCount = imageCount;
+	createInfo.imageFormat = surfaceFormat.format;
+	createInfo.imageColorSpace = surfaceFormat.colorSpace;
+	createInfo.imageExtent = extent;
+	createInfo.imageArrayLayers = 1;
+	createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+	// Readback copies out of the first view's swap chain images.
+	if (isReadbackEnabled() && &view == &views[0])
+	{
+		if ((swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) == 0)
+		{
+			throw std::runtime_error("Swap chain images cannot be copied from, frame readback is not supported.");
+		}
+
+		createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	}
+
+	QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+	uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+
+	if (indices.graphicsFamily != indices.presentFamily)
+	{
+		createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+		createInfo.queueFamilyIndexCount = 2;
+		createInfo.pQueueFamilyIndices = queueFamilyIndices;
+	}
+	else
+	{
+		createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	}
+
+	createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
+	createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+	createInfo.presentMode = presentMode;
+	createInfo.clipped = VK_TRUE;
+
+	createInfo.oldSwapchain = oldSwapChain;
+
+	if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &view.swapChain) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create swap chain.");
+	}
+
+	vkGetSwapchainImagesKHR(device, view.swapChain, &imageCount, nullptr);
+	view.swapChainImages.resize(imageCount);
+	vkGetSwapchainImagesKHR(device, view.swapChain, &imageCount, view.swapChainImages.data());
+
+	view.swapChainImageFormat = surfaceFormat.format;
+	view.swapChainExtent = extent;
+}
+
+bool HelloTriangleApplication::isDeviceSuitable(VkPhysicalDevice device)
+{
+	QueueFamilyIndices indices = findQueueFamilies(device);
+
+	bool extensionsSupported = checkDeviceExtensionSupport(device);
+
+	if (!checkDeviceFeatureSupport(device))
+	{
+		return false;
+	}
+
+	if (settings.headless)
+	{
+		return indices.isComplete(false) && extensionsSupported;
+	}
+
+	bool swapChainAdequate = extensionsSupported;
+
+	for (const auto& view : views)
+	{
+		if (swapChainAdequate)
+		{
+			SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device, view.surface);
+			swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
+		}
+	}
+
+	return indices.isComplete() && extensionsSupported && swapChainAdequate;
+}
+
+bool HelloTriangleApplication::checkDeviceFeatureSupport(VkPhysicalDevice device)
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device, &properties);
+
+	if (properties.apiVersion < VK_API_VERSION_1_2)
+	{
+		return false;
+	}
+
+	VkPhysicalDeviceVulkan12Features vulkan12Features{};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceFeatures2 features{};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &vulkan12Features;
+
+	vkGetPhysicalDeviceFeatures2(device, &features);
+
+	return vulkan12Features.timelineSemaphore == VK_TRUE &&
+		vulkan12Features.runtimeDescriptorArray == VK_TRUE &&
+		vulkan12Features.descriptorBindingPartiallyBound == VK_TRUE &&
+		vulkan12Features.descriptorBindingUpdateUnusedWhilePending == VK_TRUE &&
+		vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE &&
+		vulkan12Features.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE;
+}
+
+Avec<const char*> HelloTriangleApplication::getRequiredDeviceExtensions()
+{
+	if (settings.headless)
+	{
+		return {};
+	}
+
+	return swapChainExtensions;
+}
+
+bool HelloTriangleApplication::checkDeviceExtensionSupport(VkPhysicalDevice device)
+{
+	uint32_t extensionsCount = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionsCount, nullptr);
+
+	Avec<VkExtensionProperties> availableExtensions(extensionsCount);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionsCount, availableExtensions.data());
+
+	auto deviceExtensions = getRequiredDeviceExtensions();
+	std::set<Astr> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+
+	for (const auto& extension : availableExtensions)
+	{
+		requiredExtensions.erase(extension.extensionName);
+	}
+
+	return requiredExtensions.empty();
+}
+
+bool HelloTriangleApplication::checkGpuDrivenDrawSupport(VkPhysicalDevice device)
+{
+	VkPhysicalDeviceVulkan12Features vulkan12Features{};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceFeatures2 features{};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &vulkan12Features;
+
+	vkGetPhysicalDeviceFeatures2(device, &features);
+
+	return features.features.multiDrawIndirect == VK_TRUE && vulkan12Features.drawIndirectCount == VK_TRUE;
+}
+
+bool HelloTriangleApplication::checkDynamicRenderingSupport(VkPhysicalDevice device)
+{
+#ifdef VK_KHR_dynamic_rendering
+	uint32_t extensionsCount = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionsCount, nullptr);
+
+	Avec<VkExtensionProperties> availableExtensions(extensionsCount);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionsCount, availableExtensions.data());
+
+	bool extensionSupported = std::any_of(availableExtensions.begin(), availableExtensions.end(), [](const VkExtensionProperties& extension)
+	{
+		return Astr(extension.extensionName) == VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME;
+	});
+
+	if (!extensionSupported)
+	{
+		return false;
+	}
+
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+	dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+	VkPhysicalDeviceFeatures2 features{};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &dynamicRenderingFeatures;
+
+	vkGetPhysicalDeviceFeatures2(device, &features);
+
+	return dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+#else
+	(void)device;
+	return false;
+#endif
+}
+
+bool HelloTriangleApplication::checkValidationLayerSupport()
+{
+	uint32_t layerCount;
+	vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+
+	Avec<VkLayerProperties> availableLayers(layerCount);
+	vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+
+	for (const Astr& layerName : validationLayers) {
+		bool layerFound = false;
+
+		for (const auto& layerProperties : availableLayers) {
+			if (layerName == layerProperties.layerName) {
+				layerFound = true;
+				break;
+			}
+		}
+
+		if (!layerFound) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void HelloTriangleApplication::populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo)
+{
+	createInfo = {};
+
+	createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+	// Everything is subscribed to, debugLog filters at runtime.
+	createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+	createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+	createInfo.pfnUserCallback = debugCallback;
+	createInfo.pUserData = &debugLog;
+}
+
+void HelloTriangleApplication::setupDebugMessenger()
+{
+	if (!enableValidationLayers)
+	{
+		return;
+	}
+
+	VkDebugUtilsMessengerCreateInfoEXT createInfo{};
+	populateDebugMessengerCreateInfo(createInfo);
+
+	if (CreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &debugMessenger) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to set up debug messenger.");
+	}
+}
+
+Avec<const char*> HelloTriangleApplication::getRequiredExtensions()
+{
+	Avec<const char*> extensions;
+
+	if (!settings.headless)
+	{
+		uint32_t glfwExtensionsCount = 0;
+		const char** glfwExtensions;
+
+		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionsCount);
+
+		extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionsCount);
+	}
+
+	if (enableValidationLayers)
+	{
+		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+	}
+
+	return extensions;
+}
+
+VKAPI_ATTR VkBool32 VKAPI_CALL HelloTriangleApplication::debugCallback(
+	VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+	VkDebugUtilsMessageTypeFlagsEXT messageType,
+	const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+	void* pUserData
+)
+{
+	auto log = static_cast<DebugLog*>(pUserData);
+	log->submit(messageSeverity, messageType, pCallbackData->messageIdNumber, pCallbackData->pMessage);
+
+	return VK_FALSE;
+}
+
+void HelloTriangleApplication::createInstance()
+{
+	if (enableValidationLayers && !checkValidationLayerSupport())
+	{
+		throw std::runtime_error("Validation layers requested but not available.");
+	}
+
+	VkApplicationInfo appInfo{};
+	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	appInfo.pApplicationName = "Hello Triangle!";
+	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+	appInfo.pEngineName = "No Engine";
+	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+	appInfo.apiVersion = VK_API_VERSION_1_2;
+
+	VkInstanceCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	createInfo.pApplicationInfo = &appInfo;
+
+	auto extensions = getRequiredExtensions();
+
+	createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+	createInfo.ppEnabledExtensionNames = extensions.data();
+
+	VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo;
+	if (enableValidationLayers)
+	{
+		createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
+		createInfo.ppEnabledLayerNames = validationLayers.data();
+
+		populateDebugMessengerCreateInfo(debugCreateInfo);
+		//createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*)&debugCreateInfo;
+		createInfo.pNext = static_cast<VkDebugUtilsMessengerCreateInfoEXT*>(&debugCreateInfo);
+	}
+	else
+	{
+		createInfo.enabledLayerCount = 0;
+		createInfo.pNext = nullptr;
+	}
+
+	if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create VkInstance.");
+	}
+}
+
+void HelloTriangleApplication::mainLoop()
+{
+	if (settings.headless)
+	{
+		uint32_t frameCount = settings.frameCount ? settings.frameCount : DEFAULT_HEADLESS_FRAMES;
+		auto start = std::chrono::steady_clock::now();
+
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			drawFrameHeadless();
+		}
+
+		vkDeviceWaitIdle(device);
+		deletionQueue.flush();
+		collectReadback();
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		AMlog("Rendered " << frameCount << " headless frames in " << elapsed.count() << " ms");
+		return;
+	}
+
+	uint32_t frame = 0;
+	frameRateLimiter.setMaxFrameRate(settings.maxFrameRate);
+
+	while (!isAnyWindowClosed() && (settings.frameCount == 0 || frame < settings.frameCount))
+	{
+		if (settings.onDemandRendering)
+		{
+			// Blocks until an event arrives or markDirty() posts one. The
+			// timeout only guards against a wake-up that never comes.
+			if (dirtyFlags.load() == 0)
+			{
+				auto timer = profiler.scope("WaitForEvents");
+				glfwWaitEventsTimeout(ON_DEMAND_WAIT_TIMEOUT);
+			}
+			else
+			{
+				glfwPollEvents();
+			}
+
+			if (dirtyFlags.exchange(0) == 0)
+			{
+				continue;
+			}
+		}
+		else
+		{
+			glfwPollEvents();
+		}
+
+		{
+			auto timer = profiler.scope("FrameRateLimit");
+			frameRateLimiter.wait();
+		}
+
+		drawFrame();
+		frame++;
+	}
+
+	vkDeviceWaitIdle(device);
+	deletionQueue.flush();
+	collectReadback();
+}
+
+void HelloTriangleApplication::collectReadback()
+{
+	if (frameReadback)
+	{
+		frameReadback->collectAll();
+	}
+}
+
+void HelloTriangleApplication::drawFrameHeadless()
+{
+	uint32_t slot;
+	{
+		auto timer = profiler.scope("WaitForFrame");
+		slot = frameScheduler.beginFrame();
+	}
+
+	deletionQueue.collect();
+	updatePipelineReload();
+	profiler.beginFrame(slot);
+	stagingRing.beginFrame(slot);
+	uniformRing.beginFrame(slot);
+
+	// Offscreen targets are owned per frame slot, so the wait above is
+	// all that guards reuse; there is nothing to acquire or present.
+	for (auto& view : views)
+	{
+		view.imageIndex = slot;
+	}
+
+	Avec<FrameScheduler::TimelineWait> timelineWaits;
+	{
+		auto timer = profiler.scope("Upload");
+		timelineWaits = submitUploads();
+	}
+
+	updateFrameConstants();
+
+	{
+		auto timer = profiler.scope("Cull");
+		Avec<FrameScheduler::TimelineWait> cullWaits = submitCull(timelineWaits);
+		timelineWaits.insert(timelineWaits.end(), cullWaits.begin(), cullWaits.end());
+	}
+
+	VkCommandBuffer commandBuffer;
+	{
+		auto timer = profiler.scope("Record");
+		commandBuffer = recordFrame();
+	}
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	{
+		auto timer = profiler.scope("Submit");
+		frameScheduler.submit(graphicsTimeline, submitInfo, timelineWaits);
+	}
+
+	profiler.endFrame();
+}
+
+void HelloTriangleApplication::drawFrame()
+{
+	recreateSwapChains();
+
+	// Every window is minimized, nothing to render until one is restored.
+	if (!hasActiveView())
+	{
+		glfwWaitEvents();
+		return;
+	}
+
+	uint32_t slot;
+	{
+		auto timer = profiler.scope("WaitForFrame");
+		slot = frameScheduler.beginFrame();
+	}
+
+	deletionQueue.collect();
+	updatePipelineReload();
+	profiler.beginFrame(slot);
+	stagingRing.beginFrame(slot);
+	uniformRing.beginFrame(slot);
+
+	{
+		auto timer = profiler.scope("AcquireNextImage");
+		acquireImages(slot);
+	}
+
+	if (!hasActiveView())
+	{
+		return;
+	}
+
+	// No host wait for the images themselves: per-frame resources belong
+	// to the slot, and the GPU orders writes to an image after its
+	// previous use through the acquire semaphore and queue submission
+	// order.
+
+	Avec<FrameScheduler::TimelineWait> timelineWaits;
+	{
+		auto timer = profiler.scope("Upload");
+		timelineWaits = submitUploads();
+	}
+
+	updateFrameConstants();
+
+	{
+		auto timer = profiler.scope("Cull");
+		Avec<FrameScheduler::TimelineWait> cullWaits = submitCull(timelineWaits);
+		timelineWaits.insert(timelineWaits.end(), cullWaits.begin(), cullWaits.end());
+	}
+
+	VkCommandBuffer commandBuffer;
+	{
+		auto timer = profiler.scope("Record");
+		commandBuffer = recordFrame();
+	}
+
+	// The work of every view goes out in one submission, which waits for
+	// all of their images.
+	Avec<View*> presentedViews;
+	Avec<VkSemaphore> waitSemaphores;
+	Avec<VkPipelineStageFlags> waitStages;
+
+	for (auto& view : views)
+	{
+		if (view.active)
+		{
+			presentedViews.push_back(&view);
+			waitSemaphores.push_back(view.imageAvailableSemaphores[slot]);
+			waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		}
+	}
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+	submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+	submitInfo.pWaitSemaphores = waitSemaphores.data();
+	submitInfo.pWaitDstStageMask = waitStages.data();
+
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[slot] };
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = signalSemaphores;
+
+	{
+		auto timer = profiler.scope("Submit");
+		frameScheduler.submit(graphicsTimeline, submitInfo, timelineWaits);
+	}
+
+	// One present for all swap chains, results are reported per swap chain.
+	Avec<VkSwapchainKHR> swapChains;
+	Avec<uint32_t> imageIndices;
+
+	for (View* view : presentedViews)
+	{
+		swapChains.push_back(view->swapChain);
+		imageIndices.push_back(view->imageIndex);
+	}
+
+	Avec<VkResult> results(presentedViews.size(), VK_SUCCESS);
+
+	VkPresentInfoKHR presentInfo{};
+	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	presentInfo.waitSemaphoreCount = 1;
+	presentInfo.pWaitSemaphores = signalSemaphores;
+
+	presentInfo.swapchainCount = static_cast<uint32_t>(swapChains.size());
+	presentInfo.pSwapchains = swapChains.data();
+	presentInfo.pImageIndices = imageIndices.data();
+	presentInfo.pResults = results.data();
+
+	VkResult result;
+	{
+		auto timer = profiler.scope("Present");
+		result = vkQueuePresentKHR(presentQueue, &presentInfo);
+	}
+
+	if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR && result != VK_ERROR_OUT_OF_DATE_KHR)
+	{
+		throw std::runtime_error("Failed to present swap chain image.");
+	}
+
+	for (size_t i = 0; i < presentedViews.size(); i++)
+	{
+		if (results[i] == VK_ERROR_OUT_OF_DATE_KHR || results[i] == VK_SUBOPTIMAL_KHR)
+		{
+			presentedViews[i]->resized = true;
+		}
+	}
+
+	recreateSwapChains();
+
+	profiler.endFrame();
+}
+
+void HelloTriangleApplication::acquireImages(uint32_t slot)
+{
+	for (auto& view : views)
+	{
+		for (uint32_t attempt = 0; view.active; attempt++)
+		{
+			VkResult result = vkAcquireNextImageKHR(device, view.swapChain, UINT64_MAX, view.imageAvailableSemaphores[slot], VK_NULL_HANDLE, &view.imageIndex);
+
+			if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)
+			{
+				break;
+			}
+
+			if (result != VK_ERROR_OUT_OF_DATE_KHR || attempt > 0)
+			{
+				throw std::runtime_error("Failed to acquire swap chain image.");
+			}
+
+			view.resized = true;
+			recreateSwapChains();
+		}
+	}
+}
+
+void HelloTriangleApplication::exportProfile()
+{
+	try {
+		std::filesystem::create_directories(settings.profileDirectory);
+
+		std::filesystem::path directory(settings.profileDirectory);
+		profiler.exportChromeTrace((directory / "trace.json").string());
+		profiler.exportCsv((directory / "frames.csv").string());
+
+		AMlog("Profile written to " << settings.profileDirectory);
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+	}
+}
+
+void HelloTriangleApplication::cleanUp()
+{
+	// Normally empty already, mainLoop() flushes it once the device is idle.
+	deletionQueue.flush();
+	finishPipelineReload();
+
+	allocatorStats = allocator.stats();
+	renderGraphStats = renderGraph.getStats();
+
+	// Framebuffers have to go before the image views they use.
+	renderGraph.clearFramebuffers();
+
+	for (auto& view : views)
+	{
+		cleanUpSwapChain(view);
+	}
+
+	destroyFrameCommands();
+
+	if (frameReadback)
+	{
+		frameReadback->destroy();
+	}
+
+	if (depthPyramidPipeline != VK_NULL_HANDLE)
+	{
+		vkDestroyPipeline(device, depthPyramidPipeline, nullptr);
+	}
+
+	vkDestroyPipeline(device, cullPipeline, nullptr);
+	vkDestroyPipeline(device, graphicsPipeline, nullptr);
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	renderGraph.reset();
+
+	for (size_t i = 0; i < renderFinishedSemaphores.size(); i++)
+	{
+		vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
+	}
+
+	for (auto& view : views)
+	{
+		for (VkSemaphore semaphore : view.imageAvailableSemaphores)
+		{
+			vkDestroySemaphore(device, semaphore, nullptr);
+		}
+	}
+
+	frameScheduler.destroy();
+
+	destroyDepthPyramid();
+	destroyCullingBuffers();
+	descriptorHeap.remove(DescriptorHeap::Kind::StorageBuffer, instanceBufferIndex);
+	destroyBuffer(instanceBuffer, instanceBufferAllocation);
+	destroyBuffer(indexBuffer, indexBufferAllocation);
+	destroyBuffer(vertexBuffer, vertexBufferAllocation);
+	stagingRing.destroy();
+	uniformRing.destroy();
+	descriptorHeap.destroy();
+
+	if (profiler.isEnabled())
+	{
+		profiler.collectPending();
+
+		if (!settings.profileDirectory.empty())
+		{
+			exportProfile();
+		}
+
+		profiler.destroy();
+	}
+
+	pipelineCache.destroy();
+	shaderPack.reset();
+	allocator.destroy();
+
+	vkDestroyDevice(device, nullptr);
+
+	if (enableValidationLayers)
+	{
+		DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
+	}
+
+	for (auto& view : views)
+	{
+		if (view.surface != VK_NULL_HANDLE)
+		{
+			vkDestroySurfaceKHR(instance, view.surface, nullptr);
+		}
+	}
+
+	vkDestroyInstance(instance, nullptr);
+	debugLog.stop();
+
+	if (!settings.headless)
+	{
+		for (auto& view : views)
+		{
+			glfwDestroyWindow(view.window);
+		}
+
+		glfwTerminate();
+	}
+}
@@ -0,0 +1,836 @@
+#ifndef __HelloTriangleApplication_h__
+#define __HelloTriangleApplication_h__
+
+#pragma once
+
+#include "Pch.h"
+#include "PipelineCache.h"
+#include "ThreadPool.h"
+#include "DeviceAllocator.h"
+#include "StagingRing.h"
+#include "Mesh.h"
+#include "MeshFile.h"
+#include "Profiler.h"
+#include "ShaderPack.h"
+#include "ShaderWatcher.h"
+#include "FrameScheduler.h"
+#include "RenderGraph.h"
+#include "DescriptorHeap.h"
+#include "UniformRing.h"
+#include "DebugLog.h"
+#include "FrameRateLimiter.h"
+#include "FrameReadback.h"
+#include "DeletionQueue.h"
+
+struct ApplicationSettings
+{
+	// Renders into device-owned images instead of a window surface.
+	bool headless { false };
+
+	// Frames to render before exiting, 0 runs until the window is closed.
+	// Headless mode has no window and renders DEFAULT_HEADLESS_FRAMES then.
+	uint32_t frameCount { 0 };
+
+	// Frames the CPU may run ahead of the GPU. It can be changed at runtime
+	// up to maxFramesInFlight, which per-frame resources are created for.
+	uint32_t framesInFlight { 2 };
+	uint32_t maxFramesInFlight { 3 };
+
+	// Number of triangles in the scene, laid out on a grid, and instances
+	// drawn of each of them.
+	uint32_t triangleCount { 1 };
+	uint32_t instanceCount { 1 };
+
+	// Mesh drawn instead of the triangle grid, fitted into the view. OBJ
+	// and glTF files are processed at startup, mesh files only mapped.
+	Astr meshPath;
+
+	// Present mode to use when the surface supports it, MAILBOX with a FIFO
+	// fallback otherwise.
+	std::optional<VkPresentModeKHR> presentMode;
+
+	// Threads recording secondary command buffers, 0 uses one per hardware thread.
+	uint32_t recordingThreadCount { 0 };
+
+	// Collects frame timings even without a profile directory.
+	bool enableProfiler { false };
+
+	// Directory the frame profile is written to on exit, profiling is
+	// disabled when empty unless enableProfiler is set.
+	Astr profileDirectory;
+
+	// Number of frames kept in the profiler's history.
+	size_t profileHistorySize { Profiler::FRAME_HISTORY };
+
+	// Shader pack to load shaders from instead of the ones built into the
+	// executable, every shader the application uses must be in it.
+	Astr shaderPackPath;
+
+	// Directory of GLSL sources to watch. Changed shaders are recompiled
+	// with shaderCompiler and their pipelines rebuilt in the background;
+	// hot reload is disabled when empty.
+	Astr shaderSourceDirectory;
+	Astr shaderCompiler { ASTRUM_GLSLC };
+
+	// Culls the draws in a compute pass and submits the visible ones with a
+	// single indirect draw. Otherwise every draw is recorded on the CPU.
+	bool gpuDrivenDraws { true };
+
+	// Also culls the draws hidden behind what the previous frame drew, tested
+	// against a depth pyramid built from the first view's depth buffer. Needs
+	// GPU-driven draws and a depth buffer without MSAA. Objects coming out
+	// from behind others show up a frame late.
+	bool occlusionCulling { false };
+
+	// Device to use, by name (or part of it) or UUID, instead of the best
+	// ranked one. The ASTRUM_DEVICE environment variable is used when empty.
+	Astr deviceSelector;
+
+	// Lets software rasterizers be picked, when no GPU is suitable or the
+	// selector names one.
+	bool allowSoftwareDevice { false };
+
+	// Filters and rate limit of validation layer messages.
+	DebugLogSettings debugLog;
+
+	// Renders only when something marked the frame dirty, blocking on window
+	// events otherwise.
+	bool onDemandRendering { false };
+
+	// Upper limit on frames per second, 0 for none.
+	double maxFrameRate { 0.0 };
+
+	// Directory every captureInterval-th frame is written to, capturing is
+	// disabled when empty.
+	Astr captureDirectory;
+	ImageFileFormat captureFormat { ImageFileFormat::Png };
+	uint32_t captureInterval { 1 };
+
+	// Depth buffer of the main pass, and samples per pixel of its color and
+	// depth attachments, lowered to what the device supports. Multisampled
+	// color is resolved into the backbuffer at the end of the pass.
+	bool depthBuffer { true };
+	uint32_t msaaSamples { 1 };
+
+	// Begins rendering with VK_KHR_dynamic_rendering where the device has it,
+	// without render pass and framebuffer objects. Otherwise, or when false,
+	// the render graph creates render passes.
+	bool dynamicRendering { true };
+
+	// Windows, or offscreen targets in headless mode, rendered from the one
+	// device. Every view has its own main pass in the shared render graph,
+	// all of them are submitted together and presented with one call.
+	uint32_t viewCount { 1 };
+
+	// One fullscreen view per connected monitor instead of viewCount windows.
+	bool viewPerMonitor { false };
+};
+
+// Why a frame has to be rendered in on-demand mode.
+enum DirtyFlagBits : uint32_t
+{
+	DIRTY_INPUT		= 1 << 0,
+	DIRTY_RESIZE	= 1 << 1,
+	DIRTY_ANIMATION	= 1 << 2,
+	DIRTY_RESOURCES	= 1 << 3,
+	DIRTY_ALL		= DIRTY_INPUT | DIRTY_RESIZE | DIRTY_ANIMATION | DIRTY_RESOURCES
+};
+
+class HelloTriangleApplication
+{
+public:
+	static constexpr Auint			WIDTH { 800 };
+	static constexpr Auint			HEIGHT { 600 };
+	static constexpr const char*	TITLE { "Vulkan" };
+	static constexpr uint32_t		DEFAULT_HEADLESS_FRAMES { 300 };
+	static constexpr uint32_t		TRIANGLES_PER_DRAW { 64 };
+	static constexpr VkFormat		HEADLESS_FORMAT { VK_FORMAT_R8G8B8A8_UNORM };
+	static constexpr const char*	PIPELINE_CACHE_DIRECTORY { "Cache" };
+	static constexpr uint32_t		MIN_DRAWS_PER_RECORDING_JOB { 256 };
+	static constexpr VkDeviceSize	STAGING_RING_SIZE { 16ull * 1024 * 1024 };
+	static constexpr VkDeviceSize	UNIFORM_RING_SLOT_SIZE { 1024 * 1024 };
+	static constexpr uint32_t		MAX_UNIFORM_BLOCK_SIZE { 1024 };
+	static constexpr uint32_t		CULL_GROUP_SIZE { 64 };
+	static constexpr uint32_t		DEPTH_PYRAMID_GROUP_SIZE { 8 };
+	static constexpr double			ON_DEMAND_WAIT_TIMEOUT { 0.5 };
+	static constexpr uint32_t		READBACK_ENCODER_THREADS { 2 };
+
+	HelloTriangleApplication() = default;
+
+	explicit HelloTriangleApplication(const ApplicationSettings& settings)
+		: settings { settings }
+	{
+	}
+
+	const Profiler& getProfiler() const
+	{
+		return profiler;
+	}
+
+	// Allocator state just before clean up, run() has destroyed the
+	// allocator by the time this can be called.
+	const AllocatorStats& getAllocatorStats() const
+	{
+		return allocatorStats;
+	}
+
+	// Of the last render graph compiled, also kept past clean up.
+	const RenderGraph::Stats& getRenderGraphStats() const
+	{
+		return renderGraphStats;
+	}
+
+	// Takes effect from the next frame on, clamped to the frame slots.
+	void setFramesInFlight(uint32_t framesInFlight)
+	{
+		frameScheduler.setFramesInFlight(framesInFlight);
+	}
+
+	// Called with the pixels of every finished frame, on the render thread
+	// a few frames after it was rendered. Has to be added before run().
+	void addFrameConsumer(const FrameReadback::Consumer& consumer)
+	{
+		frameConsumers.push_back(consumer);
+	}
+
+	// Requests a frame in on-demand mode. Safe to call from any thread, it
+	// wakes the main loop if it is waiting for events. Animations call it
+	// every time they advance.
+	void markDirty(uint32_t reasons);
+
+	static Avec<std::pair<Astr, ShaderCode>> getEmbeddedShaders();
+	void run();
+
+private:
+	ApplicationSettings settings;
+
+	VkInstance instance;
+
+	// ---------- GPU ----------
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device;
+	DeviceAllocator allocator;
+	AllocatorStats allocatorStats;
+	StagingRing stagingRing;
+	Profiler profiler;
+	DescriptorHeap descriptorHeap;
+	UniformRing uniformRing;
+	// -------------------------
+
+	// --------- Views ---------
+	// A window with its surface and swap chain, or in headless mode a set of
+	// device-owned offscreen targets standing in for the swap chain images.
+	struct View
+	{
+		GLFWwindow* window = nullptr;
+		VkSurfaceKHR surface = VK_NULL_HANDLE;
+
+		VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+		Avec<VkImage> swapChainImages;
+		Avec<VkImageView> swapChainImageViews;
+		Avec<Allocation> offscreenImageAllocations;
+		VkFormat swapChainImageFormat { VK_FORMAT_UNDEFINED };
+		VkExtent2D swapChainExtent {};
+
+		// Signalled by the acquire, per frame slot.
+		Avec<VkSemaphore> imageAvailableSemaphores;
+
+		// Minimized windows have no swap chain and are left out of the
+		// render graph until they have a size again.
+		bool active { false };
+		bool resized { false };
+
+		RenderGraph::ImageHandle backbuffer;
+		RenderGraph::ImageHandle multisampledColor;
+		RenderGraph::ImageHandle depthTarget;
+		RenderGraph::PassHandle mainPass;
+
+		// Image acquired and uniforms pushed for the current frame.
+		uint32_t imageIndex { 0 };
+		uint32_t frameUniformOffset { 0 };
+	};
+
+	Avec<View> views;
+
+	// Read by markDirty() from any thread.
+	std::atomic<bool> windowsCreated { false };
+	// -------------------------
+
+	// ----- Render Graph ------
+	RenderGraph renderGraph;
+	RenderGraph::Stats renderGraphStats;
+	RenderGraph::BufferHandle indirectDraws;
+	RenderGraph::BufferHandle indirectDrawCount;
+	RenderGraph::BufferHandle readbackTarget;
+	RenderGraph::BufferHandle depthPyramid;
+	// -------------------------
+
+	// ---- Main attachments ---
+	// Every view renders to this format, the main pipeline is created for it.
+	VkFormat colorFormat { VK_FORMAT_UNDEFINED };
+	VkFormat depthFormat { VK_FORMAT_UNDEFINED };
+	VkSampleCountFlagBits msaaSamples { VK_SAMPLE_COUNT_1_BIT };
+
+	// What the main pipeline and the secondary command buffers are created
+	// against when there is no render pass.
+	bool useDynamicRendering { false };
+	RenderGraph::RenderingFormats mainPassFormats;
+	// -------------------------
+
+	// -------- Readback -------
+	// Copies the frames of the first view. Replaced on resize while the old
+	// one may still have frames in flight, and absent while the view is
+	// minimized.
+	std::unique_ptr<FrameReadback> frameReadback;
+	Avec<FrameReadback::Consumer> frameConsumers;
+	// -------------------------
+
+	// ------- Pipeline --------
+	std::unique_ptr<ShaderPack> shaderPack;
+	PipelineCache pipelineCache;
+	// Owned by renderGraph.
+	VkRenderPass renderPass;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline graphicsPipeline;
+	VkPipeline cullPipeline;
+	VkPipeline depthPyramidPipeline = VK_NULL_HANDLE;
+
+	// What a graphics pipeline is created against, copied for builds on
+	// another thread.
+	struct PipelineTargets
+	{
+		VkRenderPass renderPass;
+		RenderGraph::RenderingFormats formats;
+	};
+	// -------------------------
+
+	// ------ Hot reload -------
+	// Pipelines built from recompiled shaders, VK_NULL_HANDLE where the
+	// shaders did not change.
+	struct PipelineReload
+	{
+		Amap<Astr, Avec<uint32_t>> shaders;
+		PipelineTargets targets;
+		VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+		VkPipeline cullPipeline = VK_NULL_HANDLE;
+		VkPipeline depthPyramidPipeline = VK_NULL_HANDLE;
+		Astr error;
+	};
+
+	ShaderWatcher shaderWatcher;
+
+	// SPIR-V of reloaded shaders, used instead of the built in ones or the
+	// shader pack. Only changes while no reload is being built.
+	Amap<Astr, Avec<uint32_t>> reloadedShaders;
+
+	// At most one build at a time.
+	std::future<PipelineReload> pipelineReload;
+
+	// Render graphs the GPU is done with, whose render pass the build may
+	// still use.
+	Avec<std::shared_ptr<RenderGraph>> reloadRetiredGraphs;
+	// -------------------------
+
+	// -------- Geometry -------
+	// What is uploaded, pointing into mesh or meshFile. All three are
+	// released once the uploads have copied them into the staging ring.
+	MeshView geometry;
+	Mesh mesh;
+	std::unique_ptr<MeshFile> meshFile;
+
+	VkBuffer vertexBuffer;
+	Allocation vertexBufferAllocation;
+	VkBuffer indexBuffer;
+	Allocation indexBufferAllocation;
+
+	// Per instance offset and scale, read through the descriptor heap.
+	Avec<glm::vec4> instances;
+	VkBuffer instanceBuffer;
+	Allocation instanceBufferAllocation;
+	uint32_t instanceBufferIndex;
+	// -------------------------
+
+	// -------- Drawing --------
+	// Matches the FrameUniforms block in the shaders, set 1.
+	struct FrameUniforms
+	{
+		glm::mat4 viewProjection;
+		glm::vec4 viewport;
+		// Inward facing, xyz normal and w distance.
+		glm::vec4 frustumPlanes[6];
+	};
+
+	// Matches the push constant block in the shaders. Buffers are indices
+	// into the descriptor heap.
+	struct DrawPushConstants
+	{
+		// Turn the quantized vertex positions into clip space, xyz used.
+		glm::vec4 positionScale;
+		glm::vec4 positionOffset;
+
+		uint32_t instanceBuffer;
+		uint32_t objectBuffer;
+		uint32_t drawBuffer;
+		uint32_t countBuffer;
+		uint32_t objectCount;
+
+		// Occlusion culling. No depth is tested while depthPyramidLevels is
+		// 0; depthTexture and depthSampler are only read when building level
+		// depthPyramidLevel.
+		uint32_t depthPyramidBuffer;
+		uint32_t depthPyramidWidth;
+		uint32_t depthPyramidHeight;
+		uint32_t depthPyramidLevels;
+		uint32_t depthTexture;
+		uint32_t depthSampler;
+		uint32_t depthPyramidLevel;
+	};
+
+	// One per draw command, what Cull.comp culls. Matches Object there.
+	struct CullObject
+	{
+		glm::vec4 boundingSphere;
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t instanceCount;
+	};
+
+	Avec<CullObject> cullObjects;
+	VkBuffer cullObjectBuffer;
+	Allocation cullObjectBufferAllocation;
+
+	// Written by the cull pass, consumed by vkCmdDrawIndexedIndirectCount.
+	// One per frame slot, so culling a frame on the compute queue overlaps
+	// with drawing the previous ones.
+	struct CullTargets
+	{
+		VkBuffer drawBuffer;
+		Allocation drawBufferAllocation;
+		VkBuffer countBuffer;
+		Allocation countBufferAllocation;
+
+		// Descriptor heap indices.
+		uint32_t drawBufferIndex;
+		uint32_t countBufferIndex;
+	};
+
+	Avec<CullTargets> cullTargets;
+
+	// Released by the compute queue's cull submission, acquired by the
+	// frame's graphics command buffer.
+	BufferOwnershipTransfer cullTransfer;
+
+	DrawPushConstants drawPushConstants{};
+
+	// Farthest depth of the first active view, halved level by level down
+	// to one texel and packed into one buffer. Level 0 is half the depth
+	// buffer's size. Written by the DepthPyramid pass after the view's main
+	// pass and tested against by the next frame's cull pass.
+	VkBuffer depthPyramidBuffer = VK_NULL_HANDLE;
+	Allocation depthPyramidBufferAllocation;
+	VkExtent2D depthPyramidExtent {};
+	uint32_t depthPyramidLevelCount { 0 };
+	VkSampler depthSampler = VK_NULL_HANDLE;
+
+	// Descriptor heap index of the sampled view of the depth buffer the
+	// pyramid is built from, UINT32_MAX without one.
+	uint32_t depthTextureIndex { UINT32_MAX };
+
+	// Set once a frame has built the current pyramid buffer, until then the
+	// cull pass tests no depth. With the cull on the compute queue it also
+	// means the buffer was released to the compute family.
+	bool depthPyramidBuilt { false };
+
+	// Dynamic offset of the FrameUniforms the cull pass reads the frustum
+	// from. The views share the camera, so one cull pass serves all of them.
+	uint32_t frameUniformOffset { 0 };
+
+	struct DrawCommand
+	{
+		uint32_t indexCount;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t firstInstance;
+	};
+
+	// Command buffers of one frame slot. Every recording job owns one
+	// transient pool, so pools are never shared between threads and are reset
+	// wholesale once the frame scheduler has handed the slot out again.
+	struct FrameCommands
+	{
+		VkCommandPool primaryPool;
+		VkCommandBuffer primaryCommandBuffer;
+
+		// Uploads, only when there is a dedicated transfer queue.
+		VkCommandPool transferPool = VK_NULL_HANDLE;
+		VkCommandBuffer transferCommandBuffer = VK_NULL_HANDLE;
+
+		// Culling, only when it runs on the compute queue.
+		VkCommandPool computePool = VK_NULL_HANDLE;
+		VkCommandBuffer computeCommandBuffer = VK_NULL_HANDLE;
+
+		Avec<VkCommandPool> secondaryPools;
+		Avec<VkCommandBuffer> secondaryCommandBuffers;
+	};
+
+	std::unique_ptr<ThreadPool> recordingThreads;
+	Avec<FrameCommands> frameCommands;
+	Avec<DrawCommand> drawCommands;
+
+	// Acquire and present only work with binary semaphores, frame pacing is
+	// left to the timelines of the frame scheduler. One present waits for
+	// the frame's submission for all views, so renderFinishedSemaphores are
+	// only per frame slot.
+	Avec<VkSemaphore> renderFinishedSemaphores;
+
+	FrameScheduler frameScheduler;
+	DeletionQueue deletionQueue;
+	uint32_t graphicsTimeline { 0 };
+	uint32_t transferTimeline { 0 };
+	uint32_t computeTimeline { 0 };
+
+	// DirtyFlagBits collected since the last frame. The first frame is always
+	// rendered.
+	std::atomic<uint32_t> dirtyFlags { DIRTY_ALL };
+	FrameRateLimiter frameRateLimiter;
+	// -------------------------
+
+	VkQueue graphicsQueue;
+	VkQueue presentQueue;
+
+	// Queues of families without graphics support when the device has them,
+	// graphicsQueue otherwise. Without a transfer-only family uploads go to
+	// the compute queue, which can copy as well.
+	VkQueue transferQueue;
+	VkQueue computeQueue;
+
+	uint32_t graphicsFamily { 0 };
+	uint32_t transferFamily { 0 };
+	uint32_t computeFamily { 0 };
+
+	VkDebugUtilsMessengerEXT debugMessenger;
+	DebugLog debugLog;
+
+	const Avec<const char*> validationLayers = {
+		"VK_LAYER_KHRONOS_validation"
+	};
+
+	const Avec<const char*> swapChainExtensions = {
+		VK_KHR_SWAPCHAIN_EXTENSION_NAME
+	};
+
+#ifdef NDEBUG
+	const bool enableValidationLayers = false;
+#else
+	const bool enableValidationLayers = true;
+#endif
+
+	void initWindow();
+	void addWindow(GLFWwindow* window);
+	View* findView(GLFWwindow* window);
+	static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
+
+	// The window contents were damaged, by being uncovered for example.
+	static void windowRefreshCallback(GLFWwindow* window);
+
+	static void cursorPosCallback(GLFWwindow* window, double x, double y);
+	static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+	static void scrollCallback(GLFWwindow* window, double x, double y);
+
+	// Number keys set the frames in flight, V toggles verbose and info
+	// validation messages.
+	static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+	// Destroys a view's images at shutdown, a resize retires them with
+	// retireSwapChain() instead. The pipeline and command pool survive a
+	// resize thanks to dynamic viewport and scissor state.
+	void cleanUpSwapChain(View& view);
+
+	// Gives the views marked resized new swap chains, or takes minimized
+	// ones out of the render graph until they have a size again. No device
+	// wait: the frames in flight keep rendering with the old swap chains and
+	// graph, which are retired and destroyed once the GPU has passed them.
+	// The graph is rebuilt once for all views that changed.
+	void recreateSwapChains();
+
+	// Moves a view's swap chain and image views to the deletion queue.
+	void retireSwapChain(View& view);
+
+	// Moves the render graph to the deletion queue and leaves an empty one
+	// behind.
+	void retireRenderGraph();
+
+	bool hasActiveView() const
+	{
+		return std::any_of(views.begin(), views.end(), [](const View& view) { return view.active; });
+	}
+
+	void initVulkan();
+
+	uint32_t getFrameSlotCount() const
+	{
+		return std::max(settings.framesInFlight, settings.maxFramesInFlight);
+	}
+
+	void createSyncObjects();
+	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const AllocationCreateInfo& allocInfo, VkBuffer& buffer, Allocation& allocation);
+	void destroyBuffer(VkBuffer buffer, const Allocation& allocation);
+
+	// Creates a device local buffer whose contents arrive through the staging
+	// ring with the next frame's transfers. Buffers read on another queue
+	// family than the graphics one pass it as dstFamily.
+	void createDeviceLocalBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, Allocation& allocation, uint32_t dstFamily = VK_QUEUE_FAMILY_IGNORED);
+
+	// The mesh of settings.meshPath with one draw per meshlet, or the
+	// triangle grid.
+	void createGeometry();
+
+	// Lays triangleCount triangles out on a square grid in clip space and
+	// splits them into draws of TRIANGLES_PER_DRAW triangles.
+	void createTriangleGrid();
+
+	// Imports and processes an OBJ or glTF file, or maps a mesh file, and
+	// fits it into the view: centered, y up and looking down -z.
+	void loadMesh(const Astr& path);
+
+	// Adds a draw of every instance of an index range, lower and upper
+	// bound its triangles in clip space.
+	void addDraw(uint32_t firstIndex, uint32_t indexCount, glm::vec3 lower, glm::vec3 upper);
+
+	// Everything createGeometry() queued for upload, aligned like the
+	// staging ring places it.
+	VkDeviceSize getInitialUploadSize() const;
+
+	void createVertexBuffer();
+	void createIndexBuffer();
+
+	// The staging ring has its own copy of the uploads.
+	void releaseGeometry();
+
+	void createInstanceBuffer();
+	void createCullingBuffers();
+	void destroyCullingBuffers();
+
+	// Creates the pyramid buffer for a depth buffer of the given size,
+	// retiring the one of another size.
+	void createDepthPyramid(VkExtent2D extent);
+	void createDepthSampler();
+	void destroyDepthPyramid();
+
+	bool isReadbackEnabled() const
+	{
+		return !settings.captureDirectory.empty() || !frameConsumers.empty();
+	}
+
+	void createFrameReadback();
+	void createFrameCommands();
+	void destroyFrameCommands();
+
+	// Copies the queued uploads on the dedicated transfer queue, so they do
+	// not wait behind rendering on the graphics queue. Returns what the
+	// frame's graphics submission has to wait for.
+	Avec<FrameScheduler::TimelineWait> submitUploads();
+
+	// Culling is submitted to the compute queue when there is one, and is
+	// a pass of the render graph otherwise.
+	bool isCullOnComputeQueue() const
+	{
+		return settings.gpuDrivenDraws && computeQueue != graphicsQueue;
+	}
+
+	// Pushes the FrameUniforms of every active view and points the draw
+	// push constants at the current slot's cull targets.
+	void updateFrameConstants();
+
+	// Resets the draw count and culls on the compute queue, after the
+	// uploads of the frame. Ownership of the slot's cull targets is then
+	// released to the graphics queue. Returns what the frame's graphics
+	// submission has to wait for.
+	Avec<FrameScheduler::TimelineWait> submitCull(const Avec<FrameScheduler::TimelineWait>& uploadWaits);
+
+	// Records the command buffers of the current frame slot, targeting the
+	// imageIndex of every active view. Must only be called after the slot has
+	// been handed out by frameScheduler.beginFrame() and the frame constants
+	// have been updated.
+	VkCommandBuffer recordFrame();
+
+	// Writes an indirect draw for every object in the view frustum into
+	// the current slot's cull targets, the draw count goes to countBuffer.
+	void recordCullPass(VkCommandBuffer commandBuffer);
+
+	// Builds the depth pyramid from the depth buffer at depthTextureIndex,
+	// one dispatch per level. With the cull on the compute queue the
+	// pyramid is then released to it.
+	void recordDepthPyramidPass(VkCommandBuffer commandBuffer);
+
+	// Gribb and Hartmann: the planes of the clip volume -w <= x, y <= w and
+	// 0 <= z <= w in world space, from the rows of the matrix.
+	static void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+	// Executes the MainPass of a view, inside its render pass. The draws are
+	// split into jobs recorded in parallel into secondary command buffers.
+	void recordMainPass(uint32_t viewIndex, const RenderGraph::PassContext& context);
+
+	// Records the job-th slice of drawCommands for a view into the secondary
+	// command buffer at index secondary. Runs on a recording thread.
+	void recordDrawJob(FrameCommands& frame, uint32_t secondary, uint32_t job, uint32_t jobCount, const View& view, const RenderGraph::PassContext& context);
+
+	// Describes the frame to the render graph, which derives the render pass,
+	// its load and store ops and the layout transitions of the backbuffer.
+	// Every active view adds its backbuffer, attachments and main pass; the
+	// transient attachments of different views can share memory.
+	void buildRenderGraph();
+
+	// Names graph resources and passes after their view when there are several.
+	Astr getViewName(const char* name, uint32_t viewIndex) const
+	{
+		return views.size() > 1 ? Astr(name) + " " + std::to_string(viewIndex) : Astr(name);
+	}
+
+	void addViewResources(uint32_t viewIndex);
+	void addMainPass(uint32_t viewIndex);
+	void addDepthPyramidPass(uint32_t viewIndex);
+
+	// Also called by pipeline reload builds, which do not overlap with
+	// changes to reloadedShaders.
+	ShaderCode getShaderCode(const Astr& name) const;
+
+	VkShaderModule createShaderModule(const ShaderCode& code) const;
+	void createPipelineLayout();
+	void createGraphicsPipeline();
+	void createComputePipelines();
+
+	PipelineTargets getPipelineTargets() const
+	{
+		return { renderPass, mainPassFormats };
+	}
+
+	// Only reads state that is fixed after initialization besides targets,
+	// so it can run on another thread.
+	VkPipeline buildGraphicsPipeline(const PipelineTargets& targets, const ShaderCode& vertShaderCode, const ShaderCode& fragShaderCode) const;
+
+	VkPipeline buildComputePipeline(const ShaderCode& code) const;
+
+	// Builds the pipelines that use the given shaders on a worker thread,
+	// through the pipeline cache. Stages that did not change are taken from
+	// what is in use.
+	void startPipelineReload(Amap<Astr, Avec<uint32_t>> shaders);
+
+	// Called at the start of a frame, before anything is recorded. Swaps in
+	// a finished build and starts the next one, never waits for either.
+	void updatePipelineReload();
+
+	void applyPipelineReload(PipelineReload reload);
+
+	// Frames in flight keep using the old pipeline until they are done.
+	void swapPipeline(VkPipeline& pipeline, VkPipeline newPipeline);
+
+	void destroyPipelineReload(const PipelineReload& reload);
+	void releaseReloadRetiredGraphs();
+
+	// Stops watching and drops a build still running, on shutdown.
+	void finishPipelineReload();
+
+	static bool isSameRenderingFormats(const RenderGraph::RenderingFormats& a, const RenderGraph::RenderingFormats& b)
+	{
+		return a.colorFormats == b.colorFormats && a.depthFormat == b.depthFormat && a.stencilFormat == b.stencilFormat && a.samples == b.samples;
+	}
+
+	void createImageViews(View& view);
+
+	// Created before the device is picked, which has to present to all of them.
+	void createSurfaces();
+
+	void createOffscreenTargets(View& view);
+
+	struct SwapChainSupportDetails
+	{
+		VkSurfaceCapabilitiesKHR capabilities;
+		Avec<VkSurfaceFormatKHR> formats;
+		Avec<VkPresentModeKHR> presentModes;
+	};
+
+	SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
+	void createLogicalDevice();
+	void pickPhysicalDevice();
+	void chooseAttachmentFormats();
+	VkFormat findDepthFormat();
+
+	struct QueueFamilyIndices
+	{
+		std::optional<uint32_t> graphicsFamily;
+		std::optional<uint32_t> presentFamily;
+
+		// Families without graphics support, unset when the device has none
+		// and the graphics family has to do the work.
+		std::optional<uint32_t> transferFamily;
+		std::optional<uint32_t> computeFamily;
+
+		bool isComplete(bool presentRequired = true)
+		{
+			return graphicsFamily.has_value() && (presentFamily.has_value() || !presentRequired);
+		}
+	};
+
+	QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
+
+	// The format the other views use comes first, one pipeline draws all of
+	// them.
+	VkSurfaceFormatKHR chooseSwapSurfaceFormat(const Avec<VkSurfaceFormatKHR>& availableFormats, VkFormat preferredFormat);
+
+	VkPresentModeKHR chooseSwapPresentMode(const Avec<VkPresentModeKHR>& availablePresentModes);
+	VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window);
+	void createSwapChain(View& view, VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE);
+	bool isDeviceSuitable(VkPhysicalDevice device);
+	bool checkDeviceFeatureSupport(VkPhysicalDevice device);
+	Avec<const char*> getRequiredDeviceExtensions();
+	bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+
+	// Optional, the GPU-driven path culls into a draw count the draw reads.
+	bool checkGpuDrivenDrawSupport(VkPhysicalDevice device);
+
+	// Optional, the render graph falls back to render pass objects.
+	bool checkDynamicRenderingSupport(VkPhysicalDevice device);
+
+	bool checkValidationLayerSupport();
+	void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
+	void setupDebugMessenger();
+	Avec<const char*> getRequiredExtensions();
+
+	// Runs on whatever thread made the call being validated, so it only
+	// hands the message to debugLog and returns.
+	static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
+		VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+		VkDebugUtilsMessageTypeFlagsEXT messageType,
+		const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+		void* pUserData
+	);
+
+	void createInstance();
+	void mainLoop();
+
+	// Closing any of the windows ends the application.
+	bool isAnyWindowClosed() const
+	{
+		return std::any_of(views.begin(), views.end(), [](const View& view) { return glfwWindowShouldClose(view.window); });
+	}
+
+	// Delivers the frames still in the readback buffers, the device has to
+	// be idle.
+	void collectReadback();
+
+	void drawFrameHeadless();
+	void drawFrame();
+
+	// Acquires an image of every active view. A view whose swap chain is out
+	// of date gets a new one right away, so every view in the render graph
+	// has an image to render to; a window minimized meanwhile drops out.
+	void acquireImages(uint32_t slot);
+
+	void exportProfile();
+	void cleanUp();
+};
+
+#endif
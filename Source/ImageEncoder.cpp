@@ -0,0 +1,314 @@
+#include "Pch.h"
+#include "ImageEncoder.h"
+
+namespace
+{
+	void appendBigEndian(Avec<uint8_t>& data, uint32_t value)
+	{
+		data.push_back(static_cast<uint8_t>(value >> 24));
+		data.push_back(static_cast<uint8_t>(value >> 16));
+		data.push_back(static_cast<uint8_t>(value >> 8));
+		data.push_back(static_cast<uint8_t>(value));
+	}
+
+	uint32_t readBigEndian(const uint8_t* data)
+	{
+		return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8) | data[3];
+	}
+}
+
+bool ImageEncoder::isSupported(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+		return true;
+	default:
+		return false;
+	}
+}
+
+Avec<uint8_t> ImageEncoder::toRgba8(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch, VkFormat format)
+{
+	if (!isSupported(format))
+	{
+		throw std::runtime_error("Unsupported image format for encoding.");
+	}
+
+	bool swapRedBlue = format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+
+	Avec<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+
+	for (uint32_t y = 0; y < height; y++)
+	{
+		const uint8_t* source = pixels + static_cast<size_t>(y) * rowPitch;
+		uint8_t* destination = rgba.data() + static_cast<size_t>(y) * width * 4;
+
+		if (!swapRedBlue)
+		{
+			std::memcpy(destination, source, static_cast<size_t>(width) * 4);
+			continue;
+		}
+
+		for (uint32_t x = 0; x < width; x++)
+		{
+			destination[x * 4 + 0] = source[x * 4 + 2];
+			destination[x * 4 + 1] = source[x * 4 + 1];
+			destination[x * 4 + 2] = source[x * 4 + 0];
+			destination[x * 4 + 3] = source[x * 4 + 3];
+		}
+	}
+
+	return rgba;
+}
+
+void ImageEncoder::write(const Astr& path, ImageFileFormat fileFormat, const uint8_t* rgba, uint32_t width, uint32_t height)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open image file for writing: " + path);
+	}
+
+	switch (fileFormat)
+	{
+	case ImageFileFormat::Png:
+		writePng(file, rgba, width, height);
+		break;
+	case ImageFileFormat::Raw:
+		file.write(reinterpret_cast<const char*>(rgba), static_cast<std::streamsize>(width) * height * 4);
+		break;
+	}
+
+	if (!file)
+	{
+		throw std::runtime_error("Failed to write image file: " + path);
+	}
+}
+
+Avec<uint8_t> ImageEncoder::readPng(const Astr& path, uint32_t& width, uint32_t& height)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open image file: " + path);
+	}
+
+	Avec<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	static const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+	if (bytes.size() < sizeof(signature) || std::memcmp(bytes.data(), signature, sizeof(signature)) != 0)
+	{
+		throw std::runtime_error("Not a PNG file: " + path);
+	}
+
+	// Collect IHDR and the concatenated IDAT chunks.
+	bool hasHeader = false;
+	Avec<uint8_t> data;
+	size_t offset = sizeof(signature);
+
+	while (offset + 12 <= bytes.size())
+	{
+		uint32_t length = readBigEndian(&bytes[offset]);
+		const uint8_t* type = &bytes[offset + 4];
+		const uint8_t* chunk = &bytes[offset + 8];
+
+		if (length > bytes.size() - offset - 12)
+		{
+			throw std::runtime_error("Truncated PNG file: " + path);
+		}
+
+		if (std::memcmp(type, "IHDR", 4) == 0 && length == 13)
+		{
+			width = readBigEndian(chunk);
+			height = readBigEndian(chunk + 4);
+
+			if (chunk[8] != 8 || chunk[9] != 6 || chunk[12] != 0)
+			{
+				throw std::runtime_error("Only non-interlaced 8-bit RGBA PNGs are supported: " + path);
+			}
+
+			hasHeader = true;
+		}
+		else if (std::memcmp(type, "IDAT", 4) == 0)
+		{
+			data.insert(data.end(), chunk, chunk + length);
+		}
+		else if (std::memcmp(type, "IEND", 4) == 0)
+		{
+			break;
+		}
+
+		offset += 12 + static_cast<size_t>(length);
+	}
+
+	if (!hasHeader || data.size() < 2)
+	{
+		throw std::runtime_error("PNG file has no image data: " + path);
+	}
+
+	// Undo writePng(): zlib header, stored blocks, filter type 0 per row.
+	size_t rowSize = static_cast<size_t>(width) * 4 + 1;
+	Avec<uint8_t> rows;
+	rows.reserve(rowSize * height);
+
+	size_t position = 2;
+	bool last = false;
+
+	while (!last)
+	{
+		if (position + 5 > data.size() || (data[position] & 0x06) != 0)
+		{
+			throw std::runtime_error("Only uncompressed PNGs are supported: " + path);
+		}
+
+		last = (data[position] & 1) != 0;
+		size_t length = data[position + 1] | (data[position + 2] << 8);
+		position += 5;
+
+		if (position + length > data.size())
+		{
+			throw std::runtime_error("Truncated PNG image data: " + path);
+		}
+
+		rows.insert(rows.end(), data.begin() + position, data.begin() + position + length);
+		position += length;
+	}
+
+	if (rows.size() != rowSize * height)
+	{
+		throw std::runtime_error("PNG image data does not match its size: " + path);
+	}
+
+	Avec<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+
+	for (uint32_t y = 0; y < height; y++)
+	{
+		const uint8_t* row = rows.data() + y * rowSize;
+
+		if (row[0] != 0)
+		{
+			throw std::runtime_error("Only unfiltered PNGs are supported: " + path);
+		}
+
+		std::memcpy(rgba.data() + static_cast<size_t>(y) * width * 4, row + 1, static_cast<size_t>(width) * 4);
+	}
+
+	return rgba;
+}
+
+const char* ImageEncoder::getExtension(ImageFileFormat fileFormat)
+{
+	return fileFormat == ImageFileFormat::Png ? "png" : "rgba";
+}
+
+void ImageEncoder::writePng(std::ostream& out, const uint8_t* rgba, uint32_t width, uint32_t height)
+{
+	static const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+	Avec<uint8_t> header;
+	appendBigEndian(header, width);
+	appendBigEndian(header, height);
+	header.push_back(8);	// Bit depth
+	header.push_back(6);	// RGBA
+	header.push_back(0);	// Deflate
+	header.push_back(0);	// Adaptive filtering
+	header.push_back(0);	// No interlace
+	writeChunk(out, "IHDR", header);
+
+	// Every scanline is prefixed with filter type 0, none. The zlib stream
+	// holds them in stored blocks of at most 65535 bytes.
+	size_t rowSize = static_cast<size_t>(width) * 4 + 1;
+	size_t imageSize = rowSize * height;
+	constexpr size_t MAX_BLOCK_SIZE = 65535;
+
+	Avec<uint8_t> data;
+	data.reserve(imageSize + imageSize / MAX_BLOCK_SIZE * 5 + 11);
+	data.push_back(0x78);	// Deflate, 32 KiB window
+	data.push_back(0x01);	// No preset dictionary, check bits
+
+	uint32_t adlerA = 1;
+	uint32_t adlerB = 0;
+	size_t blockRemaining = 0;
+
+	for (size_t offset = 0; offset < imageSize; offset++)
+	{
+		if (blockRemaining == 0)
+		{
+			blockRemaining = std::min(MAX_BLOCK_SIZE, imageSize - offset);
+			uint16_t length = static_cast<uint16_t>(blockRemaining);
+
+			data.push_back(offset + blockRemaining == imageSize ? 1 : 0);
+			data.push_back(static_cast<uint8_t>(length));
+			data.push_back(static_cast<uint8_t>(length >> 8));
+			data.push_back(static_cast<uint8_t>(~length));
+			data.push_back(static_cast<uint8_t>(~length >> 8));
+		}
+
+		size_t x = offset % rowSize;
+		uint8_t value = x == 0 ? 0 : rgba[offset / rowSize * (rowSize - 1) + x - 1];
+		data.push_back(value);
+
+		adlerA = (adlerA + value) % 65521;
+		adlerB = (adlerB + adlerA) % 65521;
+		blockRemaining--;
+	}
+
+	appendBigEndian(data, (adlerB << 16) | adlerA);
+	writeChunk(out, "IDAT", data);
+
+	writeChunk(out, "IEND", {});
+}
+
+void ImageEncoder::writeChunk(std::ostream& out, const char type[4], const Avec<uint8_t>& data)
+{
+	Avec<uint8_t> length;
+	appendBigEndian(length, static_cast<uint32_t>(data.size()));
+	out.write(reinterpret_cast<const char*>(length.data()), 4);
+
+	out.write(type, 4);
+	out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+	uint32_t crc = crc32(0xffffffffu, reinterpret_cast<const uint8_t*>(type), 4);
+	crc = crc32(crc, data.data(), data.size()) ^ 0xffffffffu;
+
+	Avec<uint8_t> crcBytes;
+	appendBigEndian(crcBytes, crc);
+	out.write(reinterpret_cast<const char*>(crcBytes.data()), 4);
+}
+
+uint32_t ImageEncoder::crc32(uint32_t crc, const uint8_t* data, size_t size)
+{
+	static const auto table = []()
+	{
+		std::array<uint32_t, 256> values{};
+
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t value = i;
+
+			for (int bit = 0; bit < 8; bit++)
+			{
+				value = (value & 1) ? 0xedb88320u ^ (value >> 1) : value >> 1;
+			}
+
+			values[i] = value;
+		}
+
+		return values;
+	}();
+
+	for (size_t i = 0; i < size; i++)
+	{
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+
+	return crc;
+}
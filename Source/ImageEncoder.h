@@ -0,0 +1,42 @@
+#ifndef __ImageEncoder_h__
+#define __ImageEncoder_h__
+
+#pragma once
+
+#include "Pch.h"
+
+enum class ImageFileFormat
+{
+	// RGBA8 PNG with uncompressed deflate blocks: any viewer opens it, and
+	// writing costs little more than the raw copy.
+	Png,
+
+	// Tightly packed RGBA8 rows, top row first, no header.
+	Raw
+};
+
+// Writes 8-bit, 4-channel images from readback buffers to files.
+class ImageEncoder
+{
+public:
+	// Whether toRgba8() understands the format.
+	static bool isSupported(VkFormat format);
+
+	// Converts rows of rowPitch bytes in format to tightly packed RGBA8.
+	static Avec<uint8_t> toRgba8(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch, VkFormat format);
+
+	static void write(const Astr& path, ImageFileFormat fileFormat, const uint8_t* rgba, uint32_t width, uint32_t height);
+
+	// Reads back a PNG as written by write(): RGBA8, stored deflate blocks
+	// and unfiltered rows. Throws for anything else.
+	static Avec<uint8_t> readPng(const Astr& path, uint32_t& width, uint32_t& height);
+
+	static const char* getExtension(ImageFileFormat fileFormat);
+
+private:
+	static void writePng(std::ostream& out, const uint8_t* rgba, uint32_t width, uint32_t height);
+	static void writeChunk(std::ostream& out, const char type[4], const Avec<uint8_t>& data);
+	static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size);
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "Pch.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const Astr& path)
+{
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Failed to open " + path);
+	}
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		throw std::runtime_error("Failed to map " + path + ", the file is empty or unreadable.");
+	}
+
+	HANDLE fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* view = fileMapping ? MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+	if (view == nullptr)
+	{
+		if (fileMapping)
+		{
+			CloseHandle(fileMapping);
+		}
+		CloseHandle(file);
+		throw std::runtime_error("Failed to map " + path);
+	}
+
+	fileHandle = file;
+	mappingHandle = fileMapping;
+	mapping = static_cast<const uint8_t*>(view);
+	fileSize = static_cast<size_t>(size.QuadPart);
+}
+
+MappedFile::~MappedFile()
+{
+	UnmapViewOfFile(mapping);
+	CloseHandle(mappingHandle);
+	CloseHandle(fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const Astr& path)
+{
+	int file = open(path.c_str(), O_RDONLY);
+
+	if (file < 0)
+	{
+		throw std::runtime_error("Failed to open " + path);
+	}
+
+	struct stat status{};
+	if (fstat(file, &status) != 0 || status.st_size == 0)
+	{
+		close(file);
+		throw std::runtime_error("Failed to map " + path + ", the file is empty or unreadable.");
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+	// The mapping keeps its own reference to the file.
+	close(file);
+
+	if (view == MAP_FAILED)
+	{
+		throw std::runtime_error("Failed to map " + path);
+	}
+
+	mapping = static_cast<const uint8_t*>(view);
+	fileSize = static_cast<size_t>(status.st_size);
+}
+
+MappedFile::~MappedFile()
+{
+	munmap(const_cast<uint8_t*>(mapping), fileSize);
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef __MappedFile_h__
+#define __MappedFile_h__
+
+#pragma once
+
+#include "Pch.h"
+
+// Read-only memory mapping of a whole file. The contents are paged in by the
+// OS on first access instead of being copied through a stream, and stay
+// mapped until the object is destroyed.
+class MappedFile
+{
+public:
+	explicit MappedFile(const Astr& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Page aligned.
+	const uint8_t* data() const
+	{
+		return mapping;
+	}
+
+	size_t size() const
+	{
+		return fileSize;
+	}
+
+private:
+	const uint8_t* mapping = nullptr;
+	size_t fileSize { 0 };
+
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef __Mesh_h__
+#define __Mesh_h__
+
+#pragma once
+
+#include "Pch.h"
+#include "Vertex.h"
+
+// Vertex as imported, before quantization.
+struct MeshVertex
+{
+	glm::vec3 position { 0.0f };
+	glm::vec3 normal { 0.0f };
+	glm::vec2 uv { 0.0f };
+};
+
+// Indexed triangle list as imported: y up, front faces clockwise seen from
+// the front like the renderer's.
+struct MeshData
+{
+	Avec<MeshVertex> vertices;
+	Avec<uint32_t> indices;
+
+	// Vertices the source had no normal for, MeshProcessor generates theirs
+	// from the triangles around them.
+	Avec<uint32_t> verticesWithoutNormals;
+};
+
+// A run of consecutive triangles of the index buffer, culled and drawn as
+// one. Small enough for a mesh shader workgroup.
+struct Meshlet
+{
+	// Model space, xyz center and w radius.
+	glm::vec4 boundingSphere;
+
+	// Normal cone: xyz axis, w cutoff. Every triangle faces away from a
+	// camera at p when dot(center - p, axis) >= cutoff * length(center - p)
+	// + radius. A cutoff of 1 never culls.
+	glm::vec4 cone;
+
+	uint32_t firstIndex;
+	uint32_t triangleCount;
+	uint32_t vertexCount;
+	uint32_t reserved;
+};
+
+// Mesh ready for upload, pointing into a Mesh or a mapped MeshFile.
+// Positions are the normalized unorm16 position * positionScale +
+// positionOffset.
+struct MeshView
+{
+	const Vertex* vertices = nullptr;
+	uint32_t vertexCount { 0 };
+	const uint32_t* indices = nullptr;
+	uint32_t indexCount { 0 };
+	const Meshlet* meshlets = nullptr;
+	uint32_t meshletCount { 0 };
+
+	glm::vec3 positionScale { 1.0f };
+	glm::vec3 positionOffset { 0.0f };
+};
+
+// Quantized, optimized mesh as built by MeshProcessor::process().
+struct Mesh
+{
+	Avec<Vertex> vertices;
+	Avec<uint32_t> indices;
+	Avec<Meshlet> meshlets;
+
+	glm::vec3 positionScale { 1.0f };
+	glm::vec3 positionOffset { 0.0f };
+
+	MeshView getView() const
+	{
+		MeshView view;
+		view.vertices = vertices.data();
+		view.vertexCount = static_cast<uint32_t>(vertices.size());
+		view.indices = indices.data();
+		view.indexCount = static_cast<uint32_t>(indices.size());
+		view.meshlets = meshlets.data();
+		view.meshletCount = static_cast<uint32_t>(meshlets.size());
+		view.positionScale = positionScale;
+		view.positionOffset = positionOffset;
+
+		return view;
+	}
+};
+
+#endif
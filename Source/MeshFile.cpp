@@ -0,0 +1,129 @@
+#include "Pch.h"
+#include "MeshFile.h"
+#include "AllocationStrategy.h"
+
+namespace
+{
+	bool isInBounds(uint64_t offset, uint64_t size, uint64_t fileSize)
+	{
+		return offset <= fileSize && size <= fileSize - offset;
+	}
+}
+
+MeshFile::MeshFile(const Astr& path)
+	: file(path)
+{
+	FileHeader header{};
+
+	if (file.size() < sizeof(FileHeader))
+	{
+		throw std::runtime_error("Mesh file " + path + " is truncated.");
+	}
+
+	std::memcpy(&header, file.data(), sizeof(FileHeader));
+
+	if (header.magic != FILE_MAGIC || header.version != FILE_VERSION || header.vertexSize != sizeof(Vertex) || header.meshletSize != sizeof(Meshlet))
+	{
+		throw std::runtime_error(path + " is not a mesh file of a supported version.");
+	}
+
+	uint64_t vertexBytes = static_cast<uint64_t>(header.vertexCount) * sizeof(Vertex);
+	uint64_t indexBytes = static_cast<uint64_t>(header.indexCount) * sizeof(uint32_t);
+	uint64_t meshletBytes = static_cast<uint64_t>(header.meshletCount) * sizeof(Meshlet);
+
+	bool inBounds = header.fileSize == file.size() &&
+		isInBounds(header.vertexOffset, vertexBytes, file.size()) &&
+		isInBounds(header.indexOffset, indexBytes, file.size()) &&
+		isInBounds(header.meshletOffset, meshletBytes, file.size());
+
+	bool aligned = header.vertexOffset % SECTION_ALIGNMENT == 0 && header.indexOffset % SECTION_ALIGNMENT == 0 && header.meshletOffset % SECTION_ALIGNMENT == 0;
+
+	if (!inBounds || !aligned || header.indexCount % 3 != 0)
+	{
+		throw std::runtime_error("Mesh file " + path + " is malformed.");
+	}
+
+	// The mapping is page aligned, so are the sections at aligned offsets.
+	view.vertices = reinterpret_cast<const Vertex*>(file.data() + header.vertexOffset);
+	view.vertexCount = header.vertexCount;
+	view.indices = reinterpret_cast<const uint32_t*>(file.data() + header.indexOffset);
+	view.indexCount = header.indexCount;
+	view.meshlets = reinterpret_cast<const Meshlet*>(file.data() + header.meshletOffset);
+	view.meshletCount = header.meshletCount;
+	view.positionScale = glm::vec3(header.positionScale[0], header.positionScale[1], header.positionScale[2]);
+	view.positionOffset = glm::vec3(header.positionOffset[0], header.positionOffset[1], header.positionOffset[2]);
+
+	// The GPU reads indices and meshlet ranges unchecked, better fail here.
+	// The pages are touched by the upload right after anyway.
+	for (uint32_t i = 0; i < view.indexCount; i++)
+	{
+		if (view.indices[i] >= view.vertexCount)
+		{
+			throw std::runtime_error("Mesh file " + path + " has an index out of range.");
+		}
+	}
+
+	for (uint32_t i = 0; i < view.meshletCount; i++)
+	{
+		const Meshlet& meshlet = view.meshlets[i];
+
+		if (meshlet.firstIndex > view.indexCount || meshlet.triangleCount > (view.indexCount - meshlet.firstIndex) / 3)
+		{
+			throw std::runtime_error("Mesh file " + path + " has a meshlet out of range.");
+		}
+	}
+}
+
+void MeshFile::write(const Astr& path, const MeshView& mesh)
+{
+	FileHeader header{};
+	header.magic = FILE_MAGIC;
+	header.version = FILE_VERSION;
+	header.vertexSize = sizeof(Vertex);
+	header.meshletSize = sizeof(Meshlet);
+	header.vertexCount = mesh.vertexCount;
+	header.indexCount = mesh.indexCount;
+	header.meshletCount = mesh.meshletCount;
+
+	for (int i = 0; i < 3; i++)
+	{
+		header.positionScale[i] = mesh.positionScale[i];
+		header.positionOffset[i] = mesh.positionOffset[i];
+	}
+
+	header.vertexOffset = alignUp(sizeof(FileHeader), SECTION_ALIGNMENT);
+	header.indexOffset = alignUp(header.vertexOffset + static_cast<uint64_t>(mesh.vertexCount) * sizeof(Vertex), SECTION_ALIGNMENT);
+	header.meshletOffset = alignUp(header.indexOffset + static_cast<uint64_t>(mesh.indexCount) * sizeof(uint32_t), SECTION_ALIGNMENT);
+	header.fileSize = header.meshletOffset + static_cast<uint64_t>(mesh.meshletCount) * sizeof(Meshlet);
+
+	std::ofstream output(path, std::ios::binary | std::ios::trunc);
+
+	if (!output.is_open())
+	{
+		throw std::runtime_error("Failed to open " + path + " for writing.");
+	}
+
+	static const char padding[SECTION_ALIGNMENT] = {};
+
+	auto writeSection = [&](uint64_t offset, const void* data, uint64_t size)
+	{
+		uint64_t position = static_cast<uint64_t>(output.tellp());
+		output.write(padding, static_cast<std::streamsize>(offset - position));
+		output.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+	};
+
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	writeSection(header.vertexOffset, mesh.vertices, static_cast<uint64_t>(mesh.vertexCount) * sizeof(Vertex));
+	writeSection(header.indexOffset, mesh.indices, static_cast<uint64_t>(mesh.indexCount) * sizeof(uint32_t));
+	writeSection(header.meshletOffset, mesh.meshlets, static_cast<uint64_t>(mesh.meshletCount) * sizeof(Meshlet));
+
+	if (!output)
+	{
+		throw std::runtime_error("Failed to write mesh file " + path);
+	}
+}
+
+bool MeshFile::isMeshFile(const Astr& path)
+{
+	return std::filesystem::path(path).extension() == EXTENSION;
+}
@@ -0,0 +1,61 @@
+#ifndef __MeshFile_h__
+#define __MeshFile_h__
+
+#pragma once
+
+#include "Pch.h"
+#include "Mesh.h"
+#include "MappedFile.h"
+
+// Processed mesh in a single memory mapped file. The vertices, indices and
+// meshlets are stored exactly as uploaded, so loading is only mapping the
+// file and the view handed out points straight into the mapping; it is
+// valid as long as the file is.
+//
+// Layout: a FileHeader, then the vertices, indices and meshlets, each at a
+// SECTION_ALIGNMENT aligned offset from the start of the file.
+class MeshFile
+{
+public:
+	static constexpr const char* EXTENSION { ".amesh" };
+
+	explicit MeshFile(const Astr& path);
+
+	const MeshView& getView() const
+	{
+		return view;
+	}
+
+	static void write(const Astr& path, const MeshView& mesh);
+
+	static bool isMeshFile(const Astr& path);
+
+private:
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertexSize;
+		uint32_t meshletSize;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t meshletCount;
+		uint32_t reserved;
+		float positionScale[4];
+		float positionOffset[4];
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+		uint64_t meshletOffset;
+		uint64_t fileSize;
+	};
+
+	static constexpr uint32_t FILE_MAGIC { 0x48534d41 }; // "AMSH"
+	static constexpr uint32_t FILE_VERSION { 1 };
+	static constexpr uint64_t SECTION_ALIGNMENT { 16 };
+
+	MappedFile file;
+
+	MeshView view;
+};
+
+#endif
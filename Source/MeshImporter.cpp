@@ -0,0 +1,1213 @@
+#include "Pch.h"
+#include "MeshImporter.h"
+
+namespace
+{
+	Avec<uint8_t> readFile(const Astr& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Failed to open mesh file: " + path);
+		}
+
+		return Avec<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	}
+
+	Astr getLowerCaseExtension(const Astr& path)
+	{
+		Astr extension = std::filesystem::path(path).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+		return extension;
+	}
+
+	// ---------- OBJ ----------
+
+	struct ObjCorner
+	{
+		uint32_t position;
+		uint32_t uv;
+		uint32_t normal;
+
+		bool operator==(const ObjCorner& other) const
+		{
+			return position == other.position && uv == other.uv && normal == other.normal;
+		}
+	};
+
+	struct ObjCornerHash
+	{
+		size_t operator()(const ObjCorner& corner) const
+		{
+			size_t hash = corner.position;
+			hash = hash * 31 + corner.uv;
+			hash = hash * 31 + corner.normal;
+
+			return hash;
+		}
+	};
+
+	constexpr uint32_t OBJ_NONE { std::numeric_limits<uint32_t>::max() };
+
+	// Parses within one line: strtof alone would skip over the line end.
+	class ObjLine
+	{
+	public:
+		ObjLine(const char* begin, const char* end, size_t lineNumber)
+			: cursor { begin }, end { end }, lineNumber { lineNumber }
+		{
+		}
+
+		void skipSpaces()
+		{
+			while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r'))
+			{
+				cursor++;
+			}
+		}
+
+		bool atEnd()
+		{
+			skipSpaces();
+			return cursor == end || *cursor == '#';
+		}
+
+		Astr keyword()
+		{
+			skipSpaces();
+			const char* start = cursor;
+
+			while (cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r')
+			{
+				cursor++;
+			}
+
+			return Astr(start, cursor);
+		}
+
+		float number()
+		{
+			if (atEnd())
+			{
+				fail("number expected");
+			}
+
+			char* next = nullptr;
+			float value = std::strtof(cursor, &next);
+
+			if (next == cursor || next > end)
+			{
+				fail("number expected");
+			}
+
+			cursor = next;
+			return value;
+		}
+
+		// An OBJ index, 1-based or negative counting back from the last
+		// element, as a 0-based index.
+		uint32_t index(size_t count)
+		{
+			char* next = nullptr;
+			long value = std::strtol(cursor, &next, 10);
+
+			if (next == cursor || next > end)
+			{
+				fail("index expected");
+			}
+
+			cursor = next;
+
+			long resolved = value > 0 ? value - 1 : static_cast<long>(count) + value;
+
+			if (value == 0 || resolved < 0 || static_cast<size_t>(resolved) >= count)
+			{
+				fail("index out of range");
+			}
+
+			return static_cast<uint32_t>(resolved);
+		}
+
+		// v, v/vt, v//vn or v/vt/vn.
+		ObjCorner corner(size_t positionCount, size_t uvCount, size_t normalCount)
+		{
+			ObjCorner corner { OBJ_NONE, OBJ_NONE, OBJ_NONE };
+			corner.position = index(positionCount);
+
+			if (cursor < end && *cursor == '/')
+			{
+				cursor++;
+
+				if (cursor < end && *cursor != '/')
+				{
+					corner.uv = index(uvCount);
+				}
+
+				if (cursor < end && *cursor == '/')
+				{
+					cursor++;
+					corner.normal = index(normalCount);
+				}
+			}
+
+			return corner;
+		}
+
+		[[noreturn]] void fail(const char* what) const
+		{
+			throw std::runtime_error("OBJ line " + std::to_string(lineNumber) + ": " + what + ".");
+		}
+
+	private:
+		const char* cursor;
+		const char* end;
+		size_t lineNumber;
+	};
+
+	// ---------- JSON ----------
+
+	struct JsonValue
+	{
+		enum class Type
+		{
+			Null,
+			Boolean,
+			Number,
+			String,
+			Array,
+			Object
+		};
+
+		Type type { Type::Null };
+		bool boolean { false };
+		double number { 0.0 };
+		Astr string;
+		Avec<JsonValue> array;
+		Avec<std::pair<Astr, JsonValue>> object;
+
+		const JsonValue* find(const char* key) const
+		{
+			for (const auto& [name, value] : object)
+			{
+				if (name == key)
+				{
+					return &value;
+				}
+			}
+
+			return nullptr;
+		}
+
+		double getNumber(const char* key, double fallback) const
+		{
+			const JsonValue* value = find(key);
+			return value != nullptr && value->type == Type::Number ? value->number : fallback;
+		}
+
+		const Avec<JsonValue>& getArray(const char* key) const
+		{
+			static const Avec<JsonValue> empty;
+
+			const JsonValue* value = find(key);
+			return value != nullptr && value->type == Type::Array ? value->array : empty;
+		}
+	};
+
+	// Just enough JSON for glTF: the whole document into JsonValues.
+	class JsonParser
+	{
+	public:
+		JsonParser(const char* begin, const char* end)
+			: cursor { begin }, end { end }
+		{
+		}
+
+		JsonValue parse()
+		{
+			JsonValue value = parseValue(0);
+			skipWhitespace();
+
+			if (cursor != end)
+			{
+				fail("trailing characters");
+			}
+
+			return value;
+		}
+
+	private:
+		static constexpr int MAX_DEPTH { 256 };
+
+		const char* cursor;
+		const char* end;
+
+		[[noreturn]] void fail(const char* what) const
+		{
+			throw std::runtime_error(Astr("Malformed glTF JSON: ") + what + ".");
+		}
+
+		void skipWhitespace()
+		{
+			while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r'))
+			{
+				cursor++;
+			}
+		}
+
+		bool consume(char c)
+		{
+			skipWhitespace();
+
+			if (cursor < end && *cursor == c)
+			{
+				cursor++;
+				return true;
+			}
+
+			return false;
+		}
+
+		void expect(char c)
+		{
+			if (!consume(c))
+			{
+				fail("unexpected character");
+			}
+		}
+
+		bool consumeLiteral(const char* literal)
+		{
+			size_t length = std::strlen(literal);
+
+			if (static_cast<size_t>(end - cursor) >= length && std::memcmp(cursor, literal, length) == 0)
+			{
+				cursor += length;
+				return true;
+			}
+
+			return false;
+		}
+
+		JsonValue parseValue(int depth)
+		{
+			if (depth > MAX_DEPTH)
+			{
+				fail("nested too deeply");
+			}
+
+			skipWhitespace();
+
+			if (cursor == end)
+			{
+				fail("unexpected end");
+			}
+
+			JsonValue value;
+
+			if (consume('{'))
+			{
+				value.type = JsonValue::Type::Object;
+
+				if (!consume('}'))
+				{
+					do
+					{
+						skipWhitespace();
+						Astr key = parseString();
+						expect(':');
+						value.object.emplace_back(std::move(key), parseValue(depth + 1));
+					} while (consume(','));
+
+					expect('}');
+				}
+			}
+			else if (consume('['))
+			{
+				value.type = JsonValue::Type::Array;
+
+				if (!consume(']'))
+				{
+					do
+					{
+						value.array.push_back(parseValue(depth + 1));
+					} while (consume(','));
+
+					expect(']');
+				}
+			}
+			else if (*cursor == '"')
+			{
+				value.type = JsonValue::Type::String;
+				value.string = parseString();
+			}
+			else if (consumeLiteral("true"))
+			{
+				value.type = JsonValue::Type::Boolean;
+				value.boolean = true;
+			}
+			else if (consumeLiteral("false"))
+			{
+				value.type = JsonValue::Type::Boolean;
+			}
+			else if (consumeLiteral("null"))
+			{
+				value.type = JsonValue::Type::Null;
+			}
+			else
+			{
+				value.type = JsonValue::Type::Number;
+				value.number = parseNumber();
+			}
+
+			return value;
+		}
+
+		double parseNumber()
+		{
+			// The document is not null terminated, strtod gets a copy.
+			Astr text;
+
+			while (cursor < end && (std::isdigit(static_cast<unsigned char>(*cursor)) || *cursor == '-' || *cursor == '+' || *cursor == '.' || *cursor == 'e' || *cursor == 'E'))
+			{
+				text += *cursor++;
+			}
+
+			char* next = nullptr;
+			double number = std::strtod(text.c_str(), &next);
+
+			if (text.empty() || next != text.c_str() + text.size())
+			{
+				fail("invalid number");
+			}
+
+			return number;
+		}
+
+		uint32_t parseHex4()
+		{
+			if (end - cursor < 4)
+			{
+				fail("truncated escape");
+			}
+
+			uint32_t value = 0;
+
+			for (int i = 0; i < 4; i++)
+			{
+				char c = *cursor++;
+				value <<= 4;
+
+				if (c >= '0' && c <= '9')
+				{
+					value |= c - '0';
+				}
+				else if (c >= 'a' && c <= 'f')
+				{
+					value |= c - 'a' + 10;
+				}
+				else if (c >= 'A' && c <= 'F')
+				{
+					value |= c - 'A' + 10;
+				}
+				else
+				{
+					fail("invalid escape");
+				}
+			}
+
+			return value;
+		}
+
+		static void appendUtf8(Astr& text, uint32_t codePoint)
+		{
+			if (codePoint < 0x80)
+			{
+				text += static_cast<char>(codePoint);
+			}
+			else if (codePoint < 0x800)
+			{
+				text += static_cast<char>(0xc0 | (codePoint >> 6));
+				text += static_cast<char>(0x80 | (codePoint & 0x3f));
+			}
+			else if (codePoint < 0x10000)
+			{
+				text += static_cast<char>(0xe0 | (codePoint >> 12));
+				text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+				text += static_cast<char>(0x80 | (codePoint & 0x3f));
+			}
+			else
+			{
+				text += static_cast<char>(0xf0 | (codePoint >> 18));
+				text += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+				text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+				text += static_cast<char>(0x80 | (codePoint & 0x3f));
+			}
+		}
+
+		Astr parseString()
+		{
+			if (cursor == end || *cursor != '"')
+			{
+				fail("string expected");
+			}
+
+			cursor++;
+			Astr text;
+
+			while (true)
+			{
+				if (cursor == end)
+				{
+					fail("unterminated string");
+				}
+
+				char c = *cursor++;
+
+				if (c == '"')
+				{
+					return text;
+				}
+
+				if (c != '\\')
+				{
+					text += c;
+					continue;
+				}
+
+				if (cursor == end)
+				{
+					fail("unterminated string");
+				}
+
+				char escape = *cursor++;
+
+				switch (escape)
+				{
+				case '"': text += '"'; break;
+				case '\\': text += '\\'; break;
+				case '/': text += '/'; break;
+				case 'b': text += '\b'; break;
+				case 'f': text += '\f'; break;
+				case 'n': text += '\n'; break;
+				case 'r': text += '\r'; break;
+				case 't': text += '\t'; break;
+				case 'u':
+				{
+					uint32_t codePoint = parseHex4();
+
+					// A surrogate pair encodes one code point past the BMP.
+					if (codePoint >= 0xd800 && codePoint < 0xdc00 && end - cursor >= 6 && cursor[0] == '\\' && cursor[1] == 'u')
+					{
+						cursor += 2;
+						uint32_t low = parseHex4();
+						codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+					}
+
+					appendUtf8(text, codePoint);
+					break;
+				}
+				default:
+					fail("invalid escape");
+				}
+			}
+		}
+	};
+
+	// ---------- glTF ----------
+
+	constexpr uint32_t GLB_MAGIC { 0x46546c67 };		// "glTF"
+	constexpr uint32_t GLB_CHUNK_JSON { 0x4e4f534a };	// "JSON"
+	constexpr uint32_t GLB_CHUNK_BIN { 0x004e4942 };	// "BIN\0"
+
+	constexpr uint32_t GLTF_TRIANGLES { 4 };
+
+	enum GltfComponentType : uint32_t
+	{
+		GLTF_BYTE			= 5120,
+		GLTF_UNSIGNED_BYTE	= 5121,
+		GLTF_SHORT			= 5122,
+		GLTF_UNSIGNED_SHORT	= 5123,
+		GLTF_UNSIGNED_INT	= 5125,
+		GLTF_FLOAT			= 5126
+	};
+
+	[[noreturn]] void failGltf(const Astr& what)
+	{
+		throw std::runtime_error("Malformed glTF file: " + what + ".");
+	}
+
+	struct GltfDocument
+	{
+		JsonValue json;
+		Avec<Avec<uint8_t>> buffers;
+	};
+
+	// Elements of an accessor, still in their source layout.
+	struct GltfAccessor
+	{
+		const uint8_t* data = nullptr;
+		size_t count { 0 };
+		size_t stride { 0 };
+		uint32_t componentType { 0 };
+		uint32_t componentCount { 0 };
+		bool normalized { false };
+	};
+
+	const JsonValue& getElement(const JsonValue& document, const char* arrayName, double index)
+	{
+		const Avec<JsonValue>& array = document.getArray(arrayName);
+
+		if (index < 0.0 || index >= static_cast<double>(array.size()))
+		{
+			failGltf(Astr(arrayName) + " index out of range");
+		}
+
+		return array[static_cast<size_t>(index)];
+	}
+
+	Avec<uint8_t> decodeBase64(const Astr& text)
+	{
+		Avec<uint8_t> bytes;
+		bytes.reserve(text.size() / 4 * 3);
+
+		uint32_t bits = 0;
+		int bitCount = 0;
+
+		for (char c : text)
+		{
+			int value;
+
+			if (c >= 'A' && c <= 'Z') value = c - 'A';
+			else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+			else if (c >= '0' && c <= '9') value = c - '0' + 52;
+			else if (c == '+') value = 62;
+			else if (c == '/') value = 63;
+			else if (c == '=') break;
+			else failGltf("invalid base64 data");
+
+			bits = (bits << 6) | static_cast<uint32_t>(value);
+			bitCount += 6;
+
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				bytes.push_back(static_cast<uint8_t>(bits >> bitCount));
+			}
+		}
+
+		return bytes;
+	}
+
+	Astr decodeUri(const Astr& uri)
+	{
+		Astr decoded;
+
+		for (size_t i = 0; i < uri.size(); i++)
+		{
+			if (uri[i] == '%' && i + 2 < uri.size())
+			{
+				decoded += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+				i += 2;
+			}
+			else
+			{
+				decoded += uri[i];
+			}
+		}
+
+		return decoded;
+	}
+
+	GltfDocument loadGltf(const Astr& path)
+	{
+		Avec<uint8_t> file = readFile(path);
+		GltfDocument document;
+
+		const char* jsonBegin = reinterpret_cast<const char*>(file.data());
+		const char* jsonEnd = jsonBegin + file.size();
+		Avec<uint8_t> binaryChunk;
+
+		uint32_t magic = 0;
+
+		if (file.size() >= 4)
+		{
+			std::memcpy(&magic, file.data(), sizeof(magic));
+		}
+
+		// GLB: a 12-byte header, then a JSON chunk and an optional BIN chunk.
+		if (magic == GLB_MAGIC)
+		{
+			size_t offset = 12;
+			bool hasJson = false;
+
+			while (offset + 8 <= file.size())
+			{
+				uint32_t chunkLength;
+				uint32_t chunkType;
+				std::memcpy(&chunkLength, &file[offset], sizeof(chunkLength));
+				std::memcpy(&chunkType, &file[offset + 4], sizeof(chunkType));
+				offset += 8;
+
+				if (chunkLength > file.size() - offset)
+				{
+					failGltf("truncated GLB chunk");
+				}
+
+				if (chunkType == GLB_CHUNK_JSON && !hasJson)
+				{
+					jsonBegin = reinterpret_cast<const char*>(&file[offset]);
+					jsonEnd = jsonBegin + chunkLength;
+					hasJson = true;
+				}
+				else if (chunkType == GLB_CHUNK_BIN && binaryChunk.empty())
+				{
+					binaryChunk.assign(file.begin() + offset, file.begin() + offset + chunkLength);
+				}
+
+				offset += chunkLength;
+			}
+
+			if (!hasJson)
+			{
+				failGltf("GLB without JSON chunk");
+			}
+		}
+
+		document.json = JsonParser(jsonBegin, jsonEnd).parse();
+
+		std::filesystem::path directory = std::filesystem::path(path).parent_path();
+		const Avec<JsonValue>& buffers = document.json.getArray("buffers");
+
+		for (size_t i = 0; i < buffers.size(); i++)
+		{
+			const JsonValue* uri = buffers[i].find("uri");
+			Avec<uint8_t> buffer;
+
+			if (uri == nullptr || uri->type != JsonValue::Type::String)
+			{
+				// Only the first buffer of a GLB may live in the BIN chunk.
+				if (i != 0 || magic != GLB_MAGIC)
+				{
+					failGltf("buffer without uri");
+				}
+
+				buffer = std::move(binaryChunk);
+			}
+			else if (uri->string.compare(0, 5, "data:") == 0)
+			{
+				size_t comma = uri->string.find(',');
+
+				if (comma == Astr::npos || uri->string.rfind(";base64", comma) == Astr::npos)
+				{
+					failGltf("unsupported data uri");
+				}
+
+				buffer = decodeBase64(uri->string.substr(comma + 1));
+			}
+			else
+			{
+				buffer = readFile((directory / decodeUri(uri->string)).string());
+			}
+
+			if (buffer.size() < buffers[i].getNumber("byteLength", 0.0))
+			{
+				failGltf("buffer shorter than its byteLength");
+			}
+
+			document.buffers.push_back(std::move(buffer));
+		}
+
+		return document;
+	}
+
+	GltfAccessor getAccessor(const GltfDocument& document, double index)
+	{
+		const JsonValue& accessor = getElement(document.json, "accessors", index);
+
+		if (accessor.find("sparse") != nullptr)
+		{
+			failGltf("sparse accessors are not supported");
+		}
+
+		const JsonValue* viewIndex = accessor.find("bufferView");
+
+		if (viewIndex == nullptr || viewIndex->type != JsonValue::Type::Number)
+		{
+			failGltf("accessors without buffer view are not supported");
+		}
+
+		const JsonValue& view = getElement(document.json, "bufferViews", viewIndex->number);
+		double bufferIndex = view.getNumber("buffer", -1.0);
+
+		if (bufferIndex < 0.0 || bufferIndex >= static_cast<double>(document.buffers.size()))
+		{
+			failGltf("buffer index out of range");
+		}
+
+		const Avec<uint8_t>& buffer = document.buffers[static_cast<size_t>(bufferIndex)];
+
+		GltfAccessor result;
+		result.count = static_cast<size_t>(accessor.getNumber("count", 0.0));
+		result.componentType = static_cast<uint32_t>(accessor.getNumber("componentType", 0.0));
+
+		const JsonValue* normalized = accessor.find("normalized");
+		result.normalized = normalized != nullptr && normalized->type == JsonValue::Type::Boolean && normalized->boolean;
+
+		const JsonValue* type = accessor.find("type");
+		Astr typeName = type != nullptr ? type->string : Astr();
+
+		if (typeName == "SCALAR") result.componentCount = 1;
+		else if (typeName == "VEC2") result.componentCount = 2;
+		else if (typeName == "VEC3") result.componentCount = 3;
+		else if (typeName == "VEC4") result.componentCount = 4;
+		else failGltf("unsupported accessor type " + typeName);
+
+		size_t componentSize;
+
+		switch (result.componentType)
+		{
+		case GLTF_BYTE:
+		case GLTF_UNSIGNED_BYTE:
+			componentSize = 1;
+			break;
+		case GLTF_SHORT:
+		case GLTF_UNSIGNED_SHORT:
+			componentSize = 2;
+			break;
+		case GLTF_UNSIGNED_INT:
+		case GLTF_FLOAT:
+			componentSize = 4;
+			break;
+		default:
+			failGltf("unsupported component type");
+		}
+
+		size_t elementSize = componentSize * result.componentCount;
+		size_t viewOffset = static_cast<size_t>(view.getNumber("byteOffset", 0.0));
+		size_t viewLength = static_cast<size_t>(view.getNumber("byteLength", 0.0));
+		size_t offset = static_cast<size_t>(accessor.getNumber("byteOffset", 0.0));
+		result.stride = static_cast<size_t>(view.getNumber("byteStride", static_cast<double>(elementSize)));
+
+		bool inView = result.count == 0 || (result.stride >= elementSize && offset + result.stride * (result.count - 1) + elementSize <= viewLength);
+
+		if (!inView || viewOffset > buffer.size() || viewLength > buffer.size() - viewOffset)
+		{
+			failGltf("accessor out of bounds");
+		}
+
+		result.data = buffer.data() + viewOffset + offset;
+
+		return result;
+	}
+
+	float readComponent(const uint8_t* data, uint32_t componentType, bool normalized)
+	{
+		switch (componentType)
+		{
+		case GLTF_FLOAT:
+		{
+			float value;
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+		case GLTF_BYTE:
+		{
+			int8_t value = static_cast<int8_t>(data[0]);
+			return normalized ? std::max(value / 127.0f, -1.0f) : value;
+		}
+		case GLTF_UNSIGNED_BYTE:
+			return normalized ? data[0] / 255.0f : data[0];
+		case GLTF_SHORT:
+		{
+			int16_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+		}
+		case GLTF_UNSIGNED_SHORT:
+		{
+			uint16_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return normalized ? value / 65535.0f : value;
+		}
+		default:
+		{
+			uint32_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return static_cast<float>(value);
+		}
+		}
+	}
+
+	glm::vec4 readElement(const GltfAccessor& accessor, size_t index)
+	{
+		size_t componentSize = accessor.componentType == GLTF_FLOAT || accessor.componentType == GLTF_UNSIGNED_INT ? 4 : accessor.componentType <= GLTF_UNSIGNED_BYTE ? 1 : 2;
+		const uint8_t* element = accessor.data + index * accessor.stride;
+		glm::vec4 value(0.0f);
+
+		for (uint32_t i = 0; i < accessor.componentCount; i++)
+		{
+			value[i] = readComponent(element + i * componentSize, accessor.componentType, accessor.normalized);
+		}
+
+		return value;
+	}
+
+	uint32_t readIndex(const GltfAccessor& accessor, size_t index)
+	{
+		const uint8_t* element = accessor.data + index * accessor.stride;
+
+		switch (accessor.componentType)
+		{
+		case GLTF_UNSIGNED_BYTE:
+			return element[0];
+		case GLTF_UNSIGNED_SHORT:
+		{
+			uint16_t value;
+			std::memcpy(&value, element, sizeof(value));
+			return value;
+		}
+		case GLTF_UNSIGNED_INT:
+		{
+			uint32_t value;
+			std::memcpy(&value, element, sizeof(value));
+			return value;
+		}
+		default:
+			failGltf("unsupported index type");
+		}
+	}
+
+	glm::mat4 getNodeTransform(const JsonValue& node)
+	{
+		const Avec<JsonValue>& matrix = node.getArray("matrix");
+
+		if (matrix.size() == 16)
+		{
+			glm::mat4 transform;
+
+			for (int i = 0; i < 16; i++)
+			{
+				transform[i / 4][i % 4] = static_cast<float>(matrix[i].number);
+			}
+
+			return transform;
+		}
+
+		glm::vec3 translation(0.0f);
+		glm::vec4 rotation(0.0f, 0.0f, 0.0f, 1.0f);
+		glm::vec3 scale(1.0f);
+
+		const Avec<JsonValue>& translationValues = node.getArray("translation");
+		const Avec<JsonValue>& rotationValues = node.getArray("rotation");
+		const Avec<JsonValue>& scaleValues = node.getArray("scale");
+
+		for (size_t i = 0; i < 3 && i < translationValues.size(); i++) translation[i] = static_cast<float>(translationValues[i].number);
+		for (size_t i = 0; i < 4 && i < rotationValues.size(); i++) rotation[i] = static_cast<float>(rotationValues[i].number);
+		for (size_t i = 0; i < 3 && i < scaleValues.size(); i++) scale[i] = static_cast<float>(scaleValues[i].number);
+
+		// T * R * S with R from the unit quaternion (x, y, z, w).
+		float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+
+		glm::mat4 transform(1.0f);
+		transform[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f) * scale.x;
+		transform[1] = glm::vec4(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f) * scale.y;
+		transform[2] = glm::vec4(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f) * scale.z;
+		transform[3] = glm::vec4(translation, 1.0f);
+
+		return transform;
+	}
+
+	void appendPrimitive(const GltfDocument& document, const JsonValue& primitive, const glm::mat4& transform, MeshData& data)
+	{
+		if (primitive.getNumber("mode", GLTF_TRIANGLES) != GLTF_TRIANGLES)
+		{
+			return;
+		}
+
+		const JsonValue* attributes = primitive.find("attributes");
+		const JsonValue* positionIndex = attributes != nullptr ? attributes->find("POSITION") : nullptr;
+
+		if (positionIndex == nullptr)
+		{
+			failGltf("primitive without POSITION");
+		}
+
+		GltfAccessor positions = getAccessor(document, positionIndex->number);
+		std::optional<GltfAccessor> normals;
+		std::optional<GltfAccessor> uvs;
+
+		if (const JsonValue* normalIndex = attributes->find("NORMAL"))
+		{
+			normals = getAccessor(document, normalIndex->number);
+		}
+
+		if (const JsonValue* uvIndex = attributes->find("TEXCOORD_0"))
+		{
+			uvs = getAccessor(document, uvIndex->number);
+		}
+
+		if ((normals && normals->count < positions.count) || (uvs && uvs->count < positions.count))
+		{
+			failGltf("attribute shorter than POSITION");
+		}
+
+		glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3(transform)));
+		uint32_t baseVertex = static_cast<uint32_t>(data.vertices.size());
+
+		for (size_t i = 0; i < positions.count; i++)
+		{
+			MeshVertex vertex;
+			vertex.position = glm::vec3(transform * glm::vec4(glm::vec3(readElement(positions, i)), 1.0f));
+
+			if (normals)
+			{
+				glm::vec3 normal = normalTransform * glm::vec3(readElement(*normals, i));
+				float length = glm::length(normal);
+				vertex.normal = length > 0.0f ? normal / length : normal;
+			}
+			else
+			{
+				data.verticesWithoutNormals.push_back(static_cast<uint32_t>(data.vertices.size()));
+			}
+
+			if (uvs)
+			{
+				vertex.uv = glm::vec2(readElement(*uvs, i));
+			}
+
+			data.vertices.push_back(vertex);
+		}
+
+		Avec<uint32_t> indices;
+
+		if (const JsonValue* indicesIndex = primitive.find("indices"))
+		{
+			GltfAccessor accessor = getAccessor(document, indicesIndex->number);
+			indices.resize(accessor.count);
+
+			for (size_t i = 0; i < accessor.count; i++)
+			{
+				indices[i] = readIndex(accessor, i);
+
+				if (indices[i] >= positions.count)
+				{
+					failGltf("index out of range");
+				}
+			}
+		}
+		else
+		{
+			indices.resize(positions.count);
+
+			for (size_t i = 0; i < positions.count; i++)
+			{
+				indices[i] = static_cast<uint32_t>(i);
+			}
+		}
+
+		// A mirroring transform already turns the winding around.
+		bool mirrored = glm::determinant(glm::mat3(transform)) < 0.0f;
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			data.indices.push_back(baseVertex + indices[i]);
+			data.indices.push_back(baseVertex + indices[mirrored ? i + 1 : i + 2]);
+			data.indices.push_back(baseVertex + indices[mirrored ? i + 2 : i + 1]);
+		}
+	}
+
+	void appendMesh(const GltfDocument& document, double meshIndex, const glm::mat4& transform, MeshData& data)
+	{
+		const JsonValue& mesh = getElement(document.json, "meshes", meshIndex);
+
+		for (const JsonValue& primitive : mesh.getArray("primitives"))
+		{
+			appendPrimitive(document, primitive, transform, data);
+		}
+	}
+
+	void appendNode(const GltfDocument& document, double nodeIndex, const glm::mat4& parentTransform, MeshData& data, int depth)
+	{
+		// Node hierarchies are trees, this only stops malformed cycles.
+		constexpr int MAX_NODE_DEPTH { 256 };
+
+		if (depth > MAX_NODE_DEPTH)
+		{
+			failGltf("node hierarchy too deep");
+		}
+
+		const JsonValue& node = getElement(document.json, "nodes", nodeIndex);
+		glm::mat4 transform = parentTransform * getNodeTransform(node);
+
+		if (const JsonValue* mesh = node.find("mesh"))
+		{
+			appendMesh(document, mesh->number, transform, data);
+		}
+
+		for (const JsonValue& child : node.getArray("children"))
+		{
+			appendNode(document, child.number, transform, data, depth + 1);
+		}
+	}
+}
+
+MeshData MeshImporter::import(const Astr& path)
+{
+	Astr extension = getLowerCaseExtension(path);
+
+	if (extension == ".obj")
+	{
+		return importObj(path);
+	}
+
+	if (extension == ".gltf" || extension == ".glb")
+	{
+		return importGltf(path);
+	}
+
+	throw std::runtime_error("Unsupported mesh format: " + path);
+}
+
+bool MeshImporter::isSupported(const Astr& path)
+{
+	Astr extension = getLowerCaseExtension(path);
+	return extension == ".obj" || extension == ".gltf" || extension == ".glb";
+}
+
+MeshData MeshImporter::importObj(const Astr& path)
+{
+	// Terminated, so strtof() stops at the end of the last line.
+	Avec<uint8_t> file = readFile(path);
+	file.push_back(0);
+
+	const char* cursor = reinterpret_cast<const char*>(file.data());
+	const char* fileEnd = cursor + file.size() - 1;
+
+	Avec<glm::vec3> positions;
+	Avec<glm::vec2> uvs;
+	Avec<glm::vec3> normals;
+
+	MeshData data;
+	std::unordered_map<ObjCorner, uint32_t, ObjCornerHash> cornerVertices;
+	Avec<uint32_t> face;
+	size_t lineNumber = 0;
+
+	while (cursor < fileEnd)
+	{
+		const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', fileEnd - cursor));
+		lineEnd = lineEnd != nullptr ? lineEnd : fileEnd;
+
+		ObjLine line(cursor, lineEnd, ++lineNumber);
+		cursor = lineEnd < fileEnd ? lineEnd + 1 : fileEnd;
+
+		if (line.atEnd())
+		{
+			continue;
+		}
+
+		Astr keyword = line.keyword();
+
+		if (keyword == "v")
+		{
+			float x = line.number();
+			float y = line.number();
+			float z = line.number();
+			positions.emplace_back(x, y, z);
+		}
+		else if (keyword == "vt")
+		{
+			// OBJ puts v = 0 at the bottom, Vulkan and glTF at the top.
+			float u = line.number();
+			float v = line.atEnd() ? 0.0f : line.number();
+			uvs.emplace_back(u, 1.0f - v);
+		}
+		else if (keyword == "vn")
+		{
+			float x = line.number();
+			float y = line.number();
+			float z = line.number();
+			normals.emplace_back(x, y, z);
+		}
+		else if (keyword == "f")
+		{
+			face.clear();
+
+			while (!line.atEnd())
+			{
+				ObjCorner corner = line.corner(positions.size(), uvs.size(), normals.size());
+				auto [it, inserted] = cornerVertices.try_emplace(corner, static_cast<uint32_t>(data.vertices.size()));
+
+				if (inserted)
+				{
+					MeshVertex vertex;
+					vertex.position = positions[corner.position];
+					vertex.uv = corner.uv != OBJ_NONE ? uvs[corner.uv] : glm::vec2(0.0f);
+					vertex.normal = corner.normal != OBJ_NONE ? normals[corner.normal] : glm::vec3(0.0f);
+
+					if (corner.normal == OBJ_NONE)
+					{
+						data.verticesWithoutNormals.push_back(static_cast<uint32_t>(data.vertices.size()));
+					}
+
+					data.vertices.push_back(vertex);
+				}
+
+				face.push_back(it->second);
+			}
+
+			if (face.size() < 3)
+			{
+				line.fail("face with fewer than 3 corners");
+			}
+
+			// Fan, flipped to clockwise.
+			for (size_t i = 1; i + 1 < face.size(); i++)
+			{
+				data.indices.push_back(face[0]);
+				data.indices.push_back(face[i + 1]);
+				data.indices.push_back(face[i]);
+			}
+		}
+	}
+
+	if (data.indices.empty())
+	{
+		throw std::runtime_error("OBJ file has no faces: " + path);
+	}
+
+	return data;
+}
+
+MeshData MeshImporter::importGltf(const Astr& path)
+{
+	GltfDocument document = loadGltf(path);
+	MeshData data;
+
+	const Avec<JsonValue>& scenes = document.json.getArray("scenes");
+
+	if (scenes.empty())
+	{
+		for (size_t i = 0; i < document.json.getArray("meshes").size(); i++)
+		{
+			appendMesh(document, static_cast<double>(i), glm::mat4(1.0f), data);
+		}
+	}
+	else
+	{
+		const JsonValue& scene = getElement(document.json, "scenes", document.json.getNumber("scene", 0.0));
+
+		for (const JsonValue& node : scene.getArray("nodes"))
+		{
+			appendNode(document, node.number, glm::mat4(1.0f), data, 0);
+		}
+	}
+
+	if (data.indices.empty())
+	{
+		throw std::runtime_error("glTF file has no triangles: " + path);
+	}
+
+	return data;
+}
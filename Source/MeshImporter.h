@@ -0,0 +1,31 @@
+#ifndef __MeshImporter_h__
+#define __MeshImporter_h__
+
+#pragma once
+
+#include "Pch.h"
+#include "Mesh.h"
+
+// Reads triangle meshes from Wavefront OBJ and glTF 2.0 (.gltf with
+// external or embedded buffers, and .glb) files into one MeshData.
+// Materials are ignored. Both formats have counter-clockwise front faces,
+// the importer flips them to the renderer's clockwise ones.
+class MeshImporter
+{
+public:
+	// Picks the format by extension.
+	static MeshData import(const Astr& path);
+
+	static bool isSupported(const Astr& path);
+
+	// Positions, texture coordinates and normals of v, vt, vn and f
+	// statements; polygons are split into fans. Corners are merged when all
+	// their indices match.
+	static MeshData importObj(const Astr& path);
+
+	// Every triangle primitive of the default scene, with node transforms
+	// applied. Without scenes, every mesh as is.
+	static MeshData importGltf(const Astr& path);
+};
+
+#endif
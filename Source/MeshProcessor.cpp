@@ -0,0 +1,530 @@
+#include "Pch.h"
+#include "MeshProcessor.h"
+
+namespace
+{
+	constexpr uint32_t INVALID_TRIANGLE { std::numeric_limits<uint32_t>::max() };
+
+	// Scoring of Forsyth's optimizer: vertices of the last triangle score a
+	// fixed amount, older ones less the further back they are in the cache,
+	// and vertices with few triangles left get a boost so they are finished
+	// off instead of left behind.
+	float scoreVertex(int32_t cachePosition, uint32_t remainingTriangles)
+	{
+		constexpr float CACHE_DECAY_POWER { 1.5f };
+		constexpr float LAST_TRIANGLE_SCORE { 0.75f };
+		constexpr float VALENCE_BOOST_SCALE { 2.0f };
+		constexpr float VALENCE_BOOST_POWER { 0.5f };
+
+		if (remainingTriangles == 0)
+		{
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+
+		if (cachePosition >= 0 && cachePosition < 3)
+		{
+			score = LAST_TRIANGLE_SCORE;
+		}
+		else if (cachePosition >= 3)
+		{
+			float scaler = 1.0f / (MeshProcessor::VERTEX_CACHE_SIZE - 3);
+			score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+		}
+
+		return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+	}
+
+	// Outward for clockwise front faces.
+	glm::vec3 triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		return glm::cross(c - a, b - a);
+	}
+
+	uint16_t quantizeUnorm16(float value)
+	{
+		return static_cast<uint16_t>(std::lround(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	int16_t quantizeSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::lround(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+}
+
+Mesh MeshProcessor::process(MeshData data, MeshStatistics* statistics)
+{
+	if (data.indices.size() % 3 != 0)
+	{
+		throw std::runtime_error("Mesh index count is not a multiple of 3.");
+	}
+
+	for (uint32_t index : data.indices)
+	{
+		if (index >= data.vertices.size())
+		{
+			throw std::runtime_error("Mesh index out of range.");
+		}
+	}
+
+	if (!data.verticesWithoutNormals.empty())
+	{
+		generateNormals(data);
+	}
+
+	float acmrBefore = computeAcmr(data.indices, data.vertices.size(), MEASURED_CACHE_SIZE);
+	size_t bytesBefore = data.vertices.size() * sizeof(MeshVertex) + data.indices.size() * sizeof(uint32_t);
+
+	optimizeVertexCache(data.indices, data.vertices.size());
+	optimizeVertexFetch(data.vertices, data.indices);
+
+	Mesh mesh;
+	mesh.meshlets = buildMeshlets(data.vertices, data.indices);
+	mesh.vertices = quantize(data.vertices, mesh.positionScale, mesh.positionOffset);
+	mesh.indices = std::move(data.indices);
+
+	if (statistics != nullptr)
+	{
+		statistics->vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+		statistics->triangleCount = static_cast<uint32_t>(mesh.indices.size() / 3);
+		statistics->meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+		statistics->acmrBefore = acmrBefore;
+		statistics->acmrAfter = computeAcmr(mesh.indices, mesh.vertices.size(), MEASURED_CACHE_SIZE);
+		statistics->bytesBefore = bytesBefore;
+		statistics->bytesAfter = mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(uint32_t) + mesh.meshlets.size() * sizeof(Meshlet);
+	}
+
+	return mesh;
+}
+
+void MeshProcessor::generateNormals(MeshData& data)
+{
+	Avec<bool> missing(data.vertices.size(), false);
+
+	for (uint32_t vertex : data.verticesWithoutNormals)
+	{
+		missing[vertex] = true;
+		data.vertices[vertex].normal = glm::vec3(0.0f);
+	}
+
+	// The cross product is twice the area, so larger triangles weigh more.
+	for (size_t i = 0; i + 2 < data.indices.size(); i += 3)
+	{
+		uint32_t corners[3] = { data.indices[i], data.indices[i + 1], data.indices[i + 2] };
+
+		if (!missing[corners[0]] && !missing[corners[1]] && !missing[corners[2]])
+		{
+			continue;
+		}
+
+		glm::vec3 normal = triangleNormal(data.vertices[corners[0]].position, data.vertices[corners[1]].position, data.vertices[corners[2]].position);
+
+		for (uint32_t corner : corners)
+		{
+			if (missing[corner])
+			{
+				data.vertices[corner].normal += normal;
+			}
+		}
+	}
+
+	for (uint32_t vertex : data.verticesWithoutNormals)
+	{
+		glm::vec3& normal = data.vertices[vertex].normal;
+		float length = glm::length(normal);
+		normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+	}
+
+	data.verticesWithoutNormals.clear();
+}
+
+void MeshProcessor::optimizeVertexCache(Avec<uint32_t>& indices, size_t vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// Triangles around every vertex; the first remainingTriangles[v] of a
+	// vertex's range are the ones not emitted yet.
+	Avec<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+
+	for (uint32_t index : indices)
+	{
+		adjacencyOffsets[index + 1]++;
+	}
+
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+	}
+
+	Avec<uint32_t> adjacency(indices.size());
+	Avec<uint32_t> remainingTriangles(vertexCount, 0);
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		uint32_t v = indices[i];
+		adjacency[adjacencyOffsets[v] + remainingTriangles[v]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	Avec<int32_t> cachePositions(vertexCount, -1);
+	Avec<float> vertexScores(vertexCount);
+
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = scoreVertex(-1, remainingTriangles[v]);
+	}
+
+	Avec<float> triangleScores(triangleCount);
+	Avec<bool> emitted(triangleCount, false);
+	uint32_t bestTriangle = 0;
+
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+		if (triangleScores[t] > triangleScores[bestTriangle])
+		{
+			bestTriangle = static_cast<uint32_t>(t);
+		}
+	}
+
+	Avec<uint32_t> result;
+	result.reserve(indices.size());
+
+	Avec<uint32_t> cache;
+	Avec<uint32_t> nextCache;
+	cache.reserve(VERTEX_CACHE_SIZE + 3);
+	nextCache.reserve(VERTEX_CACHE_SIZE + 3);
+
+	// Where the search for a triangle resumes once the cache holds none.
+	size_t deadEndCursor = 0;
+
+	while (result.size() < indices.size())
+	{
+		if (bestTriangle == INVALID_TRIANGLE)
+		{
+			while (emitted[deadEndCursor])
+			{
+				deadEndCursor++;
+			}
+
+			bestTriangle = static_cast<uint32_t>(deadEndCursor);
+		}
+
+		const uint32_t* triangle = &indices[bestTriangle * 3];
+		emitted[bestTriangle] = true;
+		result.insert(result.end(), triangle, triangle + 3);
+
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			uint32_t v = triangle[corner];
+			uint32_t* first = &adjacency[adjacencyOffsets[v]];
+			uint32_t* last = first + remainingTriangles[v];
+
+			*std::find(first, last, bestTriangle) = *(last - 1);
+			remainingTriangles[v]--;
+		}
+
+		// The triangle's vertices move to the front, the rest shift back
+		// and those pushed past the cache size fall out.
+		nextCache.clear();
+
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			if (std::find(nextCache.begin(), nextCache.end(), triangle[corner]) == nextCache.end())
+			{
+				nextCache.push_back(triangle[corner]);
+			}
+		}
+
+		for (uint32_t v : cache)
+		{
+			if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+			{
+				nextCache.push_back(v);
+			}
+		}
+
+		std::swap(cache, nextCache);
+
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			uint32_t v = cache[i];
+			int32_t position = i < VERTEX_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+			float score = scoreVertex(position, remainingTriangles[v]);
+			float delta = score - vertexScores[v];
+
+			cachePositions[v] = position;
+			vertexScores[v] = score;
+
+			for (uint32_t j = 0; j < remainingTriangles[v]; j++)
+			{
+				triangleScores[adjacency[adjacencyOffsets[v] + j]] += delta;
+			}
+		}
+
+		if (cache.size() > VERTEX_CACHE_SIZE)
+		{
+			cache.resize(VERTEX_CACHE_SIZE);
+		}
+
+		// Only triangles touching the cache changed score, the best one
+		// is among them unless it is empty of candidates.
+		bestTriangle = INVALID_TRIANGLE;
+		float bestScore = -std::numeric_limits<float>::max();
+
+		for (uint32_t v : cache)
+		{
+			for (uint32_t j = 0; j < remainingTriangles[v]; j++)
+			{
+				uint32_t t = adjacency[adjacencyOffsets[v] + j];
+
+				if (triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					bestTriangle = t;
+				}
+			}
+		}
+	}
+
+	indices = std::move(result);
+}
+
+void MeshProcessor::optimizeVertexFetch(Avec<MeshVertex>& vertices, Avec<uint32_t>& indices)
+{
+	constexpr uint32_t UNUSED { std::numeric_limits<uint32_t>::max() };
+
+	Avec<uint32_t> remap(vertices.size(), UNUSED);
+	Avec<MeshVertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == UNUSED)
+		{
+			remap[index] = static_cast<uint32_t>(reordered.size());
+			reordered.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices = std::move(reordered);
+}
+
+Avec<Meshlet> MeshProcessor::buildMeshlets(const Avec<MeshVertex>& vertices, const Avec<uint32_t>& indices)
+{
+	Avec<Meshlet> meshlets;
+
+	// Meshlet a vertex was last counted for, so it is counted once each.
+	Avec<uint32_t> lastMeshlet(vertices.size(), std::numeric_limits<uint32_t>::max());
+	Avec<uint32_t> meshletVertices;
+
+	size_t first = 0;
+
+	auto finishMeshlet = [&](size_t end)
+	{
+		Meshlet meshlet{};
+		meshlet.firstIndex = static_cast<uint32_t>(first);
+		meshlet.triangleCount = static_cast<uint32_t>((end - first) / 3);
+		meshlet.vertexCount = static_cast<uint32_t>(meshletVertices.size());
+
+		// Sphere around the center of the bounding box, not the smallest,
+		// but close for the compact meshlets cache order produces.
+		glm::vec3 lower = vertices[meshletVertices[0]].position;
+		glm::vec3 upper = lower;
+
+		for (uint32_t v : meshletVertices)
+		{
+			lower = glm::min(lower, vertices[v].position);
+			upper = glm::max(upper, vertices[v].position);
+		}
+
+		glm::vec3 center = (lower + upper) * 0.5f;
+		float radius = 0.0f;
+
+		for (uint32_t v : meshletVertices)
+		{
+			radius = std::max(radius, glm::length(vertices[v].position - center));
+		}
+
+		meshlet.boundingSphere = glm::vec4(center, radius);
+
+		// The cone axis is the average triangle normal; it only culls when
+		// every triangle is within 84 degrees of it.
+		Avec<glm::vec3> normals;
+		glm::vec3 axis(0.0f);
+
+		for (size_t i = first; i < end; i += 3)
+		{
+			glm::vec3 normal = triangleNormal(vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position);
+			float length = glm::length(normal);
+
+			if (length > 0.0f)
+			{
+				normals.push_back(normal / length);
+				axis += normal / length;
+			}
+		}
+
+		float axisLength = glm::length(axis);
+		float minDot = 1.0f;
+
+		if (axisLength > 0.0f)
+		{
+			axis /= axisLength;
+
+			for (const glm::vec3& normal : normals)
+			{
+				minDot = std::min(minDot, glm::dot(axis, normal));
+			}
+		}
+
+		float cutoff = axisLength > 0.0f && minDot > 0.1f ? std::sqrt(1.0f - minDot * minDot) : 1.0f;
+		meshlet.cone = glm::vec4(axis, cutoff);
+
+		meshlets.push_back(meshlet);
+		meshletVertices.clear();
+		first = end;
+	};
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		uint32_t meshletIndex = static_cast<uint32_t>(meshlets.size());
+		uint32_t newVertices = 0;
+
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			bool counted = lastMeshlet[indices[i + corner]] == meshletIndex;
+			bool repeated = (corner > 0 && indices[i + corner] == indices[i]) || (corner > 1 && indices[i + corner] == indices[i + 1]);
+			newVertices += counted || repeated ? 0 : 1;
+		}
+
+		size_t triangles = (i - first) / 3;
+
+		if (meshletVertices.size() + newVertices > MAX_MESHLET_VERTICES || triangles + 1 > MAX_MESHLET_TRIANGLES)
+		{
+			finishMeshlet(i);
+			meshletIndex++;
+		}
+
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			uint32_t v = indices[i + corner];
+
+			if (lastMeshlet[v] != meshletIndex)
+			{
+				lastMeshlet[v] = meshletIndex;
+				meshletVertices.push_back(v);
+			}
+		}
+	}
+
+	if (first < indices.size())
+	{
+		finishMeshlet(indices.size());
+	}
+
+	return meshlets;
+}
+
+float MeshProcessor::computeAcmr(const Avec<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+	if (indices.empty())
+	{
+		return 0.0f;
+	}
+
+	// Time every vertex entered the cache; it is still in there while fewer
+	// than cacheSize misses happened since.
+	Avec<uint64_t> insertedAt(vertexCount, 0);
+	uint64_t misses = 0;
+
+	for (uint32_t index : indices)
+	{
+		if (insertedAt[index] == 0 || misses - insertedAt[index] + 1 > cacheSize)
+		{
+			misses++;
+			insertedAt[index] = misses;
+		}
+	}
+
+	return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
+
+Avec<Vertex> MeshProcessor::quantize(const Avec<MeshVertex>& vertices, glm::vec3& positionScale, glm::vec3& positionOffset)
+{
+	glm::vec3 lower(0.0f);
+	glm::vec3 upper(0.0f);
+
+	if (!vertices.empty())
+	{
+		lower = vertices[0].position;
+		upper = lower;
+	}
+
+	for (const auto& vertex : vertices)
+	{
+		lower = glm::min(lower, vertex.position);
+		upper = glm::max(upper, vertex.position);
+	}
+
+	// The vertex fetch already normalizes unorm16 to [0, 1].
+	glm::vec3 extent = upper - lower;
+	positionScale = extent;
+	positionOffset = lower;
+
+	Avec<Vertex> quantized(vertices.size());
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const MeshVertex& source = vertices[i];
+		Vertex& vertex = quantized[i];
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float relative = extent[axis] > 0.0f ? (source.position[axis] - lower[axis]) / extent[axis] : 0.0f;
+			vertex.position[axis] = quantizeUnorm16(relative);
+		}
+
+		vertex.position[3] = 0;
+
+		std::array<int16_t, 2> normal = encodeOctahedral(source.normal);
+		vertex.normal[0] = normal[0];
+		vertex.normal[1] = normal[1];
+
+		uint32_t uv = glm::packHalf2x16(source.uv);
+		vertex.uv[0] = static_cast<uint16_t>(uv);
+		vertex.uv[1] = static_cast<uint16_t>(uv >> 16);
+	}
+
+	return quantized;
+}
+
+std::array<int16_t, 2> MeshProcessor::encodeOctahedral(glm::vec3 normal)
+{
+	float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+
+	if (sum == 0.0f)
+	{
+		return { 0, 0 };
+	}
+
+	normal /= sum;
+	glm::vec2 encoded(normal.x, normal.y);
+
+	// The lower half folds over the diagonals onto the corners.
+	if (normal.z < 0.0f)
+	{
+		encoded.x = (1.0f - std::abs(normal.y)) * (normal.x >= 0.0f ? 1.0f : -1.0f);
+		encoded.y = (1.0f - std::abs(normal.x)) * (normal.y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	return { quantizeSnorm16(encoded.x), quantizeSnorm16(encoded.y) };
+}
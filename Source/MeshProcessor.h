@@ -0,0 +1,69 @@
+#ifndef __MeshProcessor_h__
+#define __MeshProcessor_h__
+
+#pragma once
+
+#include "Pch.h"
+#include "Mesh.h"
+
+// What process() did to a mesh, for the converter to report.
+struct MeshStatistics
+{
+	uint32_t vertexCount { 0 };
+	uint32_t triangleCount { 0 };
+	uint32_t meshletCount { 0 };
+
+	// Average vertex shader invocations per triangle, before and after.
+	float acmrBefore { 0.0f };
+	float acmrAfter { 0.0f };
+
+	size_t bytesBefore { 0 };
+	size_t bytesAfter { 0 };
+};
+
+// Turns imported geometry into what the renderer draws. Every step also
+// works on its own.
+class MeshProcessor
+{
+public:
+	// Post-transform cache the vertex order is optimized for, and the FIFO
+	// cache ACMR is measured with, which is closer to actual hardware.
+	static constexpr uint32_t VERTEX_CACHE_SIZE { 32 };
+	static constexpr uint32_t MEASURED_CACHE_SIZE { 16 };
+
+	static constexpr uint32_t MAX_MESHLET_VERTICES { 64 };
+	static constexpr uint32_t MAX_MESHLET_TRIANGLES { 124 };
+
+	// Generates missing normals, optimizes the vertex cache and fetch
+	// order, splits the triangles into meshlets and quantizes the vertices.
+	static Mesh process(MeshData data, MeshStatistics* statistics = nullptr);
+
+	// Area weighted normals of the triangles around every vertex of
+	// verticesWithoutNormals, other vertices keep theirs.
+	static void generateNormals(MeshData& data);
+
+	// Reorders triangles so vertices are reused while still in the
+	// post-transform cache, after Tom Forsyth's linear-speed optimizer.
+	static void optimizeVertexCache(Avec<uint32_t>& indices, size_t vertexCount);
+
+	// Orders vertices by first use in the index buffer, which keeps vertex
+	// fetches sequential, and drops unused ones.
+	static void optimizeVertexFetch(Avec<MeshVertex>& vertices, Avec<uint32_t>& indices);
+
+	// Splits the index buffer in order into meshlets of at most
+	// MAX_MESHLET_VERTICES unique vertices and MAX_MESHLET_TRIANGLES
+	// triangles. The index buffer is left as is, every meshlet is a range.
+	static Avec<Meshlet> buildMeshlets(const Avec<MeshVertex>& vertices, const Avec<uint32_t>& indices);
+
+	// Vertices transformed per triangle with a FIFO cache of cacheSize.
+	static float computeAcmr(const Avec<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize);
+
+	// Positions are stored relative to the bounds of all vertices, which
+	// the returned scale and offset restore.
+	static Avec<Vertex> quantize(const Avec<MeshVertex>& vertices, glm::vec3& positionScale, glm::vec3& positionOffset);
+
+	// Unit normal on an octahedron unfolded into a square, as snorm16.
+	static std::array<int16_t, 2> encodeOctahedral(glm::vec3 normal);
+};
+
+#endif
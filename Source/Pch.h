@@ -4,25 +4,51 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <optional>
 #include <string>
 #include <vector>
 #include <map>
 #include <set>
+#include <deque>
+#include <unordered_map>
+#include <tuple>
+#include <limits>
 
 #include <stdexcept>
 #include <iostream>
 #include <cstdint>
 #include <cstdlib>
+#include <cmath>
 #include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cctype>
+
+#include <chrono>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <future>
 
 #define NOMINMAX
 
+#ifdef _WIN32
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#ifdef _WIN32
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h>
+#endif
+
+#include <glm/glm.hpp>
 
 template <typename T>
 using Avec		= std::vector<T>;
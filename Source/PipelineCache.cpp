@@ -0,0 +1,214 @@
+#include "Pch.h"
+#include "PipelineCache.h"
+
+void PipelineCache::create(VkDevice device, VkPhysicalDevice physicalDevice, const Astr& directory)
+{
+	this->device = device;
+
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	std::ostringstream name;
+	name << std::hex << std::setfill('0');
+	name << "pipeline_" << std::setw(4) << properties.vendorID << '_' << std::setw(4) << properties.deviceID << '_';
+	for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+	{
+		name << std::setw(2) << static_cast<uint32_t>(properties.pipelineCacheUUID[i]);
+	}
+	name << ".cache";
+
+	std::filesystem::path cachePath = std::filesystem::path(directory) / name.str();
+	path = cachePath.string();
+
+	Avec<char> initialData = loadBlob();
+
+	VkPipelineCacheCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = initialData.size();
+	createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+	if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS)
+	{
+		// Drivers may still refuse a blob that passed our checks, start empty then.
+		createInfo.initialDataSize = 0;
+		createInfo.pInitialData = nullptr;
+
+		if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create pipeline cache.");
+		}
+	}
+}
+
+void PipelineCache::destroy()
+{
+	if (cache == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	try {
+		save();
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+	}
+
+	vkDestroyPipelineCache(device, cache, nullptr);
+	cache = VK_NULL_HANDLE;
+}
+
+void PipelineCache::save()
+{
+	size_t dataSize = 0;
+	if (vkGetPipelineCacheData(device, cache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+	{
+		return;
+	}
+
+	Avec<char> data(dataSize);
+	if (vkGetPipelineCacheData(device, cache, &dataSize, data.data()) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to read pipeline cache data.");
+	}
+	data.resize(dataSize);
+
+	FileHeader header{};
+	header.magic = FILE_MAGIC;
+	header.version = FILE_VERSION;
+	header.vendorID = properties.vendorID;
+	header.deviceID = properties.deviceID;
+	header.driverVersion = properties.driverVersion;
+	std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+	header.dataSize = data.size();
+	header.checksum = checksum(data.data(), data.size());
+
+	std::filesystem::path target(path);
+	std::filesystem::path temporary = target;
+	temporary += ".tmp";
+
+	if (target.has_parent_path())
+	{
+		std::filesystem::create_directories(target.parent_path());
+	}
+
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Failed to open pipeline cache file for writing.");
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(data.data(), data.size());
+		file.flush();
+
+		if (!file.good())
+		{
+			throw std::runtime_error("Failed to write pipeline cache file.");
+		}
+	}
+
+	// Readers either see the previous file or the complete new one, never a
+	// partially written blob.
+	std::filesystem::rename(temporary, target);
+}
+
+Avec<char> PipelineCache::loadBlob()
+{
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+	if (!file.is_open())
+	{
+		return {};
+	}
+
+	size_t fileSize = static_cast<size_t>(file.tellg());
+
+	if (fileSize < sizeof(FileHeader))
+	{
+		AMlog("Pipeline cache " << path << " is truncated, starting with an empty cache.");
+		return {};
+	}
+
+	FileHeader header{};
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	if (header.dataSize != fileSize - sizeof(FileHeader))
+	{
+		AMlog("Pipeline cache " << path << " has an unexpected size, starting with an empty cache.");
+		return {};
+	}
+
+	Avec<char> data(static_cast<size_t>(header.dataSize));
+	file.read(data.data(), data.size());
+
+	if (!file.good() || !isBlobCompatible(header, data))
+	{
+		AMlog("Pipeline cache " << path << " is corrupt or was built for another device, starting with an empty cache.");
+		return {};
+	}
+
+	return data;
+}
+
+bool PipelineCache::isBlobCompatible(const FileHeader& header, const Avec<char>& data) const
+{
+	if (header.magic != FILE_MAGIC || header.version != FILE_VERSION)
+	{
+		return false;
+	}
+
+	if (header.vendorID != properties.vendorID ||
+		header.deviceID != properties.deviceID ||
+		header.driverVersion != properties.driverVersion ||
+		std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+	{
+		return false;
+	}
+
+	if (header.checksum != checksum(data.data(), data.size()))
+	{
+		return false;
+	}
+
+	// The driver's own header must agree as well, some drivers crash on
+	// blobs they did not write instead of rejecting them.
+	struct VersionOneHeader
+	{
+		uint32_t headerSize;
+		uint32_t headerVersion;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+	};
+
+	if (data.size() < sizeof(VersionOneHeader))
+	{
+		return false;
+	}
+
+	VersionOneHeader driverHeader;
+	std::memcpy(&driverHeader, data.data(), sizeof(driverHeader));
+
+	return driverHeader.headerSize >= sizeof(VersionOneHeader) &&
+		driverHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		driverHeader.vendorID == properties.vendorID &&
+		driverHeader.deviceID == properties.deviceID &&
+		std::memcmp(driverHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+uint64_t PipelineCache::checksum(const char* data, size_t size)
+{
+	// FNV-1a, enough to catch truncated or bit-flipped files.
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= static_cast<uint8_t>(data[i]);
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
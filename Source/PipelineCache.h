@@ -0,0 +1,55 @@
+#ifndef __PipelineCache_h__
+#define __PipelineCache_h__
+
+#pragma once
+
+#include "Pch.h"
+
+// Owns the VkPipelineCache shared by every pipeline creation and persists it
+// between runs. The blob on disk is keyed by vendor, device and driver UUID;
+// anything that does not match the current device, or fails its checksum,
+// is discarded and an empty cache is used instead.
+class PipelineCache
+{
+public:
+	void create(VkDevice device, VkPhysicalDevice physicalDevice, const Astr& directory);
+
+	// Saves the cache to disk and destroys it.
+	void destroy();
+
+	void save();
+
+	VkPipelineCache get() const
+	{
+		return cache;
+	}
+
+private:
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint64_t dataSize;
+		uint64_t checksum;
+	};
+
+	static constexpr uint32_t FILE_MAGIC { 0x43505341 }; // "ASPC"
+	static constexpr uint32_t FILE_VERSION { 1 };
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkPipelineCache cache = VK_NULL_HANDLE;
+	VkPhysicalDeviceProperties properties{};
+
+	Astr path;
+
+	Avec<char> loadBlob();
+	bool isBlobCompatible(const FileHeader& header, const Avec<char>& data) const;
+
+	static uint64_t checksum(const char* data, size_t size);
+};
+
+#endif
@@ -0,0 +1,406 @@
+#include "Pch.h"
+#include "Profiler.h"
+
+Profiler::Scope::Scope(Profiler* profiler, uint32_t phase)
+	: profiler { profiler }, phase { phase }
+{
+	if (profiler)
+	{
+		start = std::chrono::steady_clock::now();
+	}
+}
+
+Profiler::Scope::~Scope()
+{
+	if (profiler)
+	{
+		profiler->record(phase, start, std::chrono::steady_clock::now());
+	}
+}
+
+void Profiler::create(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamilyIndex, uint32_t framesInFlight)
+{
+	this->device = device;
+	enabled = true;
+	epoch = std::chrono::steady_clock::now();
+	frameStart = epoch;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	timestampPeriodNs = properties.limits.timestampPeriod;
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+	Avec<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+	uint32_t validBits = queueFamilies[queueFamilyIndex].timestampValidBits;
+	gpuTimingSupported = validBits != 0;
+	timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+	if (!gpuTimingSupported)
+	{
+		AMlog("Profiler: queue family " << queueFamilyIndex << " has no timestamp support, GPU timings are disabled.");
+		return;
+	}
+
+	gpuFrames.resize(framesInFlight);
+
+	for (auto& gpuFrame : gpuFrames)
+	{
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = MAX_GPU_SCOPES * 2;
+
+		if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &gpuFrame.queryPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create timestamp query pool.");
+		}
+	}
+}
+
+void Profiler::destroy()
+{
+	for (auto& gpuFrame : gpuFrames)
+	{
+		vkDestroyQueryPool(device, gpuFrame.queryPool, nullptr);
+	}
+
+	gpuFrames.clear();
+	enabled = false;
+}
+
+Profiler::Scope Profiler::scope(const char* phaseName)
+{
+	if (!enabled)
+	{
+		return Scope(nullptr, 0);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = phaseIndices.find(phaseName);
+
+	if (it == phaseIndices.end())
+	{
+		it = phaseIndices.emplace(phaseName, static_cast<uint32_t>(phaseNames.size())).first;
+		phaseNames.push_back(phaseName);
+	}
+
+	return Scope(this, it->second);
+}
+
+void Profiler::beginFrame(uint32_t frameIndex)
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	currentSlot = frameIndex;
+
+	if (gpuTimingSupported && gpuFrames[frameIndex].pending)
+	{
+		collectGpuFrame(gpuFrames[frameIndex]);
+	}
+}
+
+void Profiler::endFrame()
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	auto now = std::chrono::steady_clock::now();
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	FrameRecord record;
+	record.frame = frameNumber;
+	record.cpuFrameMs = std::chrono::duration<double, std::milli>(now - frameStart).count();
+	record.cpuPhaseMs = currentPhaseMs;
+	record.cpuPhaseMs.resize(phaseNames.size(), 0.0);
+
+	history.push_back(std::move(record));
+
+	if (history.size() > historySize)
+	{
+		history.pop_front();
+	}
+
+	currentPhaseMs.assign(phaseNames.size(), 0.0);
+	frameStart = now;
+	frameNumber++;
+}
+
+void Profiler::collectPending()
+{
+	for (auto& gpuFrame : gpuFrames)
+	{
+		if (gpuFrame.pending)
+		{
+			collectGpuFrame(gpuFrame);
+		}
+	}
+}
+
+void Profiler::resetGpuQueries(VkCommandBuffer commandBuffer)
+{
+	if (!enabled || !gpuTimingSupported)
+	{
+		return;
+	}
+
+	GpuFrame& gpuFrame = gpuFrames[currentSlot];
+
+	vkCmdResetQueryPool(commandBuffer, gpuFrame.queryPool, 0, MAX_GPU_SCOPES * 2);
+
+	gpuFrame.scopes.clear();
+	gpuFrame.frame = frameNumber;
+	gpuFrame.submitUs = toMicroseconds(std::chrono::steady_clock::now());
+	gpuFrame.pending = true;
+}
+
+void Profiler::beginGpuScope(VkCommandBuffer commandBuffer, const char* name)
+{
+	if (!enabled || !gpuTimingSupported)
+	{
+		return;
+	}
+
+	GpuFrame& gpuFrame = gpuFrames[currentSlot];
+
+	if (gpuFrame.scopes.size() >= MAX_GPU_SCOPES)
+	{
+		openGpuScope = UINT32_MAX;
+		return;
+	}
+
+	openGpuScope = static_cast<uint32_t>(gpuFrame.scopes.size());
+	gpuFrame.scopes.push_back(gpuScopeIndex(name));
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, gpuFrame.queryPool, openGpuScope * 2);
+}
+
+void Profiler::endGpuScope(VkCommandBuffer commandBuffer)
+{
+	if (!enabled || !gpuTimingSupported || openGpuScope == UINT32_MAX)
+	{
+		return;
+	}
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, gpuFrames[currentSlot].queryPool, openGpuScope * 2 + 1);
+}
+
+void Profiler::exportChromeTrace(const Astr& path) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::ofstream file(path, std::ios::trunc);
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open trace file for writing.");
+	}
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[\n";
+
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+
+	for (const auto& event : events)
+	{
+		const Astr& name = event.gpu ? gpuScopeNames[event.name] : phaseNames[event.name];
+
+		file << ",\n{\"name\":\"" << name << "\",\"cat\":\"" << (event.gpu ? "gpu" : "cpu")
+			<< "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << (event.gpu ? 0 : event.thread + 1)
+			<< ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs << '}';
+	}
+
+	file << "\n]}\n";
+}
+
+void Profiler::exportCsv(const Astr& path) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::ofstream file(path, std::ios::trunc);
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open CSV file for writing.");
+	}
+
+	file << "frame,cpu_frame_ms";
+	for (const auto& name : phaseNames)
+	{
+		file << ",cpu_" << name << "_ms";
+	}
+	for (const auto& name : gpuScopeNames)
+	{
+		file << ",gpu_" << name << "_ms";
+	}
+	file << '\n';
+
+	file << std::fixed << std::setprecision(4);
+
+	for (const auto& record : history)
+	{
+		file << record.frame << ',' << record.cpuFrameMs;
+
+		for (size_t i = 0; i < phaseNames.size(); i++)
+		{
+			file << ',' << (i < record.cpuPhaseMs.size() ? record.cpuPhaseMs[i] : 0.0);
+		}
+
+		for (size_t i = 0; i < gpuScopeNames.size(); i++)
+		{
+			file << ',';
+
+			if (i < record.gpuScopeMs.size())
+			{
+				file << record.gpuScopeMs[i];
+			}
+		}
+
+		file << '\n';
+	}
+}
+
+std::deque<Profiler::FrameRecord> Profiler::getHistory() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return history;
+}
+
+Avec<Astr> Profiler::getPhaseNames() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return phaseNames;
+}
+
+Avec<Astr> Profiler::getGpuScopeNames() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return gpuScopeNames;
+}
+
+double Profiler::toMicroseconds(std::chrono::steady_clock::time_point time) const
+{
+	return std::chrono::duration<double, std::micro>(time - epoch).count();
+}
+
+uint32_t Profiler::gpuScopeIndex(const char* name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = gpuScopeIndices.find(name);
+
+	if (it == gpuScopeIndices.end())
+	{
+		it = gpuScopeIndices.emplace(name, static_cast<uint32_t>(gpuScopeNames.size())).first;
+		gpuScopeNames.push_back(name);
+	}
+
+	return it->second;
+}
+
+void Profiler::record(uint32_t phase, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (currentPhaseMs.size() <= phase)
+	{
+		currentPhaseMs.resize(phase + 1, 0.0);
+	}
+
+	currentPhaseMs[phase] += std::chrono::duration<double, std::milli>(end - start).count();
+
+	auto thread = threadIndices.emplace(std::this_thread::get_id(), static_cast<uint32_t>(threadIndices.size())).first->second;
+
+	TraceEvent event;
+	event.name = phase;
+	event.thread = thread;
+	event.gpu = false;
+	event.startUs = toMicroseconds(start);
+	event.durationUs = std::chrono::duration<double, std::micro>(end - start).count();
+
+	pushEvent(event);
+}
+
+void Profiler::pushEvent(const TraceEvent& event)
+{
+	events.push_back(event);
+
+	if (events.size() > MAX_TRACE_EVENTS)
+	{
+		events.pop_front();
+	}
+}
+
+void Profiler::collectGpuFrame(GpuFrame& gpuFrame)
+{
+	gpuFrame.pending = false;
+
+	uint32_t queryCount = static_cast<uint32_t>(gpuFrame.scopes.size()) * 2;
+
+	if (queryCount == 0)
+	{
+		return;
+	}
+
+	Avec<uint64_t> timestamps(queryCount);
+
+	// The frame's fence has been waited on, so results are ready and this
+	// never blocks.
+	VkResult result = vkGetQueryPoolResults(
+		device, gpuFrame.queryPool, 0, queryCount,
+		timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT
+	);
+
+	if (result != VK_SUCCESS)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	FrameRecord* record = nullptr;
+
+	if (!history.empty() && gpuFrame.frame >= history.front().frame && gpuFrame.frame - history.front().frame < history.size())
+	{
+		record = &history[static_cast<size_t>(gpuFrame.frame - history.front().frame)];
+		record->gpuScopeMs.resize(gpuScopeNames.size(), 0.0);
+	}
+
+	uint64_t base = timestamps[0] & timestampMask;
+
+	for (size_t i = 0; i < gpuFrame.scopes.size(); i++)
+	{
+		uint64_t begin = timestamps[i * 2] & timestampMask;
+		uint64_t end = timestamps[i * 2 + 1] & timestampMask;
+
+		double durationUs = static_cast<double>((end - begin) & timestampMask) * timestampPeriodNs / 1000.0;
+		double offsetUs = static_cast<double>((begin - base) & timestampMask) * timestampPeriodNs / 1000.0;
+
+		if (record)
+		{
+			record->gpuScopeMs[gpuFrame.scopes[i]] += durationUs / 1000.0;
+		}
+
+		// Without calibrated timestamps the GPU clock cannot be related to
+		// the CPU clock, so GPU events are placed relative to the submission.
+		TraceEvent event;
+		event.name = gpuFrame.scopes[i];
+		event.thread = 0;
+		event.gpu = true;
+		event.startUs = gpuFrame.submitUs + offsetUs;
+		event.durationUs = durationUs;
+
+		pushEvent(event);
+	}
+}
@@ -0,0 +1,142 @@
+#ifndef __Profiler_h__
+#define __Profiler_h__
+
+#pragma once
+
+#include "Pch.h"
+
+// CPU phase timers and GPU timestamp queries per frame. Completed frames are
+// kept in a rolling history that can be written out as CSV, individual
+// events as a Chrome trace (chrome://tracing, Perfetto).
+//
+// A profiler that was never created is disabled and every call is a no-op,
+// so instrumentation can stay in place unconditionally.
+class Profiler
+{
+public:
+	static constexpr size_t		FRAME_HISTORY { 1024 };
+	static constexpr size_t		MAX_TRACE_EVENTS { 200000 };
+	static constexpr uint32_t	MAX_GPU_SCOPES { 16 };
+
+	class Scope
+	{
+	public:
+		Scope(Profiler* profiler, uint32_t phase);
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		Profiler* profiler;
+		uint32_t phase;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	struct FrameRecord
+	{
+		uint64_t frame { 0 };
+		double cpuFrameMs { 0.0 };
+
+		// Indexed like getPhaseNames() and getGpuScopeNames(). GPU values are
+		// filled in once the frame's queries have been read back, which is
+		// MAX_FRAMES_IN_FLIGHT frames after the frame itself.
+		Avec<double> cpuPhaseMs;
+		Avec<double> gpuScopeMs;
+	};
+
+	void create(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamilyIndex, uint32_t framesInFlight);
+	void destroy();
+
+	bool isEnabled() const
+	{
+		return enabled;
+	}
+
+	// Number of frames kept for CSV export and getHistory().
+	void setHistorySize(size_t frames)
+	{
+		historySize = std::max<size_t>(frames, 1);
+	}
+
+	// Times the enclosing block as the named CPU phase of the current frame.
+	// Safe to use from any thread.
+	Scope scope(const char* phaseName);
+
+	// Starts a frame on the given frame slot. Must be called once the frame
+	// that last used the slot has finished, it reads back its GPU queries.
+	void beginFrame(uint32_t frameIndex);
+	void endFrame();
+
+	// Reads back the GPU queries of every frame still in flight. Only valid
+	// once the device is idle.
+	void collectPending();
+
+	// Must be recorded outside of a render pass, before any GPU scope.
+	void resetGpuQueries(VkCommandBuffer commandBuffer);
+	void beginGpuScope(VkCommandBuffer commandBuffer, const char* name);
+	void endGpuScope(VkCommandBuffer commandBuffer);
+
+	void exportChromeTrace(const Astr& path) const;
+	void exportCsv(const Astr& path) const;
+
+	std::deque<FrameRecord> getHistory() const;
+	Avec<Astr> getPhaseNames() const;
+	Avec<Astr> getGpuScopeNames() const;
+
+private:
+	struct TraceEvent
+	{
+		uint32_t name;
+		uint32_t thread;
+		bool gpu;
+		double startUs;
+		double durationUs;
+	};
+
+	struct GpuFrame
+	{
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+		uint64_t frame { 0 };
+		double submitUs { 0.0 };
+		bool pending { false };
+
+		// Scope name of every begin/end query pair written this frame.
+		Avec<uint32_t> scopes;
+	};
+
+	bool enabled { false };
+	size_t historySize { FRAME_HISTORY };
+
+	VkDevice device = VK_NULL_HANDLE;
+	double timestampPeriodNs { 1.0 };
+	uint64_t timestampMask { ~0ull };
+	bool gpuTimingSupported { false };
+
+	std::chrono::steady_clock::time_point epoch;
+	std::chrono::steady_clock::time_point frameStart;
+	uint64_t frameNumber { 0 };
+	uint32_t currentSlot { 0 };
+
+	Avec<GpuFrame> gpuFrames;
+	uint32_t openGpuScope { 0 };
+
+	mutable std::mutex mutex;
+	Avec<Astr> phaseNames;
+	std::unordered_map<Astr, uint32_t> phaseIndices;
+	Avec<Astr> gpuScopeNames;
+	std::unordered_map<Astr, uint32_t> gpuScopeIndices;
+	std::unordered_map<std::thread::id, uint32_t> threadIndices;
+
+	Avec<double> currentPhaseMs;
+	std::deque<FrameRecord> history;
+	std::deque<TraceEvent> events;
+
+	double toMicroseconds(std::chrono::steady_clock::time_point time) const;
+	uint32_t gpuScopeIndex(const char* name);
+	void record(uint32_t phase, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+	void pushEvent(const TraceEvent& event);
+	void collectGpuFrame(GpuFrame& gpuFrame);
+};
+
+#endif
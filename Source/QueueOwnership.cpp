@@ -0,0 +1,67 @@
+#include "Pch.h"
+#include "QueueOwnership.h"
+
+void BufferOwnershipTransfer::add(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+	VkBufferMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = srcFamily;
+	barrier.dstQueueFamilyIndex = dstFamily;
+	barrier.buffer = buffer;
+	barrier.offset = offset;
+	barrier.size = size;
+
+	barriers.push_back(barrier);
+}
+
+void BufferOwnershipTransfer::recordRelease(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess) const
+{
+	if (!isFamilyChange() || barriers.empty())
+	{
+		return;
+	}
+
+	// The destination half of a release is ignored, the acquire provides it.
+	Avec<VkBufferMemoryBarrier> release = barriers;
+
+	for (auto& barrier : release)
+	{
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstAccessMask = 0;
+	}
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		srcStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0,
+		0, nullptr,
+		static_cast<uint32_t>(release.size()), release.data(),
+		0, nullptr
+	);
+}
+
+void BufferOwnershipTransfer::recordAcquire(VkCommandBuffer commandBuffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) const
+{
+	if (!isFamilyChange() || barriers.empty())
+	{
+		return;
+	}
+
+	// The source half of an acquire is ignored, the release provided it.
+	Avec<VkBufferMemoryBarrier> acquire = barriers;
+
+	for (auto& barrier : acquire)
+	{
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = dstAccess;
+	}
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage,
+		0,
+		0, nullptr,
+		static_cast<uint32_t>(acquire.size()), acquire.data(),
+		0, nullptr
+	);
+}
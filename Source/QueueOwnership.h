@@ -0,0 +1,56 @@
+#ifndef __QueueOwnership_h__
+#define __QueueOwnership_h__
+
+#pragma once
+
+#include "Pch.h"
+
+// Hands buffer ranges with exclusive sharing from one queue family to
+// another. Contents written on the source family are only defined on the
+// destination family once recordRelease() has run on a source queue and
+// recordAcquire() on a destination queue, the acquiring submission waiting
+// on a semaphore signalled after the release.
+//
+// Between queues of the same family no ownership changes hands, both calls
+// then record nothing.
+class BufferOwnershipTransfer
+{
+public:
+	BufferOwnershipTransfer() = default;
+
+	BufferOwnershipTransfer(uint32_t srcFamily, uint32_t dstFamily)
+		: srcFamily { srcFamily }, dstFamily { dstFamily }
+	{
+	}
+
+	void add(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+
+	bool isFamilyChange() const
+	{
+		return srcFamily != dstFamily;
+	}
+
+	bool empty() const
+	{
+		return barriers.empty();
+	}
+
+	uint32_t getDstFamily() const
+	{
+		return dstFamily;
+	}
+
+	// Finishes srcAccess at srcStage and gives the ranges up.
+	void recordRelease(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess) const;
+
+	// Takes the ranges over and makes them available to dstAccess at dstStage.
+	void recordAcquire(VkCommandBuffer commandBuffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) const;
+
+private:
+	uint32_t srcFamily { VK_QUEUE_FAMILY_IGNORED };
+	uint32_t dstFamily { VK_QUEUE_FAMILY_IGNORED };
+
+	Avec<VkBufferMemoryBarrier> barriers;
+};
+
+#endif
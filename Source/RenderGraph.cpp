@@ -0,0 +1,1424 @@
+#include "Pch.h"
+#include "RenderGraph.h"
+
+void RenderGraph::PassBuilder::colorAttachment(ImageHandle image, AttachmentLoad load, VkClearColorValue clearValue)
+{
+	Attachment attachment{};
+	attachment.image = image.index;
+	attachment.load = load;
+	attachment.clearValue.color = clearValue;
+	attachment.depth = false;
+	attachment.resolveSource = UINT32_MAX;
+
+	graph.passes[pass].attachments.push_back(attachment);
+	graph.addAccess(pass, image.index, true, ResourceUsage::ColorAttachment, load == AttachmentLoad::Load, true);
+}
+
+void RenderGraph::PassBuilder::depthAttachment(ImageHandle image, AttachmentLoad load, VkClearDepthStencilValue clearValue)
+{
+	Attachment attachment{};
+	attachment.image = image.index;
+	attachment.load = load;
+	attachment.clearValue.depthStencil = clearValue;
+	attachment.depth = true;
+	attachment.resolveSource = UINT32_MAX;
+
+	graph.passes[pass].attachments.push_back(attachment);
+	graph.addAccess(pass, image.index, true, ResourceUsage::DepthStencilAttachment, load == AttachmentLoad::Load, true);
+}
+
+void RenderGraph::PassBuilder::resolveAttachment(ImageHandle image, ImageHandle source)
+{
+	const Avec<Attachment>& attachments = graph.passes[pass].attachments;
+
+	bool hasSource = std::any_of(attachments.begin(), attachments.end(), [&](const Attachment& attachment)
+	{
+		return attachment.image == source.index && !attachment.depth && attachment.resolveSource == UINT32_MAX;
+	});
+
+	if (!hasSource)
+	{
+		throw std::runtime_error("Render graph pass " + graph.passes[pass].name + " resolves an image that is not one of its color attachments.");
+	}
+
+	// Every pixel is overwritten by the resolve, nothing to load.
+	Attachment attachment{};
+	attachment.image = image.index;
+	attachment.load = AttachmentLoad::DontCare;
+	attachment.depth = false;
+	attachment.resolveSource = source.index;
+
+	graph.passes[pass].attachments.push_back(attachment);
+	graph.addAccess(pass, image.index, true, ResourceUsage::ColorAttachment, false, true);
+}
+
+void RenderGraph::PassBuilder::read(ImageHandle image, ResourceUsage usage)
+{
+	graph.addAccess(pass, image.index, true, usage, true, false);
+}
+
+void RenderGraph::PassBuilder::write(ImageHandle image, ResourceUsage usage)
+{
+	graph.addAccess(pass, image.index, true, usage, false, true);
+}
+
+void RenderGraph::PassBuilder::read(BufferHandle buffer, ResourceUsage usage)
+{
+	graph.addAccess(pass, buffer.index, false, usage, true, false);
+}
+
+void RenderGraph::PassBuilder::write(BufferHandle buffer, ResourceUsage usage)
+{
+	graph.addAccess(pass, buffer.index, false, usage, false, true);
+}
+
+void RenderGraph::PassBuilder::modify(ImageHandle image, ResourceUsage usage)
+{
+	graph.addAccess(pass, image.index, true, usage, true, true);
+}
+
+void RenderGraph::PassBuilder::modify(BufferHandle buffer, ResourceUsage usage)
+{
+	graph.addAccess(pass, buffer.index, false, usage, true, true);
+}
+
+void RenderGraph::PassBuilder::useSecondaryCommandBuffers()
+{
+	graph.passes[pass].secondaryCommandBuffers = true;
+}
+
+void RenderGraph::PassBuilder::sideEffect()
+{
+	graph.passes[pass].sideEffect = true;
+}
+
+RenderGraph::ImageHandle RenderGraph::createImage(const Astr& name, const RenderGraphImageDesc& desc)
+{
+	Image image;
+	image.name = name;
+	image.desc = desc;
+
+	images.push_back(image);
+
+	return { static_cast<uint32_t>(images.size() - 1) };
+}
+
+RenderGraph::ImageHandle RenderGraph::importImage(const Astr& name, const RenderGraphImageDesc& desc, const ExternalAccess& initial, const ExternalAccess& final)
+{
+	Image image;
+	image.name = name;
+	image.desc = desc;
+	image.imported = true;
+	image.initial = initial;
+	image.final = final;
+
+	images.push_back(image);
+
+	return { static_cast<uint32_t>(images.size() - 1) };
+}
+
+RenderGraph::BufferHandle RenderGraph::importBuffer(const Astr& name, const ExternalAccess& initial, const ExternalAccess& final)
+{
+	Buffer buffer;
+	buffer.name = name;
+	buffer.initial = initial;
+	buffer.final = final;
+
+	buffers.push_back(buffer);
+
+	return { static_cast<uint32_t>(buffers.size() - 1) };
+}
+
+RenderGraph::PassHandle RenderGraph::addPass(const Astr& name, const SetupCallback& setup, const ExecuteCallback& execute)
+{
+	Pass pass;
+	pass.name = name;
+	pass.execute = execute;
+
+	passes.push_back(std::move(pass));
+
+	uint32_t index = static_cast<uint32_t>(passes.size() - 1);
+
+	PassBuilder builder(*this, index);
+	setup(builder);
+
+	return { index };
+}
+
+void RenderGraph::addAccess(uint32_t pass, uint32_t resource, bool isImage, ResourceUsage usage, bool read, bool write)
+{
+	if (resource >= (isImage ? images.size() : buffers.size()))
+	{
+		throw std::runtime_error("Render graph pass " + passes[pass].name + " uses an invalid resource.");
+	}
+
+	passes[pass].accesses.push_back({ resource, isImage, usage, read, write });
+}
+
+void RenderGraph::setDynamicRendering(bool enabled)
+{
+#ifndef VK_KHR_dynamic_rendering
+	if (enabled)
+	{
+		throw std::runtime_error("Built with Vulkan headers without VK_KHR_dynamic_rendering.");
+	}
+#endif
+
+	dynamicRendering = enabled;
+}
+
+void RenderGraph::compile(VkDevice device, DeviceAllocator& allocator)
+{
+	this->device = device;
+	this->allocator = &allocator;
+
+	stats = {};
+
+	cullPasses();
+	createTransientImages();
+
+	if (dynamicRendering)
+	{
+		prepareDynamicRendering(buildBarriers());
+	}
+	else
+	{
+		createRenderPasses(buildBarriers());
+	}
+
+	for (const auto& pass : passes)
+	{
+		if (pass.culled)
+		{
+			stats.culledPassCount++;
+			continue;
+		}
+
+		stats.passCount++;
+		stats.barrierCount += static_cast<uint32_t>(pass.barriers.barriers.size() + pass.leaveBarriers.barriers.size());
+	}
+
+	stats.barrierCount += static_cast<uint32_t>(finalBarriers.barriers.size());
+}
+
+void RenderGraph::reset()
+{
+	clearFramebuffers();
+
+	for (auto& pass : passes)
+	{
+		if (pass.renderPass != VK_NULL_HANDLE)
+		{
+			vkDestroyRenderPass(device, pass.renderPass, nullptr);
+		}
+	}
+
+	for (auto& image : images)
+	{
+		if (image.imported)
+		{
+			continue;
+		}
+
+		if (image.view != VK_NULL_HANDLE)
+		{
+			vkDestroyImageView(device, image.view, nullptr);
+		}
+
+		if (image.image != VK_NULL_HANDLE)
+		{
+			vkDestroyImage(device, image.image, nullptr);
+		}
+	}
+
+	for (auto& slot : memorySlots)
+	{
+		allocator->free(slot.allocation);
+	}
+
+	passes.clear();
+	images.clear();
+	buffers.clear();
+	memorySlots.clear();
+	finalBarriers = {};
+	stats = {};
+}
+
+void RenderGraph::bindImage(ImageHandle image, VkImage handle, VkImageView view)
+{
+	if (!images[image.index].imported)
+	{
+		throw std::runtime_error("Only imported images can be bound.");
+	}
+
+	images[image.index].image = handle;
+	images[image.index].view = view;
+}
+
+void RenderGraph::bindBuffer(BufferHandle buffer, VkBuffer handle)
+{
+	buffers[buffer.index].buffer = handle;
+}
+
+void RenderGraph::execute(VkCommandBuffer commandBuffer)
+{
+	for (auto& pass : passes)
+	{
+		if (pass.culled)
+		{
+			continue;
+		}
+
+		recordBarriers(commandBuffer, pass.barriers);
+
+		if (passBegin)
+		{
+			passBegin(commandBuffer, pass.name.c_str());
+		}
+
+		PassContext context{};
+		context.commandBuffer = commandBuffer;
+
+		if (pass.renderPass != VK_NULL_HANDLE)
+		{
+			context.renderPass = pass.renderPass;
+			context.framebuffer = getFramebuffer(pass);
+			context.extent = pass.extent;
+
+			VkRenderPassBeginInfo renderPassInfo{};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = pass.renderPass;
+			renderPassInfo.framebuffer = context.framebuffer;
+			renderPassInfo.renderArea.offset = { 0, 0 };
+			renderPassInfo.renderArea.extent = pass.extent;
+			renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+			renderPassInfo.pClearValues = pass.clearValues.data();
+
+			VkSubpassContents contents = pass.secondaryCommandBuffers ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+			pass.execute(context);
+			vkCmdEndRenderPass(commandBuffer);
+		}
+#ifdef VK_KHR_dynamic_rendering
+		else if (dynamicRendering && !pass.attachments.empty())
+		{
+			context.extent = pass.extent;
+
+			beginRendering(commandBuffer, pass);
+			pass.execute(context);
+			cmdEndRendering(commandBuffer);
+
+			recordBarriers(commandBuffer, pass.leaveBarriers);
+		}
+#endif
+		else
+		{
+			pass.execute(context);
+		}
+
+		if (passEnd)
+		{
+			passEnd(commandBuffer);
+		}
+	}
+
+	recordBarriers(commandBuffer, finalBarriers);
+}
+
+void RenderGraph::clearFramebuffers()
+{
+	for (auto& pass : passes)
+	{
+		for (auto& [views, framebuffer] : pass.framebuffers)
+		{
+			vkDestroyFramebuffer(device, framebuffer, nullptr);
+		}
+
+		pass.framebuffers.clear();
+	}
+}
+
+void RenderGraph::setPassHooks(const PassBeginHook& begin, const PassEndHook& end)
+{
+	passBegin = begin;
+	passEnd = end;
+}
+
+VkRenderPass RenderGraph::getRenderPass(PassHandle pass) const
+{
+	return passes[pass.index].renderPass;
+}
+
+RenderGraph::RenderingFormats RenderGraph::getRenderingFormats(PassHandle pass) const
+{
+	RenderingFormats formats;
+
+	for (const auto& attachment : passes[pass.index].attachments)
+	{
+		if (attachment.resolveSource != UINT32_MAX)
+		{
+			continue;
+		}
+
+		const RenderGraphImageDesc& desc = images[attachment.image].desc;
+		formats.samples = desc.samples;
+
+		if (!attachment.depth)
+		{
+			formats.colorFormats.push_back(desc.format);
+			continue;
+		}
+
+		VkImageAspectFlags aspectMask = getAspectMask(desc.format);
+
+		if (aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT)
+		{
+			formats.depthFormat = desc.format;
+		}
+
+		if (aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT)
+		{
+			formats.stencilFormat = desc.format;
+		}
+	}
+
+	return formats;
+}
+
+bool RenderGraph::isCulled(PassHandle pass) const
+{
+	return passes[pass.index].culled;
+}
+
+VkImage RenderGraph::getImage(ImageHandle image) const
+{
+	return images[image.index].image;
+}
+
+VkImageView RenderGraph::getImageView(ImageHandle image) const
+{
+	return images[image.index].view;
+}
+
+VkBuffer RenderGraph::getBuffer(BufferHandle buffer) const
+{
+	return buffers[buffer.index].buffer;
+}
+
+RenderGraph::UsageInfo RenderGraph::getUsageInfo(ResourceUsage usage)
+{
+	switch (usage)
+	{
+	case ResourceUsage::ColorAttachment:
+		return {
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+		};
+	case ResourceUsage::DepthStencilAttachment:
+		return {
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+		};
+	case ResourceUsage::DepthStencilRead:
+		return {
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+		};
+	case ResourceUsage::SampledFragment:
+		return {
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_IMAGE_USAGE_SAMPLED_BIT
+		};
+	case ResourceUsage::SampledCompute:
+		return {
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_IMAGE_USAGE_SAMPLED_BIT
+		};
+	case ResourceUsage::StorageRead:
+		return {
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_IMAGE_USAGE_STORAGE_BIT
+		};
+	case ResourceUsage::StorageWrite:
+		return {
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_IMAGE_USAGE_STORAGE_BIT
+		};
+	case ResourceUsage::TransferSrc:
+		return {
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+		};
+	case ResourceUsage::TransferDst:
+		return {
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT
+		};
+	case ResourceUsage::IndirectRead:
+		return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0 };
+	case ResourceUsage::VertexRead:
+		return { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0 };
+	case ResourceUsage::IndexRead:
+		return { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0 };
+	case ResourceUsage::UniformRead:
+		return {
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_UNIFORM_READ_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			0
+		};
+	}
+
+	throw std::runtime_error("Unknown resource usage.");
+}
+
+bool RenderGraph::isDepthFormat(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+VkImageAspectFlags RenderGraph::getAspectMask(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	default:
+		return isDepthFormat(format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
+
+void RenderGraph::cullPasses()
+{
+	// Walks the passes backwards tracking which resources still have a
+	// reader. Imported resources are read outside the graph. A pass is kept
+	// when it writes something with a reader, and a write that does not read
+	// (clears, overwrites) ends the need for earlier writers.
+	Avec<bool> imageNeeded(images.size());
+	Avec<bool> bufferNeeded(buffers.size(), true);
+
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		imageNeeded[i] = images[i].imported;
+	}
+
+	for (size_t p = passes.size(); p-- > 0;)
+	{
+		Pass& pass = passes[p];
+
+		bool alive = pass.sideEffect;
+
+		for (const auto& access : pass.accesses)
+		{
+			if (access.write && (access.isImage ? imageNeeded[access.resource] : bufferNeeded[access.resource]))
+			{
+				alive = true;
+			}
+		}
+
+		pass.culled = !alive;
+
+		if (!alive)
+		{
+			continue;
+		}
+
+		for (const auto& access : pass.accesses)
+		{
+			if (access.write)
+			{
+				(access.isImage ? imageNeeded[access.resource] : bufferNeeded[access.resource]) = false;
+			}
+		}
+
+		for (const auto& access : pass.accesses)
+		{
+			if (access.read)
+			{
+				(access.isImage ? imageNeeded[access.resource] : bufferNeeded[access.resource]) = true;
+			}
+		}
+	}
+}
+
+void RenderGraph::createTransientImages()
+{
+	for (uint32_t p = 0; p < passes.size(); p++)
+	{
+		if (passes[p].culled)
+		{
+			continue;
+		}
+
+		for (const auto& access : passes[p].accesses)
+		{
+			if (!access.isImage || images[access.resource].imported)
+			{
+				continue;
+			}
+
+			Image& image = images[access.resource];
+			image.usage |= getUsageInfo(access.usage).imageUsage;
+			image.firstPass = std::min(image.firstPass, p);
+			image.lastPass = std::max(image.lastPass, p);
+		}
+	}
+
+	// Images in the order they come to life, each placed in the first slot
+	// whose images are all dead by then.
+	Avec<uint32_t> order;
+
+	constexpr VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+	for (uint32_t i = 0; i < images.size(); i++)
+	{
+		Image& image = images[i];
+
+		if (image.imported || image.firstPass == UINT32_MAX)
+		{
+			continue;
+		}
+
+		// Contents that live within one render pass only exist in tile
+		// memory, their load and store ops are CLEAR or DONT_CARE.
+		if ((image.usage & ~attachmentUsage) == 0 && image.firstPass == image.lastPass)
+		{
+			image.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+			image.lazy = true;
+		}
+
+		order.push_back(i);
+	}
+
+	std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return images[a].firstPass < images[b].firstPass; });
+
+	for (uint32_t index : order)
+	{
+		Image& image = images[index];
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = image.desc.format;
+		imageInfo.extent = { image.desc.extent.width, image.desc.extent.height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = image.desc.samples;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = image.usage;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (vkCreateImage(device, &imageInfo, nullptr, &image.image) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create render graph image " + image.name);
+		}
+
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(device, image.image, &requirements);
+
+		stats.transientImageCount++;
+
+		for (uint32_t s = 0; s < memorySlots.size(); s++)
+		{
+			MemorySlot& slot = memorySlots[s];
+
+			if (slot.lastPass < image.firstPass && slot.lazy == image.lazy && (slot.requirements.memoryTypeBits & requirements.memoryTypeBits) != 0)
+			{
+				stats.aliasedMemoryBytes += std::min(slot.requirements.size, requirements.size);
+
+				slot.requirements.size = std::max(slot.requirements.size, requirements.size);
+				slot.requirements.alignment = std::max(slot.requirements.alignment, requirements.alignment);
+				slot.requirements.memoryTypeBits &= requirements.memoryTypeBits;
+				slot.lastPass = image.lastPass;
+				image.memorySlot = s;
+				break;
+			}
+		}
+
+		if (image.memorySlot == UINT32_MAX)
+		{
+			memorySlots.push_back({ requirements, image.lastPass, image.lazy, {} });
+			image.memorySlot = static_cast<uint32_t>(memorySlots.size() - 1);
+		}
+	}
+
+	AllocationCreateInfo allocInfo{};
+	allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	allocInfo.kind = ResourceKind::Optimal;
+
+	for (auto& slot : memorySlots)
+	{
+		AllocationCreateInfo slotInfo = allocInfo;
+
+		if (slot.lazy)
+		{
+			// Memory is only committed when the tiles spill, which a block
+			// shared with other resources would defeat.
+			uint32_t memoryTypeIndex = allocator->findMemoryType(slot.requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+
+			if (allocator->getMemoryProperties().memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+			{
+				slotInfo.preferredFlags = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+				slotInfo.dedicated = true;
+				stats.lazyMemoryBytes += slot.requirements.size;
+			}
+		}
+
+		slot.allocation = allocator->allocate(slot.requirements, slotInfo);
+		stats.transientMemoryBytes += slot.requirements.size;
+	}
+
+	for (uint32_t index : order)
+	{
+		Image& image = images[index];
+		const Allocation& allocation = memorySlots[image.memorySlot].allocation;
+
+		if (vkBindImageMemory(device, image.image, allocation.memory, allocation.offset) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to bind render graph image memory.");
+		}
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = image.desc.format;
+		viewInfo.subresourceRange.aspectMask = getAspectMask(image.desc.format);
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(device, &viewInfo, nullptr, &image.view) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create render graph image view.");
+		}
+	}
+}
+
+Avec<RenderGraph::RenderPassDependencies> RenderGraph::buildBarriers()
+{
+	// The first use of a transient image in a frame has to wait for the last
+	// use of its memory, which is in the previous frame. Simulating the frame
+	// once gives the state its memory slots are left in.
+	Avec<ResourceState> slotStates(memorySlots.size());
+	simulate(slotStates, nullptr);
+
+	Avec<RenderPassDependencies> dependencies(passes.size());
+	simulate(slotStates, &dependencies);
+
+	return dependencies;
+}
+
+void RenderGraph::simulate(Avec<ResourceState>& slotStates, Avec<RenderPassDependencies>* dependencies)
+{
+	Avec<ResourceState> imageStates(images.size());
+	Avec<ResourceState> bufferStates(buffers.size());
+	Avec<bool> touched(images.size(), false);
+
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		if (images[i].imported)
+		{
+			imageStates[i].layout = images[i].initial.layout;
+			imageStates[i].writeStageMask = images[i].initial.stageMask;
+			imageStates[i].writeAccessMask = images[i].initial.accessMask;
+		}
+	}
+
+	for (size_t i = 0; i < buffers.size(); i++)
+	{
+		bufferStates[i].writeStageMask = buffers[i].initial.stageMask;
+		bufferStates[i].writeAccessMask = buffers[i].initial.accessMask;
+	}
+
+	Avec<ResourceState> slots = slotStates;
+
+	// Pass and attachment that last touched each image, while the touch was
+	// an attachment, so a final transition can be folded into its render pass.
+	Avec<std::pair<uint32_t, uint32_t>> lastAttachment(images.size(), { UINT32_MAX, 0 });
+
+	for (uint32_t p = 0; p < passes.size(); p++)
+	{
+		Pass& pass = passes[p];
+		pass.barriers = {};
+
+		if (pass.culled)
+		{
+			continue;
+		}
+
+		RenderPassDependencies* passDependencies = dependencies ? &(*dependencies)[p] : nullptr;
+
+		if (passDependencies)
+		{
+			passDependencies->transitions.resize(pass.attachments.size());
+		}
+
+		for (const auto& access : pass.accesses)
+		{
+			ResourceState& state = access.isImage ? imageStates[access.resource] : bufferStates[access.resource];
+			UsageInfo usage = getUsageInfo(access.usage);
+
+			if (access.isImage && !images[access.resource].imported && !touched[access.resource])
+			{
+				const ResourceState& slot = slots[images[access.resource].memorySlot];
+
+				state = {};
+				state.writeStageMask = slot.writeStageMask | slot.readStageMask;
+				state.writeAccessMask = slot.writeAccessMask;
+			}
+
+			if (access.isImage)
+			{
+				touched[access.resource] = true;
+			}
+
+			// Attachments are transitioned by their render pass.
+			uint32_t attachmentIndex = UINT32_MAX;
+
+			if (access.usage == ResourceUsage::ColorAttachment || access.usage == ResourceUsage::DepthStencilAttachment)
+			{
+				for (uint32_t a = 0; a < pass.attachments.size(); a++)
+				{
+					if (pass.attachments[a].image == access.resource)
+					{
+						attachmentIndex = a;
+					}
+				}
+			}
+
+			if (attachmentIndex != UINT32_MAX)
+			{
+				BarrierBatch batch;
+				bool barrierNeeded = false;
+				VkImageLayout priorLayout = state.layout;
+
+				transition(state, access, usage, batch, &barrierNeeded);
+
+				if (passDependencies)
+				{
+					passDependencies->transitions[attachmentIndex] = { priorLayout, usage.layout, priorLayout != VK_IMAGE_LAYOUT_UNDEFINED };
+
+					if (barrierNeeded)
+					{
+						passDependencies->enter.srcStageMask |= batch.srcStageMask;
+						passDependencies->enter.srcAccessMask |= batch.barriers[0].srcAccessMask;
+						passDependencies->enter.dstStageMask |= usage.stageMask;
+						passDependencies->enter.dstAccessMask |= usage.accessMask;
+					}
+				}
+
+				lastAttachment[access.resource] = { p, attachmentIndex };
+			}
+			else
+			{
+				transition(state, access, usage, pass.barriers, nullptr);
+
+				if (access.isImage)
+				{
+					lastAttachment[access.resource] = { UINT32_MAX, 0 };
+				}
+			}
+
+			if (access.isImage && !images[access.resource].imported)
+			{
+				slots[images[access.resource].memorySlot] = state;
+			}
+		}
+	}
+
+	finalBarriers = {};
+
+	for (uint32_t i = 0; i < images.size(); i++)
+	{
+		const Image& image = images[i];
+		ResourceState& state = imageStates[i];
+
+		if (!image.imported || (image.final.layout == VK_IMAGE_LAYOUT_UNDEFINED && image.final.accessMask == 0))
+		{
+			continue;
+		}
+
+		VkImageLayout finalLayout = image.final.layout == VK_IMAGE_LAYOUT_UNDEFINED ? state.layout : image.final.layout;
+
+		if (finalLayout == state.layout && (state.writeAccessMask == 0 || image.final.accessMask == 0))
+		{
+			continue;
+		}
+
+		auto [attachmentPass, attachmentIndex] = lastAttachment[i];
+
+		if (attachmentPass != UINT32_MAX)
+		{
+			if (dependencies)
+			{
+				RenderPassDependencies& passDependencies = (*dependencies)[attachmentPass];
+				passDependencies.transitions[attachmentIndex].finalLayout = finalLayout;
+				passDependencies.leave.srcStageMask |= state.writeStageMask | state.readStageMask;
+				passDependencies.leave.srcAccessMask |= state.writeAccessMask;
+				passDependencies.leave.dstStageMask |= image.final.stageMask;
+				passDependencies.leave.dstAccessMask |= image.final.accessMask;
+			}
+
+			continue;
+		}
+
+		VkPipelineStageFlags srcStageMask = state.writeStageMask | state.readStageMask;
+
+		finalBarriers.srcStageMask |= srcStageMask != 0 ? srcStageMask : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+		finalBarriers.dstStageMask |= image.final.stageMask;
+		finalBarriers.barriers.push_back({ i, true, state.writeAccessMask, image.final.accessMask, state.layout, finalLayout });
+	}
+
+	for (uint32_t i = 0; i < buffers.size(); i++)
+	{
+		const Buffer& buffer = buffers[i];
+		const ResourceState& state = bufferStates[i];
+
+		if (state.writeAccessMask == 0 || buffer.final.accessMask == 0)
+		{
+			continue;
+		}
+
+		finalBarriers.srcStageMask |= state.writeStageMask;
+		finalBarriers.dstStageMask |= buffer.final.stageMask;
+		finalBarriers.barriers.push_back({ i, false, state.writeAccessMask, buffer.final.accessMask, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED });
+	}
+
+	slotStates = slots;
+}
+
+void RenderGraph::transition(ResourceState& state, const Access& access, const UsageInfo& usage, BarrierBatch& batch, bool* barrierNeeded)
+{
+	bool layoutChange = access.isImage && state.layout != usage.layout;
+	bool needed = false;
+
+	Barrier barrier{};
+	barrier.resource = access.resource;
+	barrier.isImage = access.isImage;
+	barrier.srcAccessMask = state.writeAccessMask;
+	barrier.dstAccessMask = usage.accessMask;
+	barrier.oldLayout = state.layout;
+	barrier.newLayout = access.isImage ? usage.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+	VkPipelineStageFlags srcStageMask;
+
+	if (layoutChange || access.write)
+	{
+		// Writes and layout transitions wait for every earlier access.
+		srcStageMask = state.writeStageMask | state.readStageMask;
+		needed = layoutChange || srcStageMask != 0;
+
+		if (access.write)
+		{
+			state = { barrier.newLayout, usage.stageMask, usage.accessMask, 0, 0 };
+		}
+		else
+		{
+			// The transition is the last write, made visible to this read.
+			state = { barrier.newLayout, usage.stageMask, 0, usage.stageMask, usage.accessMask };
+		}
+	}
+	else
+	{
+		// Reads only wait for the last write, once per stage and access.
+		srcStageMask = state.writeStageMask;
+		needed = srcStageMask != 0 && ((usage.stageMask & ~state.readStageMask) != 0 || (usage.accessMask & ~state.readAccessMask) != 0);
+
+		state.readStageMask |= usage.stageMask;
+		state.readAccessMask |= usage.accessMask;
+	}
+
+	if (needed)
+	{
+		batch.srcStageMask |= srcStageMask != 0 ? srcStageMask : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+		batch.dstStageMask |= usage.stageMask;
+		batch.barriers.push_back(barrier);
+	}
+
+	if (barrierNeeded)
+	{
+		*barrierNeeded = needed;
+	}
+}
+
+bool RenderGraph::isUsedAfter(uint32_t image, uint32_t pass) const
+{
+	for (uint32_t p = pass + 1; p < passes.size(); p++)
+	{
+		if (passes[p].culled)
+		{
+			continue;
+		}
+
+		for (const auto& access : passes[p].accesses)
+		{
+			if (access.isImage && access.resource == image && access.read)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void RenderGraph::createRenderPasses(const Avec<RenderPassDependencies>& dependencies)
+{
+	for (uint32_t p = 0; p < passes.size(); p++)
+	{
+		Pass& pass = passes[p];
+
+		if (pass.culled || pass.attachments.empty())
+		{
+			continue;
+		}
+
+		const RenderPassDependencies& passDependencies = dependencies[p];
+
+		Avec<VkAttachmentDescription> descriptions;
+		Avec<VkAttachmentReference> colorReferences;
+		Avec<VkAttachmentReference> resolveReferences;
+		Avec<uint32_t> colorImages;
+		std::optional<VkAttachmentReference> depthReference;
+
+		pass.clearValues.clear();
+		pass.extent = images[pass.attachments[0].image].desc.extent;
+
+		for (uint32_t a = 0; a < pass.attachments.size(); a++)
+		{
+			const Attachment& attachment = pass.attachments[a];
+			const Image& image = images[attachment.image];
+			const AttachmentTransition& transition = passDependencies.transitions[a];
+
+			VkAttachmentLoadOp loadOp = getLoadOp(attachment, transition);
+			VkAttachmentStoreOp storeOp = getStoreOp(attachment, p);
+
+			bool hasStencil = (getAspectMask(image.desc.format) & VK_IMAGE_ASPECT_STENCIL_BIT) != 0;
+
+			VkAttachmentDescription description{};
+			description.format = image.desc.format;
+			description.samples = image.desc.samples;
+			description.loadOp = loadOp;
+			description.storeOp = storeOp;
+			description.stencilLoadOp = hasStencil ? loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			description.stencilStoreOp = hasStencil ? storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			// Discarded contents can start from any layout.
+			description.initialLayout = loadOp == VK_ATTACHMENT_LOAD_OP_LOAD ? transition.initialLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+			description.finalLayout = transition.finalLayout;
+			descriptions.push_back(description);
+
+			VkAttachmentReference reference{};
+			reference.attachment = a;
+
+			if (attachment.depth)
+			{
+				reference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+				depthReference = reference;
+			}
+			else if (attachment.resolveSource == UINT32_MAX)
+			{
+				reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+				colorReferences.push_back(reference);
+				colorImages.push_back(attachment.image);
+			}
+
+			pass.clearValues.push_back(attachment.clearValue);
+		}
+
+		// One resolve reference per color attachment, unused where there is
+		// nothing to resolve.
+		for (uint32_t a = 0; a < pass.attachments.size(); a++)
+		{
+			const Attachment& attachment = pass.attachments[a];
+
+			if (attachment.resolveSource == UINT32_MAX)
+			{
+				continue;
+			}
+
+			checkResolve(pass, attachment);
+
+			resolveReferences.resize(colorReferences.size(), { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED });
+
+			size_t color = std::find(colorImages.begin(), colorImages.end(), attachment.resolveSource) - colorImages.begin();
+			resolveReferences[color] = { a, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+		}
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+		subpass.pColorAttachments = colorReferences.data();
+		subpass.pResolveAttachments = resolveReferences.empty() ? nullptr : resolveReferences.data();
+		subpass.pDepthStencilAttachment = depthReference.has_value() ? &depthReference.value() : nullptr;
+
+		Avec<VkSubpassDependency> subpassDependencies;
+
+		if (passDependencies.enter.srcStageMask != 0)
+		{
+			VkSubpassDependency enter = passDependencies.enter;
+			enter.srcSubpass = VK_SUBPASS_EXTERNAL;
+			enter.dstSubpass = 0;
+			subpassDependencies.push_back(enter);
+		}
+
+		if (passDependencies.leave.srcStageMask != 0)
+		{
+			VkSubpassDependency leave = passDependencies.leave;
+			leave.srcSubpass = 0;
+			leave.dstSubpass = VK_SUBPASS_EXTERNAL;
+
+			if (leave.dstStageMask == 0)
+			{
+				leave.dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+			}
+
+			subpassDependencies.push_back(leave);
+		}
+
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(descriptions.size());
+		renderPassInfo.pAttachments = descriptions.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(subpassDependencies.size());
+		renderPassInfo.pDependencies = subpassDependencies.data();
+
+		if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &pass.renderPass) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create render pass for " + pass.name);
+		}
+	}
+}
+
+void RenderGraph::prepareDynamicRendering(const Avec<RenderPassDependencies>& dependencies)
+{
+#ifdef VK_KHR_dynamic_rendering
+	cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdBeginRenderingKHR"));
+	cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdEndRenderingKHR"));
+
+	if (cmdBeginRendering == nullptr || cmdEndRendering == nullptr)
+	{
+		throw std::runtime_error("VK_KHR_dynamic_rendering is not enabled on the device.");
+	}
+#endif
+
+	for (uint32_t p = 0; p < passes.size(); p++)
+	{
+		Pass& pass = passes[p];
+
+		pass.loadOps.clear();
+		pass.storeOps.clear();
+		pass.clearValues.clear();
+		pass.leaveBarriers = {};
+
+		if (pass.culled || pass.attachments.empty())
+		{
+			continue;
+		}
+
+		const RenderPassDependencies& passDependencies = dependencies[p];
+		const VkSubpassDependency& enter = passDependencies.enter;
+		const VkSubpassDependency& leave = passDependencies.leave;
+
+		pass.extent = images[pass.attachments[0].image].desc.extent;
+
+		for (uint32_t a = 0; a < pass.attachments.size(); a++)
+		{
+			const Attachment& attachment = pass.attachments[a];
+			const AttachmentTransition& transition = passDependencies.transitions[a];
+
+			if (attachment.resolveSource != UINT32_MAX)
+			{
+				checkResolve(pass, attachment);
+			}
+
+			VkAttachmentLoadOp loadOp = getLoadOp(attachment, transition);
+
+			pass.loadOps.push_back(loadOp);
+			pass.storeOps.push_back(getStoreOp(attachment, p));
+			pass.clearValues.push_back(attachment.clearValue);
+
+			UsageInfo usage = getUsageInfo(attachment.depth ? ResourceUsage::DepthStencilAttachment : ResourceUsage::ColorAttachment);
+
+			// What the render pass did on entry: the dependency on earlier
+			// accesses and the transition, from UNDEFINED unless loaded.
+			VkImageLayout oldLayout = loadOp == VK_ATTACHMENT_LOAD_OP_LOAD ? transition.initialLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+			if (oldLayout != usage.layout || enter.srcStageMask != 0)
+			{
+				pass.barriers.srcStageMask |= enter.srcStageMask != 0 ? enter.srcStageMask : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+				pass.barriers.dstStageMask |= usage.stageMask;
+				pass.barriers.barriers.push_back({ attachment.image, true, enter.srcAccessMask, usage.accessMask, oldLayout, usage.layout });
+			}
+
+			// And on exit, into the layout the next user expects.
+			if (transition.finalLayout != usage.layout)
+			{
+				pass.leaveBarriers.srcStageMask |= leave.srcStageMask != 0 ? leave.srcStageMask : usage.stageMask;
+				pass.leaveBarriers.dstStageMask |= leave.dstStageMask;
+				pass.leaveBarriers.barriers.push_back({ attachment.image, true, leave.srcAccessMask, leave.dstAccessMask, usage.layout, transition.finalLayout });
+			}
+		}
+	}
+}
+
+void RenderGraph::beginRendering(VkCommandBuffer commandBuffer, const Pass& pass)
+{
+#ifdef VK_KHR_dynamic_rendering
+	Avec<VkRenderingAttachmentInfoKHR> colorAttachments;
+	Avec<uint32_t> colorImages;
+	std::optional<VkRenderingAttachmentInfoKHR> depthAttachment;
+	bool hasStencil = false;
+
+	for (uint32_t a = 0; a < pass.attachments.size(); a++)
+	{
+		const Attachment& attachment = pass.attachments[a];
+		const Image& image = images[attachment.image];
+
+		if (image.view == VK_NULL_HANDLE)
+		{
+			throw std::runtime_error("Render graph image " + image.name + " is not bound.");
+		}
+
+		if (attachment.resolveSource != UINT32_MAX)
+		{
+			continue;
+		}
+
+		VkRenderingAttachmentInfoKHR info{};
+		info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		info.imageView = image.view;
+		info.resolveMode = VK_RESOLVE_MODE_NONE_KHR;
+		info.loadOp = pass.loadOps[a];
+		info.storeOp = pass.storeOps[a];
+		info.clearValue = pass.clearValues[a];
+
+		if (attachment.depth)
+		{
+			info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			depthAttachment = info;
+			hasStencil = (getAspectMask(image.desc.format) & VK_IMAGE_ASPECT_STENCIL_BIT) != 0;
+		}
+		else
+		{
+			info.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			colorAttachments.push_back(info);
+			colorImages.push_back(attachment.image);
+		}
+	}
+
+	// Resolves are part of the attachment they resolve.
+	for (const auto& attachment : pass.attachments)
+	{
+		if (attachment.resolveSource == UINT32_MAX)
+		{
+			continue;
+		}
+
+		size_t color = std::find(colorImages.begin(), colorImages.end(), attachment.resolveSource) - colorImages.begin();
+		colorAttachments[color].resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT_KHR;
+		colorAttachments[color].resolveImageView = images[attachment.image].view;
+		colorAttachments[color].resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	}
+
+	VkRenderingInfoKHR renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+	renderingInfo.flags = pass.secondaryCommandBuffers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0;
+	renderingInfo.renderArea.offset = { 0, 0 };
+	renderingInfo.renderArea.extent = pass.extent;
+	renderingInfo.layerCount = 1;
+	renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size());
+	renderingInfo.pColorAttachments = colorAttachments.data();
+	renderingInfo.pDepthAttachment = depthAttachment.has_value() ? &depthAttachment.value() : nullptr;
+	renderingInfo.pStencilAttachment = hasStencil ? &depthAttachment.value() : nullptr;
+
+	cmdBeginRendering(commandBuffer, &renderingInfo);
+#else
+	(void)commandBuffer;
+	(void)pass;
+#endif
+}
+
+VkAttachmentLoadOp RenderGraph::getLoadOp(const Attachment& attachment, const AttachmentTransition& transition) const
+{
+	if (attachment.load == AttachmentLoad::Clear)
+	{
+		return VK_ATTACHMENT_LOAD_OP_CLEAR;
+	}
+
+	if (attachment.load == AttachmentLoad::Load && transition.hasContents)
+	{
+		return VK_ATTACHMENT_LOAD_OP_LOAD;
+	}
+
+	return VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+}
+
+VkAttachmentStoreOp RenderGraph::getStoreOp(const Attachment& attachment, uint32_t pass) const
+{
+	// Contents nobody reads later never have to leave tile memory.
+	return images[attachment.image].imported || isUsedAfter(attachment.image, pass) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+}
+
+void RenderGraph::checkResolve(const Pass& pass, const Attachment& attachment) const
+{
+	const Image& source = images[attachment.resolveSource];
+	const Image& target = images[attachment.image];
+
+	if (source.desc.samples == VK_SAMPLE_COUNT_1_BIT || target.desc.samples != VK_SAMPLE_COUNT_1_BIT)
+	{
+		throw std::runtime_error("Render graph pass " + pass.name + " resolves " + source.name + " into " + target.name +
+			", only multisampled images resolve into single sampled ones.");
+	}
+}
+
+void RenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch& batch)
+{
+	if (batch.barriers.empty())
+	{
+		return;
+	}
+
+	Avec<VkImageMemoryBarrier> imageBarriers;
+	Avec<VkBufferMemoryBarrier> bufferBarriers;
+
+	for (const auto& barrier : batch.barriers)
+	{
+		if (barrier.isImage)
+		{
+			const Image& image = images[barrier.resource];
+
+			if (image.image == VK_NULL_HANDLE)
+			{
+				throw std::runtime_error("Render graph image " + image.name + " is not bound.");
+			}
+
+			VkImageMemoryBarrier imageBarrier{};
+			imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageBarrier.srcAccessMask = barrier.srcAccessMask;
+			imageBarrier.dstAccessMask = barrier.dstAccessMask;
+			imageBarrier.oldLayout = barrier.oldLayout;
+			imageBarrier.newLayout = barrier.newLayout;
+			imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.image = image.image;
+			imageBarrier.subresourceRange.aspectMask = getAspectMask(image.desc.format);
+			imageBarrier.subresourceRange.baseMipLevel = 0;
+			imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+			imageBarrier.subresourceRange.baseArrayLayer = 0;
+			imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+			imageBarriers.push_back(imageBarrier);
+		}
+		else
+		{
+			const Buffer& buffer = buffers[barrier.resource];
+
+			if (buffer.buffer == VK_NULL_HANDLE)
+			{
+				throw std::runtime_error("Render graph buffer " + buffer.name + " is not bound.");
+			}
+
+			VkBufferMemoryBarrier bufferBarrier{};
+			bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			bufferBarrier.srcAccessMask = barrier.srcAccessMask;
+			bufferBarrier.dstAccessMask = barrier.dstAccessMask;
+			bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bufferBarrier.buffer = buffer.buffer;
+			bufferBarrier.offset = 0;
+			bufferBarrier.size = VK_WHOLE_SIZE;
+			bufferBarriers.push_back(bufferBarrier);
+		}
+	}
+
+	VkPipelineStageFlags dstStageMask = batch.dstStageMask != 0 ? batch.dstStageMask : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		batch.srcStageMask, dstStageMask,
+		0,
+		0, nullptr,
+		static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+		static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+	);
+}
+
+VkFramebuffer RenderGraph::getFramebuffer(Pass& pass)
+{
+	Avec<VkImageView> views;
+
+	for (const auto& attachment : pass.attachments)
+	{
+		const Image& image = images[attachment.image];
+
+		if (image.view == VK_NULL_HANDLE)
+		{
+			throw std::runtime_error("Render graph image " + image.name + " is not bound.");
+		}
+
+		views.push_back(image.view);
+	}
+
+	auto it = pass.framebuffers.find(views);
+
+	if (it != pass.framebuffers.end())
+	{
+		return it->second;
+	}
+
+	VkFramebufferCreateInfo framebufferInfo{};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = pass.renderPass;
+	framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+	framebufferInfo.pAttachments = views.data();
+	framebufferInfo.width = pass.extent.width;
+	framebufferInfo.height = pass.extent.height;
+	framebufferInfo.layers = 1;
+
+	VkFramebuffer framebuffer;
+
+	if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create framebuffer for " + pass.name);
+	}
+
+	pass.framebuffers[views] = framebuffer;
+
+	return framebuffer;
+}
@@ -0,0 +1,418 @@
+#ifndef __RenderGraph_h__
+#define __RenderGraph_h__
+
+#pragma once
+
+#include "Pch.h"
+#include "DeviceAllocator.h"
+
+// How a pass uses a resource. Every usage stands for the pipeline stages,
+// access and, for images, the layout the graph synchronizes against.
+enum class ResourceUsage
+{
+	ColorAttachment,
+	DepthStencilAttachment,
+	DepthStencilRead,
+	SampledFragment,
+	SampledCompute,
+	StorageRead,
+	StorageWrite,
+	TransferSrc,
+	TransferDst,
+	IndirectRead,
+	VertexRead,
+	IndexRead,
+	UniformRead
+};
+
+enum class AttachmentLoad
+{
+	Clear,
+	Load,
+	DontCare
+};
+
+struct RenderGraphImageDesc
+{
+	VkFormat format;
+	VkExtent2D extent;
+	VkSampleCountFlagBits samples { VK_SAMPLE_COUNT_1_BIT };
+};
+
+// State an imported resource is in when the frame starts, or has to be left
+// in when it ends. An UNDEFINED final layout leaves the layout as it is.
+struct ExternalAccess
+{
+	VkImageLayout layout { VK_IMAGE_LAYOUT_UNDEFINED };
+	VkPipelineStageFlags stageMask { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT };
+	VkAccessFlags accessMask { 0 };
+};
+
+// Frame described as passes that declare what they read and write. Compiling
+// the graph
+//
+//  - drops passes whose results nobody uses,
+//  - gives every pass with attachments a render pass of its own, with load
+//    and store ops derived from how the attachments are used before and
+//    after, and layout transitions folded into the render pass. With
+//    dynamic rendering the same load and store ops are used, the
+//    transitions become barriers and no render pass or framebuffer objects
+//    exist at all,
+//  - works out the barriers between passes, batched into one
+//    vkCmdPipelineBarrier per pass and skipped between reads,
+//  - creates the transient images and lets those whose lifetimes do not
+//    overlap share memory. Images only used as attachments within a single
+//    pass are TRANSIENT_ATTACHMENT in lazily allocated memory where the
+//    device has it, so on tile-based GPUs they never reach main memory.
+//
+// Passes and resources are declared once and compiled; imported resources
+// are bound to their handles before each execute().
+class RenderGraph
+{
+public:
+	struct ImageHandle
+	{
+		uint32_t index { UINT32_MAX };
+
+		bool isValid() const
+		{
+			return index != UINT32_MAX;
+		}
+	};
+
+	struct BufferHandle
+	{
+		uint32_t index { UINT32_MAX };
+
+		bool isValid() const
+		{
+			return index != UINT32_MAX;
+		}
+	};
+
+	struct PassHandle
+	{
+		uint32_t index { UINT32_MAX };
+
+		bool isValid() const
+		{
+			return index != UINT32_MAX;
+		}
+	};
+
+	struct PassContext
+	{
+		VkCommandBuffer commandBuffer;
+
+		// Only set for passes with attachments, which execute inside it.
+		// Both are VK_NULL_HANDLE with dynamic rendering.
+		VkRenderPass renderPass;
+		VkFramebuffer framebuffer;
+		VkExtent2D extent;
+	};
+
+	// Attachment formats of a pass. Without a render pass, pipelines and
+	// secondary command buffers are created against these.
+	struct RenderingFormats
+	{
+		Avec<VkFormat> colorFormats;
+		VkFormat depthFormat { VK_FORMAT_UNDEFINED };
+		VkFormat stencilFormat { VK_FORMAT_UNDEFINED };
+		VkSampleCountFlagBits samples { VK_SAMPLE_COUNT_1_BIT };
+	};
+
+	class PassBuilder
+	{
+	public:
+		void colorAttachment(ImageHandle image, AttachmentLoad load = AttachmentLoad::Clear, VkClearColorValue clearValue = {});
+		void depthAttachment(ImageHandle image, AttachmentLoad load = AttachmentLoad::Clear, VkClearDepthStencilValue clearValue = { 1.0f, 0 });
+
+		// Resolves the multisampled color attachment source into image at the
+		// end of the subpass. source has to be added first.
+		void resolveAttachment(ImageHandle image, ImageHandle source);
+
+		void read(ImageHandle image, ResourceUsage usage);
+		void write(ImageHandle image, ResourceUsage usage);
+		void read(BufferHandle buffer, ResourceUsage usage);
+		void write(BufferHandle buffer, ResourceUsage usage);
+
+		// Reads and writes, keeping what earlier passes wrote. Atomic
+		// counters and in-place updates.
+		void modify(ImageHandle image, ResourceUsage usage);
+		void modify(BufferHandle buffer, ResourceUsage usage);
+
+		// The render pass contents are recorded into secondary command buffers.
+		void useSecondaryCommandBuffers();
+
+		// Keeps the pass even when nothing reads what it writes.
+		void sideEffect();
+
+	private:
+		friend class RenderGraph;
+
+		PassBuilder(RenderGraph& graph, uint32_t pass)
+			: graph { graph }, pass { pass }
+		{
+		}
+
+		RenderGraph& graph;
+		uint32_t pass;
+	};
+
+	struct Stats
+	{
+		uint32_t passCount { 0 };
+		uint32_t culledPassCount { 0 };
+		uint32_t barrierCount { 0 };
+		uint32_t transientImageCount { 0 };
+		VkDeviceSize transientMemoryBytes { 0 };
+		VkDeviceSize aliasedMemoryBytes { 0 };
+
+		// Part of transientMemoryBytes in lazily allocated memory, which
+		// may never be backed by physical memory at all.
+		VkDeviceSize lazyMemoryBytes { 0 };
+	};
+
+	using SetupCallback = std::function<void(PassBuilder&)>;
+	using ExecuteCallback = std::function<void(const PassContext&)>;
+	using PassBeginHook = std::function<void(VkCommandBuffer, const char*)>;
+	using PassEndHook = std::function<void(VkCommandBuffer)>;
+
+	RenderGraph() = default;
+	RenderGraph(const RenderGraph&) = delete;
+	RenderGraph& operator=(const RenderGraph&) = delete;
+
+	// Moving hands over everything compiled, so a graph still used by frames
+	// in flight can be destroyed later while a new one is built. Only move
+	// into an empty graph, nothing is destroyed.
+	RenderGraph(RenderGraph&&) = default;
+	RenderGraph& operator=(RenderGraph&&) = default;
+
+	// Created, owned and aliased by the graph, contents only live within a frame.
+	ImageHandle createImage(const Astr& name, const RenderGraphImageDesc& desc);
+
+	ImageHandle importImage(const Astr& name, const RenderGraphImageDesc& desc, const ExternalAccess& initial, const ExternalAccess& final);
+	BufferHandle importBuffer(const Astr& name, const ExternalAccess& initial, const ExternalAccess& final);
+
+	// Passes execute in the order they are added.
+	PassHandle addPass(const Astr& name, const SetupCallback& setup, const ExecuteCallback& execute);
+
+	// Begins passes with vkCmdBeginRenderingKHR instead of render pass and
+	// framebuffer objects. VK_KHR_dynamic_rendering has to be enabled on the
+	// device. Takes effect with the next compile().
+	void setDynamicRendering(bool enabled);
+
+	bool usesDynamicRendering() const
+	{
+		return dynamicRendering;
+	}
+
+	void compile(VkDevice device, DeviceAllocator& allocator);
+
+	// Destroys everything compiled and forgets all passes and resources.
+	void reset();
+
+	void bindImage(ImageHandle image, VkImage handle, VkImageView view);
+	void bindBuffer(BufferHandle buffer, VkBuffer handle);
+
+	void execute(VkCommandBuffer commandBuffer);
+
+	// Framebuffers are created on demand per set of bound image views, they
+	// have to be dropped before imported views are destroyed.
+	void clearFramebuffers();
+
+	void setPassHooks(const PassBeginHook& begin, const PassEndHook& end);
+
+	VkRenderPass getRenderPass(PassHandle pass) const;
+	RenderingFormats getRenderingFormats(PassHandle pass) const;
+	bool isCulled(PassHandle pass) const;
+
+	// What a pass executes with: the bound handle, or the transient image.
+	VkImage getImage(ImageHandle image) const;
+	VkImageView getImageView(ImageHandle image) const;
+	VkBuffer getBuffer(BufferHandle buffer) const;
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+private:
+	struct UsageInfo
+	{
+		VkPipelineStageFlags stageMask;
+		VkAccessFlags accessMask;
+		VkImageLayout layout;
+		VkImageUsageFlags imageUsage;
+	};
+
+	struct Access
+	{
+		uint32_t resource;
+		bool isImage;
+		ResourceUsage usage;
+		bool read;
+		bool write;
+	};
+
+	struct Attachment
+	{
+		uint32_t image;
+		AttachmentLoad load;
+		VkClearValue clearValue;
+		bool depth;
+
+		// Color attachment image resolved into this one, UINT32_MAX if none.
+		uint32_t resolveSource;
+	};
+
+	struct Barrier
+	{
+		uint32_t resource;
+		bool isImage;
+		VkAccessFlags srcAccessMask;
+		VkAccessFlags dstAccessMask;
+		VkImageLayout oldLayout;
+		VkImageLayout newLayout;
+	};
+
+	struct BarrierBatch
+	{
+		VkPipelineStageFlags srcStageMask { 0 };
+		VkPipelineStageFlags dstStageMask { 0 };
+		Avec<Barrier> barriers;
+	};
+
+	struct Pass
+	{
+		Astr name;
+		ExecuteCallback execute;
+
+		Avec<Access> accesses;
+		Avec<Attachment> attachments;
+		bool secondaryCommandBuffers { false };
+		bool sideEffect { false };
+
+		// Compiled
+		bool culled { false };
+		BarrierBatch barriers;
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkExtent2D extent {};
+		Avec<VkClearValue> clearValues;
+		std::map<Avec<VkImageView>, VkFramebuffer> framebuffers;
+
+		// Dynamic rendering, per attachment, and the transitions out of the
+		// attachment layouts a render pass would have made.
+		Avec<VkAttachmentLoadOp> loadOps;
+		Avec<VkAttachmentStoreOp> storeOps;
+		BarrierBatch leaveBarriers;
+	};
+
+	struct Image
+	{
+		Astr name;
+		RenderGraphImageDesc desc;
+		bool imported { false };
+		ExternalAccess initial;
+		ExternalAccess final;
+
+		VkImage image = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+
+		// Transient images only.
+		VkImageUsageFlags usage { 0 };
+		uint32_t firstPass { UINT32_MAX };
+		uint32_t lastPass { 0 };
+		uint32_t memorySlot { UINT32_MAX };
+		bool lazy { false };
+	};
+
+	struct Buffer
+	{
+		Astr name;
+		ExternalAccess initial;
+		ExternalAccess final;
+
+		VkBuffer buffer = VK_NULL_HANDLE;
+	};
+
+	// Memory shared by transient images with disjoint lifetimes.
+	struct MemorySlot
+	{
+		VkMemoryRequirements requirements;
+		uint32_t lastPass;
+		bool lazy;
+		Allocation allocation;
+	};
+
+	// Synchronization state of a resource while the frame is simulated.
+	struct ResourceState
+	{
+		VkImageLayout layout { VK_IMAGE_LAYOUT_UNDEFINED };
+		VkPipelineStageFlags writeStageMask { 0 };
+		VkAccessFlags writeAccessMask { 0 };
+		VkPipelineStageFlags readStageMask { 0 };
+		VkAccessFlags readAccessMask { 0 };
+	};
+
+	// How the attachments of a pass enter and leave its render pass.
+	struct AttachmentTransition
+	{
+		VkImageLayout initialLayout;
+		VkImageLayout finalLayout;
+		bool hasContents;
+	};
+
+	struct RenderPassDependencies
+	{
+		Avec<AttachmentTransition> transitions;
+		VkSubpassDependency enter {};
+		VkSubpassDependency leave {};
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	DeviceAllocator* allocator = nullptr;
+
+	bool dynamicRendering { false };
+#ifdef VK_KHR_dynamic_rendering
+	PFN_vkCmdBeginRenderingKHR cmdBeginRendering = nullptr;
+	PFN_vkCmdEndRenderingKHR cmdEndRendering = nullptr;
+#endif
+
+	Avec<Pass> passes;
+	Avec<Image> images;
+	Avec<Buffer> buffers;
+	Avec<MemorySlot> memorySlots;
+	BarrierBatch finalBarriers;
+
+	PassBeginHook passBegin;
+	PassEndHook passEnd;
+
+	Stats stats;
+
+	static UsageInfo getUsageInfo(ResourceUsage usage);
+	static bool isDepthFormat(VkFormat format);
+	static VkImageAspectFlags getAspectMask(VkFormat format);
+
+	void addAccess(uint32_t pass, uint32_t resource, bool isImage, ResourceUsage usage, bool read, bool write);
+
+	void cullPasses();
+	void createTransientImages();
+	Avec<RenderPassDependencies> buildBarriers();
+	void createRenderPasses(const Avec<RenderPassDependencies>& dependencies);
+	void prepareDynamicRendering(const Avec<RenderPassDependencies>& dependencies);
+
+	VkAttachmentLoadOp getLoadOp(const Attachment& attachment, const AttachmentTransition& transition) const;
+	VkAttachmentStoreOp getStoreOp(const Attachment& attachment, uint32_t pass) const;
+	void checkResolve(const Pass& pass, const Attachment& attachment) const;
+
+	void simulate(Avec<ResourceState>& slotStates, Avec<RenderPassDependencies>* dependencies);
+	void transition(ResourceState& state, const Access& access, const UsageInfo& usage, BarrierBatch& batch, bool* barrierNeeded);
+	bool isUsedAfter(uint32_t image, uint32_t pass) const;
+
+	void recordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch& batch);
+	VkFramebuffer getFramebuffer(Pass& pass);
+	void beginRendering(VkCommandBuffer commandBuffer, const Pass& pass);
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "Pch.h"
+#include "ShaderPack.h"
+
+ShaderPack::ShaderPack(const Astr& path)
+	: file(path)
+{
+	FileHeader header{};
+
+	if (file.size() < sizeof(FileHeader))
+	{
+		throw std::runtime_error("Shader pack " + path + " is truncated.");
+	}
+
+	std::memcpy(&header, file.data(), sizeof(FileHeader));
+
+	if (header.magic != FILE_MAGIC || header.version != FILE_VERSION)
+	{
+		throw std::runtime_error(path + " is not a shader pack of a supported version.");
+	}
+
+	if (header.entryCount > (file.size() - sizeof(FileHeader)) / sizeof(Entry))
+	{
+		throw std::runtime_error("Shader pack " + path + " is truncated.");
+	}
+
+	const uint8_t* entries = file.data() + sizeof(FileHeader);
+
+	for (uint32_t i = 0; i < header.entryCount; i++)
+	{
+		Entry entry{};
+		std::memcpy(&entry, entries + i * sizeof(Entry), sizeof(Entry));
+
+		bool inBounds = entry.offset <= file.size() && entry.size <= file.size() - entry.offset;
+		bool aligned = entry.offset % sizeof(uint32_t) == 0 && entry.size % sizeof(uint32_t) == 0;
+
+		if (!inBounds || !aligned || entry.size == 0)
+		{
+			throw std::runtime_error("Shader pack " + path + " has a malformed entry.");
+		}
+
+		// The mapping is page aligned, so are the words at a 4-byte aligned offset.
+		ShaderCode code;
+		code.words = reinterpret_cast<const uint32_t*>(file.data() + entry.offset);
+		code.size = entry.size;
+
+		if (code.words[0] != SPIRV_MAGIC)
+		{
+			throw std::runtime_error("Shader pack " + path + " has an entry that is not SPIR-V.");
+		}
+
+		Astr name(entry.name, strnlen(entry.name, sizeof(entry.name)));
+		shaders[name] = code;
+	}
+}
+
+std::optional<ShaderCode> ShaderPack::find(const Astr& name) const
+{
+	auto it = shaders.find(name);
+
+	if (it == shaders.end())
+	{
+		return std::nullopt;
+	}
+
+	return it->second;
+}
+
+Avec<Astr> ShaderPack::getNames() const
+{
+	Avec<Astr> names;
+
+	for (const auto& [name, code] : shaders)
+	{
+		names.push_back(name);
+	}
+
+	return names;
+}
+
+void ShaderPack::write(const Astr& path, const Avec<std::pair<Astr, ShaderCode>>& shaders)
+{
+	FileHeader header{};
+	header.magic = FILE_MAGIC;
+	header.version = FILE_VERSION;
+	header.entryCount = static_cast<uint32_t>(shaders.size());
+
+	Avec<Entry> entries(shaders.size());
+	uint64_t offset = sizeof(FileHeader) + entries.size() * sizeof(Entry);
+
+	for (size_t i = 0; i < shaders.size(); i++)
+	{
+		const auto& [name, code] = shaders[i];
+
+		if (name.size() >= sizeof(entries[i].name))
+		{
+			throw std::runtime_error("Shader name " + name + " is too long for a shader pack.");
+		}
+
+		if (code.size == 0 || code.size % sizeof(uint32_t) != 0)
+		{
+			throw std::runtime_error("Shader " + name + " is not a whole number of SPIR-V words.");
+		}
+
+		std::memset(entries[i].name, 0, sizeof(entries[i].name));
+		std::memcpy(entries[i].name, name.data(), name.size());
+		entries[i].offset = static_cast<uint32_t>(offset);
+		entries[i].size = static_cast<uint32_t>(code.size);
+
+		offset += code.size;
+	}
+
+	if (offset > UINT32_MAX)
+	{
+		throw std::runtime_error("Shader pack is too large.");
+	}
+
+	std::ofstream output(path, std::ios::binary | std::ios::trunc);
+
+	if (!output.is_open())
+	{
+		throw std::runtime_error("Failed to open " + path + " for writing.");
+	}
+
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+
+	for (const auto& [name, code] : shaders)
+	{
+		output.write(reinterpret_cast<const char*>(code.words), code.size);
+	}
+
+	if (!output)
+	{
+		throw std::runtime_error("Failed to write shader pack " + path);
+	}
+}
@@ -0,0 +1,64 @@
+#ifndef __ShaderPack_h__
+#define __ShaderPack_h__
+
+#pragma once
+
+#include "Pch.h"
+#include "MappedFile.h"
+
+// SPIR-V words ready for VkShaderModuleCreateInfo, size is in bytes.
+struct ShaderCode
+{
+	const uint32_t* words = nullptr;
+	size_t size { 0 };
+};
+
+template <size_t N>
+ShaderCode embeddedShader(const uint32_t (&words)[N])
+{
+	return { words, N * sizeof(uint32_t) };
+}
+
+// Set of named SPIR-V binaries in a single memory mapped file, used to load
+// shaders that are not built into the executable. The code handed out points
+// straight into the mapping and is valid as long as the pack is.
+//
+// Layout: a FileHeader, entryCount Entry records, then the code of every
+// entry at a 4-byte aligned offset from the start of the file.
+class ShaderPack
+{
+public:
+	explicit ShaderPack(const Astr& path);
+
+	std::optional<ShaderCode> find(const Astr& name) const;
+
+	Avec<Astr> getNames() const;
+
+	static void write(const Astr& path, const Avec<std::pair<Astr, ShaderCode>>& shaders);
+
+private:
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t reserved;
+	};
+
+	struct Entry
+	{
+		char name[56];
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	static constexpr uint32_t FILE_MAGIC { 0x4b505341 }; // "ASPK"
+	static constexpr uint32_t FILE_VERSION { 1 };
+	static constexpr uint32_t SPIRV_MAGIC { 0x07230203 };
+
+	MappedFile file;
+
+	Amap<Astr, ShaderCode> shaders;
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include "Pch.h"
+#include "ShaderWatcher.h"
+
+ShaderWatcher::~ShaderWatcher()
+{
+	stop();
+}
+
+void ShaderWatcher::start(const Astr& directory, const Astr& compiler, const Listener& onCompiled)
+{
+	stop();
+
+	this->directory = directory;
+	this->compiler = compiler;
+	this->onCompiled = onCompiled;
+
+	if (!std::filesystem::is_directory(this->directory))
+	{
+		throw std::runtime_error("Shader source directory " + directory + " does not exist.");
+	}
+
+	outputDirectory = std::filesystem::temp_directory_path() / "AstrumShaders";
+	std::filesystem::create_directories(outputDirectory);
+
+	writeTimes.clear();
+	scan(false);
+
+	stopping = false;
+	thread = std::thread(&ShaderWatcher::watchLoop, this);
+}
+
+void ShaderWatcher::stop()
+{
+	if (!thread.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+
+	wakeCondition.notify_all();
+	thread.join();
+}
+
+Amap<Astr, Avec<uint32_t>> ShaderWatcher::takeCompiled()
+{
+	// The lock is only held to move results in and out, never while compiling.
+	std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+
+	if (!lock.owns_lock())
+	{
+		return {};
+	}
+
+	Amap<Astr, Avec<uint32_t>> result = std::move(compiled);
+	compiled.clear();
+
+	return result;
+}
+
+bool ShaderWatcher::isShaderSource(const std::filesystem::path& path)
+{
+	std::filesystem::path extension = path.extension();
+	return extension == ".vert" || extension == ".frag" || extension == ".comp";
+}
+
+void ShaderWatcher::watchLoop()
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			if (wakeCondition.wait_for(lock, POLL_INTERVAL, [this]() { return stopping; }))
+			{
+				return;
+			}
+		}
+
+		try {
+			scan(true);
+		}
+		catch (const std::exception& e) {
+			// Mostly the directory being replaced under us, next poll retries.
+			std::cerr << e.what() << '\n';
+		}
+	}
+}
+
+void ShaderWatcher::scan(bool compileChanges)
+{
+	bool anyCompiled = false;
+
+	for (const auto& entry : std::filesystem::directory_iterator(directory))
+	{
+		if (!entry.is_regular_file() || !isShaderSource(entry.path()))
+		{
+			continue;
+		}
+
+		Astr name = entry.path().filename().string();
+		std::filesystem::file_time_type writeTime = entry.last_write_time();
+
+		auto known = writeTimes.find(name);
+
+		if (known != writeTimes.end() && known->second == writeTime)
+		{
+			continue;
+		}
+
+		writeTimes[name] = writeTime;
+
+		if (!compileChanges)
+		{
+			continue;
+		}
+
+		std::optional<Avec<uint32_t>> code = compile(entry.path());
+
+		if (!code.has_value())
+		{
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			compiled[name] = std::move(*code);
+		}
+
+		AMlog("Shader reload: compiled " << name);
+		anyCompiled = true;
+	}
+
+	if (anyCompiled && onCompiled)
+	{
+		onCompiled();
+	}
+}
+
+std::optional<Avec<uint32_t>> ShaderWatcher::compile(const std::filesystem::path& source)
+{
+	std::filesystem::path output = outputDirectory / (source.filename().string() + ".spv");
+	std::filesystem::remove(output);
+
+	std::ostringstream command;
+	command << '"' << compiler << "\" " << COMPILER_ARGUMENTS << " \"" << source.string() << "\" -o \"" << output.string() << '"';
+
+	Astr commandLine = command.str();
+
+#ifdef _WIN32
+	// cmd strips the outer quotes of a command that starts with one.
+	commandLine = '"' + commandLine + '"';
+#endif
+
+	// The compiler prints its own errors.
+	if (std::system(commandLine.c_str()) != 0)
+	{
+		AMlog("Shader reload: " << source.filename().string() << " failed to compile");
+		return std::nullopt;
+	}
+
+	std::ifstream file(output, std::ios::binary | std::ios::ate);
+
+	if (!file.is_open())
+	{
+		AMlog("Shader reload: " << output.string() << " was not written");
+		return std::nullopt;
+	}
+
+	size_t size = static_cast<size_t>(file.tellg());
+	constexpr uint32_t spirvMagic = 0x07230203;
+
+	Avec<uint32_t> words(size / sizeof(uint32_t));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(words.data()), static_cast<std::streamsize>(words.size() * sizeof(uint32_t)));
+
+	if (!file || size % sizeof(uint32_t) != 0 || words.empty() || words[0] != spirvMagic)
+	{
+		AMlog("Shader reload: " << output.string() << " is not SPIR-V");
+		return std::nullopt;
+	}
+
+	return words;
+}
@@ -0,0 +1,74 @@
+#ifndef __ShaderWatcher_h__
+#define __ShaderWatcher_h__
+
+#pragma once
+
+#include "Pch.h"
+
+// Set by the build to the compiler it runs on Shaders/ and that directory.
+#ifndef ASTRUM_GLSLC
+#define ASTRUM_GLSLC "glslc"
+#endif
+
+#ifndef ASTRUM_SHADER_SOURCE_DIRECTORY
+#define ASTRUM_SHADER_SOURCE_DIRECTORY "Shaders"
+#endif
+
+// Watches the GLSL sources of a directory and recompiles the ones that
+// changed to SPIR-V, all on its own thread. The render thread picks the
+// results up with takeCompiled(), which never waits for a compilation.
+// Sources that fail to compile, often files caught halfway through being
+// saved, are reported and tried again on their next change.
+class ShaderWatcher
+{
+public:
+	static constexpr std::chrono::milliseconds POLL_INTERVAL { 250 };
+
+	// Same as the build passes, see CMakeLists.txt.
+	static constexpr const char* COMPILER_ARGUMENTS { "--target-env=vulkan1.2" };
+
+	using Listener = std::function<void()>;
+
+	ShaderWatcher() = default;
+	~ShaderWatcher();
+
+	ShaderWatcher(const ShaderWatcher&) = delete;
+	ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+	// The sources as they are now count as compiled. onCompiled is called
+	// on the watcher thread whenever takeCompiled() has something new.
+	void start(const Astr& directory, const Astr& compiler, const Listener& onCompiled);
+	void stop();
+
+	bool isRunning() const
+	{
+		return thread.joinable();
+	}
+
+	// SPIR-V of the shaders compiled since the last call, by file name
+	// like the embedded shaders.
+	Amap<Astr, Avec<uint32_t>> takeCompiled();
+
+	static bool isShaderSource(const std::filesystem::path& path);
+
+private:
+	std::filesystem::path directory;
+	std::filesystem::path outputDirectory;
+	Astr compiler;
+	Listener onCompiled;
+
+	// Only touched by the watcher thread once it runs.
+	Amap<Astr, std::filesystem::file_time_type> writeTimes;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	bool stopping { false };
+	Amap<Astr, Avec<uint32_t>> compiled;
+
+	void watchLoop();
+	void scan(bool compileChanges);
+	std::optional<Avec<uint32_t>> compile(const std::filesystem::path& source);
+};
+
+#endif
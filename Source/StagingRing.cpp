@@ -0,0 +1,227 @@
+#include "Pch.h"
+#include "StagingRing.h"
+
+void StagingRing::create(VkDevice device, VkPhysicalDevice physicalDevice, DeviceAllocator& allocator, VkDeviceSize capacity, uint32_t framesInFlight)
+{
+	this->device = device;
+	this->allocator = &allocator;
+	this->capacity = capacity;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	nonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+
+	frameBytes.assign(framesInFlight, 0);
+
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = capacity;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create staging ring buffer.");
+	}
+
+	AllocationCreateInfo allocInfo{};
+	allocInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	allocInfo.preferredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+	allocation = allocator.allocateForBuffer(buffer, allocInfo);
+
+	VkMemoryPropertyFlags flags = allocator.getMemoryProperties().memoryTypes[allocation.memoryTypeIndex].propertyFlags;
+	coherent = (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+}
+
+void StagingRing::destroy()
+{
+	vkDestroyBuffer(device, buffer, nullptr);
+	allocator->free(allocation);
+
+	buffer = VK_NULL_HANDLE;
+	pendingCopies.clear();
+	pendingAcquires.clear();
+}
+
+void StagingRing::beginFrame(uint32_t frameIndex)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Frames retire in submission order, so the bytes of this frame are
+	// always the oldest ones in the ring.
+	usedBytes -= frameBytes[frameIndex];
+	frameBytes[frameIndex] = 0;
+	currentFrame = frameIndex;
+}
+
+bool StagingRing::upload(VkBuffer destination, VkDeviceSize destinationOffset, const void* data, VkDeviceSize size, uint32_t dstFamily)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	VkDeviceSize offset = alignUp(head, COPY_ALIGNMENT);
+	VkDeviceSize consumed = offset - head;
+	bool wraps = false;
+
+	// Uploads are never split across the end of the ring, skip to the start.
+	if (offset + size > capacity)
+	{
+		consumed = capacity - head;
+		offset = 0;
+		wraps = true;
+	}
+
+	if (usedBytes + consumed + size > capacity)
+	{
+		return false;
+	}
+
+	if (pendingCopies.empty())
+	{
+		dirtyBegin = offset;
+		dirtyWrapped = false;
+	}
+	else if (wraps)
+	{
+		dirtyWrapped = true;
+	}
+
+	std::memcpy(static_cast<char*>(allocation.mapped) + offset, data, static_cast<size_t>(size));
+
+	PendingCopy copy;
+	copy.destination = destination;
+	copy.region.srcOffset = offset;
+	copy.region.dstOffset = destinationOffset;
+	copy.region.size = size;
+	copy.dstFamily = dstFamily;
+	pendingCopies.push_back(copy);
+
+	head = offset + size;
+	usedBytes += consumed + size;
+	unflushedBytes += consumed + size;
+
+	return true;
+}
+
+void StagingRing::flush(VkCommandBuffer commandBuffer, uint32_t srcFamily, uint32_t dstFamily)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (pendingCopies.empty())
+	{
+		return;
+	}
+
+	if (!coherent)
+	{
+		if (dirtyWrapped)
+		{
+			flushMappedRange(dirtyBegin, capacity);
+			flushMappedRange(0, head);
+		}
+		else
+		{
+			flushMappedRange(dirtyBegin, head);
+		}
+	}
+
+	// One vkCmdCopyBuffer per destination buffer.
+	std::stable_sort(pendingCopies.begin(), pendingCopies.end(), [](const PendingCopy& a, const PendingCopy& b) { return a.destination < b.destination; });
+
+	Avec<VkBufferCopy> regions;
+	Amap<uint32_t, BufferOwnershipTransfer> transfers;
+
+	for (size_t i = 0; i < pendingCopies.size(); i++)
+	{
+		regions.push_back(pendingCopies[i].region);
+
+		if (i + 1 == pendingCopies.size() || pendingCopies[i + 1].destination != pendingCopies[i].destination)
+		{
+			vkCmdCopyBuffer(commandBuffer, buffer, pendingCopies[i].destination, static_cast<uint32_t>(regions.size()), regions.data());
+
+			// One ownership transfer per destination, spanning all its regions.
+			VkDeviceSize begin = regions[0].dstOffset;
+			VkDeviceSize end = 0;
+
+			for (const auto& region : regions)
+			{
+				begin = std::min(begin, region.dstOffset);
+				end = std::max(end, region.dstOffset + region.size);
+			}
+
+			uint32_t family = pendingCopies[i].dstFamily != VK_QUEUE_FAMILY_IGNORED ? pendingCopies[i].dstFamily : dstFamily;
+			transfers.try_emplace(family, srcFamily, family).first->second.add(pendingCopies[i].destination, begin, end - begin);
+
+			regions.clear();
+		}
+	}
+
+	for (auto& [family, transfer] : transfers)
+	{
+		if (transfer.isFamilyChange())
+		{
+			transfer.recordRelease(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+			pendingAcquires.push_back(std::move(transfer));
+			continue;
+		}
+
+		// Only the graphics family reads at DESTINATION_STAGES, on any other
+		// family that flushes the reader is a compute shader.
+		bool graphicsReader = srcFamily == dstFamily;
+
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = graphicsReader ? DESTINATION_ACCESS : VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, graphicsReader ? DESTINATION_STAGES : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr
+		);
+	}
+
+	pendingCopies.clear();
+
+	frameBytes[currentFrame] += unflushedBytes;
+	unflushedBytes = 0;
+}
+
+void StagingRing::flushMappedRange(VkDeviceSize begin, VkDeviceSize end)
+{
+	if (end == begin)
+	{
+		return;
+	}
+
+	// Ranges of non-coherent memory are in whole atoms, which the allocator
+	// keeps within the allocation.
+	VkDeviceSize alignedBegin = (allocation.offset + begin) / nonCoherentAtomSize * nonCoherentAtomSize;
+
+	VkMappedMemoryRange range{};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = allocation.memory;
+	range.offset = alignedBegin;
+	range.size = alignUp(allocation.offset + end, nonCoherentAtomSize) - alignedBegin;
+
+	vkFlushMappedMemoryRanges(device, 1, &range);
+}
+
+void StagingRing::recordAcquire(VkCommandBuffer commandBuffer, uint32_t dstFamily, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Transfers to other families stay pending, in order.
+	auto acquired = std::stable_partition(pendingAcquires.begin(), pendingAcquires.end(), [dstFamily](const BufferOwnershipTransfer& transfer) { return transfer.getDstFamily() != dstFamily; });
+
+	for (auto it = acquired; it != pendingAcquires.end(); ++it)
+	{
+		it->recordAcquire(commandBuffer, dstStages, dstAccess);
+	}
+
+	pendingAcquires.erase(acquired, pendingAcquires.end());
+}
@@ -0,0 +1,103 @@
+#ifndef __StagingRing_h__
+#define __StagingRing_h__
+
+#pragma once
+
+#include "Pch.h"
+#include "DeviceAllocator.h"
+#include "QueueOwnership.h"
+
+// Persistently mapped host visible ring buffer for uploads to device local
+// buffers. Uploads only memcpy into the ring and queue a copy region; all
+// regions queued during a frame are recorded by one flush() into that frame's
+// command buffer, so a frame never submits more than one batch of transfers
+// and the CPU never waits for an individual copy.
+//
+// The copies may run on a transfer queue of another family than the one
+// reading the buffers. flush() then releases the destination ranges and
+// recordAcquire() acquires them on the reading queue. A buffer must not be
+// in use on the reading queue while an upload into it is pending.
+//
+// Space is handed back per frame slot: beginFrame() must be called once the
+// frame that last used the slot has finished on the GPU.
+class StagingRing
+{
+public:
+	// Stages and accesses uploaded data is made visible to.
+	static constexpr VkPipelineStageFlags DESTINATION_STAGES { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT };
+	static constexpr VkAccessFlags DESTINATION_ACCESS { VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT };
+
+	// Every upload starts at a multiple of it in the ring.
+	static constexpr VkDeviceSize COPY_ALIGNMENT { 16 };
+
+	void create(VkDevice device, VkPhysicalDevice physicalDevice, DeviceAllocator& allocator, VkDeviceSize capacity, uint32_t framesInFlight);
+	void destroy();
+
+	void beginFrame(uint32_t frameIndex);
+
+	// Returns false when the ring has no room left this frame, the caller
+	// should retry next frame or split the upload. dstFamily is the family
+	// reading the destination, when it is not the one given to flush().
+	bool upload(VkBuffer destination, VkDeviceSize destinationOffset, const void* data, VkDeviceSize size, uint32_t dstFamily = VK_QUEUE_FAMILY_IGNORED);
+
+	// Records the queued copies into a command buffer of srcFamily. Copies
+	// read on srcFamily are followed by a barrier that makes them visible,
+	// to DESTINATION_STAGES when srcFamily is also dstFamily and to compute
+	// shaders only otherwise; those read on another family by the release
+	// of the destinations.
+	void flush(VkCommandBuffer commandBuffer, uint32_t srcFamily, uint32_t dstFamily);
+
+	// Records the acquire of everything released to dstFamily by flush()
+	// since the last call into a command buffer of that family.
+	void recordAcquire(VkCommandBuffer commandBuffer, uint32_t dstFamily, VkPipelineStageFlags dstStages = DESTINATION_STAGES, VkAccessFlags dstAccess = DESTINATION_ACCESS);
+
+	bool hasPendingCopies() const
+	{
+		return !pendingCopies.empty();
+	}
+
+	VkDeviceSize getCapacity() const
+	{
+		return capacity;
+	}
+
+private:
+	struct PendingCopy
+	{
+		VkBuffer destination;
+		VkBufferCopy region;
+		uint32_t dstFamily;
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	DeviceAllocator* allocator = nullptr;
+
+	VkBuffer buffer = VK_NULL_HANDLE;
+	Allocation allocation;
+	bool coherent { true };
+	VkDeviceSize nonCoherentAtomSize { 1 };
+
+	VkDeviceSize capacity { 0 };
+	VkDeviceSize head { 0 };
+	VkDeviceSize usedBytes { 0 };
+
+	// Bytes consumed since the last flush, and per frame the bytes its last
+	// flush handed to the GPU.
+	VkDeviceSize unflushedBytes { 0 };
+	Avec<VkDeviceSize> frameBytes;
+	uint32_t currentFrame { 0 };
+
+	// Start of the bytes written since the last flush, which end at head
+	// after running past the end of the ring once when wrapped.
+	VkDeviceSize dirtyBegin { 0 };
+	bool dirtyWrapped { false };
+
+	Avec<PendingCopy> pendingCopies;
+	Avec<BufferOwnershipTransfer> pendingAcquires;
+
+	std::mutex mutex;
+
+	void flushMappedRange(VkDeviceSize begin, VkDeviceSize end);
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "Pch.h"
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	threadCount = std::max(threadCount, 1u);
+	workers.reserve(threadCount);
+
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+
+	wakeCondition.notify_all();
+
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::dispatch(uint32_t count, const std::function<void(uint32_t)>& job)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+
+	currentJob = &job;
+	jobCount = count;
+	nextJob = 0;
+	pendingJobs = count;
+	firstError = nullptr;
+
+	wakeCondition.notify_all();
+	doneCondition.wait(lock, [this] { return pendingJobs == 0; });
+
+	currentJob = nullptr;
+
+	if (firstError)
+	{
+		std::exception_ptr error = firstError;
+		firstError = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+void ThreadPool::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (true)
+	{
+		wakeCondition.wait(lock, [this] { return stopping || nextJob < jobCount; });
+
+		if (stopping)
+		{
+			return;
+		}
+
+		uint32_t index = nextJob++;
+		const std::function<void(uint32_t)>* job = currentJob;
+
+		lock.unlock();
+
+		std::exception_ptr error;
+		try {
+			(*job)(index);
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+
+		lock.lock();
+
+		if (error && !firstError)
+		{
+			firstError = error;
+		}
+
+		if (--pendingJobs == 0)
+		{
+			doneCondition.notify_one();
+		}
+	}
+}
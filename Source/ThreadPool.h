@@ -0,0 +1,46 @@
+#ifndef __ThreadPool_h__
+#define __ThreadPool_h__
+
+#pragma once
+
+#include "Pch.h"
+
+// Fixed set of worker threads that run batches of indexed jobs. A batch is
+// dispatched from one thread at a time and dispatch() only returns once every
+// job of the batch has finished.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(uint32_t threadCount);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	uint32_t size() const
+	{
+		return static_cast<uint32_t>(workers.size());
+	}
+
+	// Runs job(0) .. job(jobCount - 1) on the workers. The first exception
+	// thrown by a job is rethrown on the calling thread.
+	void dispatch(uint32_t jobCount, const std::function<void(uint32_t)>& job);
+
+private:
+	Avec<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+
+	const std::function<void(uint32_t)>* currentJob = nullptr;
+	uint32_t jobCount { 0 };
+	uint32_t nextJob { 0 };
+	uint32_t pendingJobs { 0 };
+	bool stopping { false };
+	std::exception_ptr firstError;
+
+	void workerLoop();
+};
+
+#endif
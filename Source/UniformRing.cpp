@@ -0,0 +1,172 @@
+#include "Pch.h"
+#include "UniformRing.h"
+
+void UniformRing::create(VkDevice device, VkPhysicalDevice physicalDevice, DeviceAllocator& allocator, VkDeviceSize slotCapacity, uint32_t slotCount, uint32_t maxBlockSize, const Avec<uint32_t>& queueFamilies)
+{
+	this->device = device;
+	this->allocator = &allocator;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 16);
+	nonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+	this->maxBlockSize = std::min(maxBlockSize, properties.limits.maxUniformBufferRange);
+	this->slotCapacity = alignUp(slotCapacity, alignment);
+
+	// The descriptor always covers maxBlockSize bytes from the dynamic offset,
+	// so the last block of the last slot needs that much room behind it.
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = this->slotCapacity * slotCount + this->maxBlockSize;
+	bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (queueFamilies.size() > 1)
+	{
+		bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+		bufferInfo.pQueueFamilyIndices = queueFamilies.data();
+	}
+
+	if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create uniform ring buffer.");
+	}
+
+	// Device local host visible memory where there is some, the GPU reads
+	// uniforms far more often than the CPU writes them.
+	AllocationCreateInfo allocInfo{};
+	allocInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	allocInfo.preferredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	allocation = allocator.allocateForBuffer(buffer, allocInfo);
+
+	VkMemoryPropertyFlags flags = allocator.getMemoryProperties().memoryTypes[allocation.memoryTypeIndex].propertyFlags;
+	coherent = (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+	VkDescriptorSetLayoutBinding binding{};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	binding.descriptorCount = 1;
+	binding.stageFlags = VK_SHADER_STAGE_ALL;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &binding;
+
+	if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create uniform ring set layout.");
+	}
+
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	poolSize.descriptorCount = 1;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create uniform ring descriptor pool.");
+	}
+
+	VkDescriptorSetAllocateInfo setInfo{};
+	setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setInfo.descriptorPool = pool;
+	setInfo.descriptorSetCount = 1;
+	setInfo.pSetLayouts = &setLayout;
+
+	if (vkAllocateDescriptorSets(device, &setInfo, &set) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate uniform ring descriptor set.");
+	}
+
+	VkDescriptorBufferInfo descriptorBufferInfo{};
+	descriptorBufferInfo.buffer = buffer;
+	descriptorBufferInfo.offset = 0;
+	descriptorBufferInfo.range = this->maxBlockSize;
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = set;
+	descriptorWrite.dstBinding = 0;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	descriptorWrite.pBufferInfo = &descriptorBufferInfo;
+
+	vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+
+	beginFrame(0);
+}
+
+void UniformRing::destroy()
+{
+	vkDestroyDescriptorPool(device, pool, nullptr);
+	vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+	vkDestroyBuffer(device, buffer, nullptr);
+	allocator->free(allocation);
+
+	pool = VK_NULL_HANDLE;
+	setLayout = VK_NULL_HANDLE;
+	set = VK_NULL_HANDLE;
+	buffer = VK_NULL_HANDLE;
+}
+
+void UniformRing::beginFrame(uint32_t slot)
+{
+	slotBegin = slotCapacity * slot;
+	head = slotBegin;
+}
+
+uint32_t UniformRing::push(const void* data, VkDeviceSize size)
+{
+	if (size > maxBlockSize)
+	{
+		throw std::runtime_error("Uniform block is larger than the uniform ring allows.");
+	}
+
+	VkDeviceSize offset = head.fetch_add(alignUp(size, alignment));
+
+	if (offset + size > slotBegin + slotCapacity)
+	{
+		throw std::runtime_error("Uniform ring is full.");
+	}
+
+	std::memcpy(static_cast<char*>(allocation.mapped) + offset, data, static_cast<size_t>(size));
+
+	return static_cast<uint32_t>(offset);
+}
+
+void UniformRing::flush()
+{
+	VkDeviceSize end = std::min(head.load(), slotBegin + slotCapacity);
+
+	if (coherent || end == slotBegin)
+	{
+		return;
+	}
+
+	// Ranges of non-coherent memory are in whole atoms, which the allocator
+	// keeps within the allocation.
+	VkDeviceSize begin = allocation.offset + slotBegin;
+	VkDeviceSize alignedBegin = begin / nonCoherentAtomSize * nonCoherentAtomSize;
+
+	VkMappedMemoryRange range{};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = allocation.memory;
+	range.offset = alignedBegin;
+	range.size = alignUp(allocation.offset + end, nonCoherentAtomSize) - alignedBegin;
+
+	vkFlushMappedMemoryRanges(device, 1, &range);
+}
+
+void UniformRing::bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t setIndex, uint32_t dynamicOffset) const
+{
+	vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, setIndex, 1, &set, 1, &dynamicOffset);
+}
@@ -0,0 +1,76 @@
+#ifndef __UniformRing_h__
+#define __UniformRing_h__
+
+#pragma once
+
+#include "Pch.h"
+#include "DeviceAllocator.h"
+
+// Persistently mapped host visible ring for uniform data, read by shaders
+// through one dynamic uniform buffer descriptor. push() copies a block into
+// the ring and returns the dynamic offset to bind the set with, so uniforms
+// never need a descriptor set of their own.
+//
+//  set N, binding 0: uniform block, at most getMaxBlockSize() bytes
+//
+// The ring is split into one region per frame slot. beginFrame() must be
+// called once the frame that last used the slot has finished on the GPU.
+//
+// When shaders on queues of several families read it, all of them are
+// passed in queueFamilies and the buffer is shared concurrently.
+class UniformRing
+{
+public:
+	void create(VkDevice device, VkPhysicalDevice physicalDevice, DeviceAllocator& allocator, VkDeviceSize slotCapacity, uint32_t slotCount, uint32_t maxBlockSize, const Avec<uint32_t>& queueFamilies = {});
+	void destroy();
+
+	void beginFrame(uint32_t slot);
+
+	// Returns the dynamic offset of the copy. Safe to call from several
+	// threads at once.
+	uint32_t push(const void* data, VkDeviceSize size);
+
+	template <typename T>
+	uint32_t push(const T& data)
+	{
+		return push(&data, sizeof(T));
+	}
+
+	// Makes everything pushed this frame visible to the device, only does
+	// work for memory that is not host coherent.
+	void flush();
+
+	void bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t setIndex, uint32_t dynamicOffset) const;
+
+	VkDescriptorSetLayout getSetLayout() const
+	{
+		return setLayout;
+	}
+
+	uint32_t getMaxBlockSize() const
+	{
+		return maxBlockSize;
+	}
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	DeviceAllocator* allocator = nullptr;
+
+	VkBuffer buffer = VK_NULL_HANDLE;
+	Allocation allocation;
+	bool coherent { true };
+	VkDeviceSize nonCoherentAtomSize { 1 };
+
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	VkDescriptorSet set = VK_NULL_HANDLE;
+
+	VkDeviceSize alignment { 256 };
+	VkDeviceSize slotCapacity { 0 };
+	uint32_t maxBlockSize { 0 };
+
+	VkDeviceSize slotBegin { 0 };
+	std::atomic<VkDeviceSize> head { 0 };
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef __Vertex_h__
+#define __Vertex_h__
+
+#pragma once
+
+#include "Pch.h"
+
+// Quantized vertex, 16 bytes. Positions are unorm16 within the bounds of
+// their mesh and scaled back with DrawPushConstants::positionScale and
+// positionOffset, normals are octahedral encoded snorm16, texture
+// coordinates half floats. MeshProcessor::quantize() produces them.
+struct Vertex
+{
+	uint16_t position[4];
+	int16_t normal[2];
+	uint16_t uv[2];
+
+	static VkVertexInputBindingDescription getBindingDescription()
+	{
+		VkVertexInputBindingDescription bindingDescription{};
+		bindingDescription.binding = 0;
+		bindingDescription.stride = sizeof(Vertex);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDescription;
+	}
+
+	// All three formats have mandatory vertex buffer support.
+	static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions()
+	{
+		std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+
+		attributeDescriptions[0].binding = 0;
+		attributeDescriptions[0].location = 0;
+		attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+		attributeDescriptions[0].offset = offsetof(Vertex, position);
+
+		attributeDescriptions[1].binding = 0;
+		attributeDescriptions[1].location = 1;
+		attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+		attributeDescriptions[1].offset = offsetof(Vertex, normal);
+
+		attributeDescriptions[2].binding = 0;
+		attributeDescriptions[2].location = 2;
+		attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+		attributeDescriptions[2].offset = offsetof(Vertex, uv);
+
+		return attributeDescriptions;
+	}
+};
+
+static_assert(sizeof(Vertex) == 16, "Vertex is uploaded and stored in mesh files as is.");
+
+#endif
@@ -0,0 +1,141 @@
+#include "Pch.h"
+#include "AllocationStrategy.h"
+#include "DeviceAllocator.h"
+
+// CPU only checks of the sub-allocation strategies, no device needed.
+
+namespace
+{
+	int failureCount = 0;
+
+	void check(bool condition, const char* expression, int line)
+	{
+		if (!condition)
+		{
+			std::cerr << "AllocatorTests.cpp:" << line << ": check failed: " << expression << '\n';
+			failureCount++;
+		}
+	}
+
+	#define CHECK(condition) check((condition), #condition, __LINE__)
+
+	void testLinear()
+	{
+		LinearStrategy linear { 1024 };
+
+		// Alignment
+		std::optional<uint64_t> first = linear.allocate(10, 1);
+		std::optional<uint64_t> second = linear.allocate(16, 256);
+		CHECK(first == 0u);
+		CHECK(second == 256u);
+		CHECK(linear.usedBytes() == 26);
+		CHECK(linear.largestFreeRange() == 1024 - 272);
+
+		// Exhaustion
+		CHECK(!linear.allocate(1024, 1).has_value());
+		CHECK(!linear.allocate(0, 1).has_value());
+		CHECK(linear.allocate(752, 1) == 272u);
+		CHECK(!linear.allocate(1, 1).has_value());
+
+		// The alignment padding is free but can never be handed out.
+		CHECK(linear.fragmentation() == 1.0);
+
+		// The head only goes back once everything is freed.
+		linear.free(*first);
+		CHECK(!linear.allocate(1, 1).has_value());
+		linear.free(*second);
+		linear.free(272);
+		CHECK(linear.allocationCount() == 0);
+		CHECK(linear.allocate(1024, 1) == 0u);
+
+		linear.reset();
+		CHECK(linear.usedBytes() == 0);
+		CHECK(linear.largestFreeRange() == 1024);
+	}
+
+	void testBuddy()
+	{
+		BuddyStrategy buddy { 1024, 64 };
+
+		// Sizes round up to a power of two, alignment raises the block size.
+		std::optional<uint64_t> small = buddy.allocate(40, 1);
+		std::optional<uint64_t> aligned = buddy.allocate(64, 256);
+		CHECK(small == 0u);
+		CHECK(aligned.has_value() && *aligned % 256 == 0);
+		CHECK(buddy.usedBytes() == 64 + 256);
+
+		// Exhaustion
+		CHECK(!buddy.allocate(2048, 1).has_value());
+		CHECK(buddy.allocate(512, 1) == 512u);
+		CHECK(!buddy.allocate(512, 1).has_value());
+
+		// Freed buddies coalesce back into the whole range.
+		buddy.free(512);
+		buddy.free(*aligned);
+		CHECK(buddy.largestFreeRange() == 512);
+		CHECK(buddy.fragmentation() > 0.0);
+		buddy.free(*small);
+		CHECK(buddy.allocationCount() == 0);
+		CHECK(buddy.largestFreeRange() == 1024);
+		CHECK(buddy.fragmentation() == 0.0);
+		CHECK(buddy.allocate(1024, 1) == 0u);
+	}
+
+	void testPool()
+	{
+		PoolStrategy pool { 1024, 256 };
+
+		// Slots hand out lowest offset first and only take what fits a slot.
+		CHECK(pool.allocate(100, 4) == 0u);
+		CHECK(pool.allocate(256, 256) == 256u);
+		CHECK(!pool.allocate(257, 1).has_value());
+		CHECK(!pool.allocate(16, 512).has_value());
+
+		// Exhaustion
+		CHECK(pool.allocate(1, 1) == 512u);
+		CHECK(pool.allocate(1, 1) == 768u);
+		CHECK(!pool.allocate(1, 1).has_value());
+		CHECK(pool.fragmentation() == 0.0);
+
+		// Scattered free slots are not counted as fragmentation.
+		pool.free(0);
+		pool.free(512);
+		CHECK(pool.largestFreeRange() == 512);
+		CHECK(pool.fragmentation() == 0.0);
+
+		pool.reset();
+		CHECK(pool.allocationCount() == 0);
+		CHECK(pool.largestFreeRange() == 1024);
+	}
+
+	void testGranularity()
+	{
+		// Linear and optimal resources only get blocks of their own when
+		// they could otherwise share a bufferImageGranularity page.
+		CHECK(getBlockKind(ResourceKind::Optimal, 1) == ResourceKind::Linear);
+		CHECK(getBlockKind(ResourceKind::Linear, 1) == ResourceKind::Linear);
+		CHECK(getBlockKind(ResourceKind::Optimal, 1024) == ResourceKind::Optimal);
+		CHECK(getBlockKind(ResourceKind::Linear, 1024) == ResourceKind::Linear);
+
+		CHECK(alignUp(0, 1024) == 0);
+		CHECK(alignUp(1, 1024) == 1024);
+		CHECK(alignUp(1024, 1024) == 1024);
+	}
+}
+
+int main()
+{
+	testLinear();
+	testBuddy();
+	testPool();
+	testGranularity();
+
+	if (failureCount != 0)
+	{
+		std::cerr << failureCount << " allocator checks failed\n";
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "All allocator checks passed\n";
+	return EXIT_SUCCESS;
+}